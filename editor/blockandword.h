@@ -8,6 +8,7 @@ struct word
     QTime timeStamp;
     QString text;
     QStringList tagList;
+    double confidence{-1};  // ASR confidence in [0, 1], negative when unknown
 
     inline bool operator==(word w) const
     {
@@ -24,6 +25,7 @@ struct block
     QString speaker;
     QStringList tagList;
     QVector<word> words;
+    double confidence{-1};
 
     inline bool operator==(block b) const
     {
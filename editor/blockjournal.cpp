@@ -0,0 +1,78 @@
+#include "blockjournal.h"
+
+void BlockJournal::start(int blockCount)
+{
+    m_steps.clear();
+    m_touched.fill(false, blockCount);
+    m_valid = true;
+}
+
+void BlockJournal::invalidate()
+{
+    m_steps.clear();
+    m_touched.clear();
+    m_valid = false;
+}
+
+void BlockJournal::blocksInserted(int at, int count)
+{
+    if (!m_valid || count <= 0)
+        return;
+    if (at < 0 || at > m_touched.size()) {
+        invalidate();
+        return;
+    }
+
+    m_steps.append({true, at, count});
+    m_touched.insert(at, count, true);
+}
+
+void BlockJournal::blocksRemoved(int at, int count)
+{
+    if (!m_valid || count <= 0)
+        return;
+    if (at < 0 || at + count > m_touched.size()) {
+        invalidate();
+        return;
+    }
+
+    m_steps.append({false, at, count});
+    m_touched.remove(at, count);
+}
+
+void BlockJournal::update(int first, int last, const QVector<block>& blocks)
+{
+    if (!m_valid)
+        return;
+    if (m_touched.size() != blocks.size()) {
+        invalidate();
+        return;
+    }
+
+    for (int i = qMax(first, 0); i <= last && i < m_touched.size(); i++)
+        m_touched[i] = true;
+}
+
+bool BlockJournal::replay(BlockObserver& observer, const QVector<block>& blocks) const
+{
+    if (!m_valid || m_touched.size() != blocks.size())
+        return false;
+
+    for (auto& step: m_steps) {
+        if (step.inserted)
+            observer.blocksInserted(step.at, step.count);
+        else
+            observer.blocksRemoved(step.at, step.count);
+    }
+
+    for (int i = 0; i < m_touched.size(); i++) {
+        if (!m_touched[i])
+            continue;
+        int last = i;
+        while (last + 1 < m_touched.size() && m_touched[last + 1])
+            last++;
+        observer.update(i, last, blocks);
+        i = last;
+    }
+    return true;
+}
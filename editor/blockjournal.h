@@ -0,0 +1,34 @@
+#pragma once
+
+#include "blockobserver.h"
+
+// The lines inserted and removed since start(), and the ones rewritten, so a
+// structure built from the blocks as they were then can be brought up to date
+// instead of built again. Any change it doesn't hear of, like new content,
+// has to invalidate() it.
+class BlockJournal : public BlockObserver
+{
+public:
+    void start(int blockCount);
+    void invalidate();
+    bool isValid() const {return m_valid;}
+
+    void blocksInserted(int at, int count) override;
+    void blocksRemoved(int at, int count) override;
+    void update(int first, int last, const QVector<block>& blocks) override;
+
+    // Passes the insertions and removals on in order, then the rewritten
+    // lines as ranges of the current blocks. False when it isn't valid.
+    bool replay(BlockObserver& observer, const QVector<block>& blocks) const;
+
+private:
+    struct Step
+    {
+        bool inserted;
+        int at, count;
+    };
+
+    QVector<Step> m_steps;
+    QVector<bool> m_touched;
+    bool m_valid{false};
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "blockandword.h"
+
+// Anything kept per block beside the editor's blocks. The editor tells every
+// registered observer about each change once, after its block vector has it:
+// lines inserted or removed first, then the range of lines that were
+// rewritten. An observer that isn't built yet ignores all of it.
+class BlockObserver
+{
+public:
+    virtual ~BlockObserver() = default;
+
+    virtual void blocksInserted(int at, int count) = 0;
+    virtual void blocksRemoved(int at, int count) = 0;
+    virtual void update(int first, int last, const QVector<block>& blocks) = 0;
+};
@@ -0,0 +1,130 @@
+#include "blocktimeindex.h"
+
+#include <algorithm>
+
+void BlockTimeIndex::rebuild(const QVector<block>& blocks)
+{
+    m_blocks.clear();
+    m_blocks.resize(blocks.size());
+
+    for (int i = 0; i < blocks.size(); i++) {
+        computeBlock(i, blocks[i]);
+        propagate(i);
+    }
+    m_valid = true;
+}
+
+void BlockTimeIndex::blocksInserted(int at, int count)
+{
+    if (!m_valid || at < 0 || at > m_blocks.size() || count <= 0)
+        return;
+
+    m_blocks.insert(at, count, BlockTimes());
+}
+
+void BlockTimeIndex::blocksRemoved(int at, int count)
+{
+    if (!m_valid || at < 0 || count <= 0 || at + count > m_blocks.size())
+        return;
+
+    m_blocks.remove(at, count);
+}
+
+void BlockTimeIndex::update(int first, int last, const QVector<block>& blocks)
+{
+    if (!m_valid)
+        return;
+    if (m_blocks.size() != blocks.size()) {
+        rebuild(blocks);
+        return;
+    }
+
+    first = qMax(0, first);
+    last = qMin(last, m_blocks.size() - 1);
+
+    for (int i = first; i <= last; i++) {
+        computeBlock(i, blocks[i]);
+        propagate(i);
+    }
+
+    // Later blocks only change while the start or the running maximum does
+    for (int i = last + 1; i < m_blocks.size(); i++)
+        if (!propagate(i))
+            break;
+}
+
+qint64 BlockTimeIndex::wordStart(int blockNumber, int wordNumber) const
+{
+    auto& times = m_blocks[blockNumber];
+
+    // The end of the closest timed word before this one, else the block start
+    for (int i = wordNumber - 1; i >= 0; i--) {
+        if (times.wordEnds[i] != -1)
+            return times.wordEnds[i];
+        if (times.wordEndMax[i] == -1)
+            break;
+    }
+    return times.start;
+}
+
+int BlockTimeIndex::blockAt(qint64 position) const
+{
+    auto it = std::partition_point(m_blocks.begin(), m_blocks.end(),
+                                   [position](const BlockTimes& times) {return times.endMax <= position;});
+
+    return it == m_blocks.end() ? -1 : static_cast<int>(it - m_blocks.begin());
+}
+
+int BlockTimeIndex::wordAt(int blockNumber, qint64 position) const
+{
+    auto& wordEndMax = m_blocks[blockNumber].wordEndMax;
+    auto it = std::partition_point(wordEndMax.begin(), wordEndMax.end(),
+                                   [position](qint64 endMax) {return endMax <= position;});
+
+    return it == wordEndMax.end() ? -1 : static_cast<int>(it - wordEndMax.begin());
+}
+
+qint64 BlockTimeIndex::toPosition(const QTime& time)
+{
+    return time.isValid() ? QTime(0, 0).msecsTo(time) : -1;
+}
+
+QTime BlockTimeIndex::toTime(qint64 position)
+{
+    return QTime(0, 0).addMSecs(static_cast<int>(position));
+}
+
+void BlockTimeIndex::computeBlock(int blockNumber, const block& a_block)
+{
+    auto& times = m_blocks[blockNumber];
+    auto& words = a_block.words;
+
+    times.end = toPosition(a_block.timeStamp);
+    times.wordEnds.resize(words.size());
+    times.wordEndMax.resize(words.size());
+
+    qint64 endMax = -1;
+    for (int i = 0; i < words.size(); i++) {
+        times.wordEnds[i] = toPosition(words[i].timeStamp);
+        endMax = qMax(endMax, times.wordEnds[i]);
+        times.wordEndMax[i] = endMax;
+    }
+}
+
+bool BlockTimeIndex::propagate(int blockNumber)
+{
+    auto& times = m_blocks[blockNumber];
+    qint64 start = 0, endMax = -1;
+
+    if (blockNumber > 0) {
+        auto& previous = m_blocks[blockNumber - 1];
+        start = (previous.end != -1) ? previous.end : previous.start;
+        endMax = previous.endMax;
+    }
+    endMax = qMax(endMax, times.end);
+
+    bool changed = (start != times.start || endMax != times.endMax);
+    times.start = start;
+    times.endMax = endMax;
+    return changed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "blockobserver.h"
+
+#include <QVector>
+
+// Start and end time of every block and word in milliseconds, -1 for a missing
+// end time. Only end times are stored in the transcript, a start is the end of
+// the last timed block (or word) before it, which the table keeps precomputed
+// so jumps don't scan backwards. Running maxima of the end times make the
+// "first block ending after t" lookup a binary search even when some
+// timestamps are missing.
+class BlockTimeIndex : public BlockObserver
+{
+public:
+    void rebuild(const QVector<block>& blocks);
+    // Dropped until the next rebuild, changes in between are ignored
+    void invalidate() {m_blocks.clear(); m_valid = false;}
+    bool isValid() const {return m_valid;}
+
+    void blocksInserted(int at, int count) override;
+    void blocksRemoved(int at, int count) override;
+    void update(int first, int last, const QVector<block>& blocks) override;
+
+    int size() const {return m_blocks.size();}
+    qint64 blockStart(int blockNumber) const {return m_blocks[blockNumber].start;}
+    qint64 blockEnd(int blockNumber) const {return m_blocks[blockNumber].end;}
+    bool hasEnd(int blockNumber) const {return m_blocks[blockNumber].end != -1;}
+
+    int wordCount(int blockNumber) const {return m_blocks[blockNumber].wordEnds.size();}
+    qint64 wordStart(int blockNumber, int wordNumber) const;
+    qint64 wordEnd(int blockNumber, int wordNumber) const {return m_blocks[blockNumber].wordEnds[wordNumber];}
+
+    int blockAt(qint64 position) const;
+    int wordAt(int blockNumber, qint64 position) const;
+
+    static qint64 toPosition(const QTime& time);
+    static QTime toTime(qint64 position);
+
+private:
+    struct BlockTimes
+    {
+        qint64 start{0}, end{-1}, endMax{-1};
+        QVector<qint64> wordEnds, wordEndMax;
+    };
+
+    void computeBlock(int blockNumber, const block& a_block);
+    bool propagate(int blockNumber);
+
+    QVector<BlockTimes> m_blocks;
+    bool m_valid{false};
+};
@@ -0,0 +1,154 @@
+#include "confidencequeue.h"
+
+#include <iterator>
+
+void ConfidenceQueue::rebuild(const QVector<block>& blocks)
+{
+    clear();
+    blocksInserted(0, blocks.size());
+    update(0, blocks.size() - 1, blocks);
+}
+
+void ConfidenceQueue::clear()
+{
+    m_blocks.clear();
+    m_queue.clear();
+    m_rows.clear();
+    m_rowsDirty = true;
+}
+
+void ConfidenceQueue::blocksInserted(int at, int count)
+{
+    if (at < 0 || at > m_blocks.size() || count <= 0)
+        return;
+
+    m_blocks.insert(at, count, BlockConfidence());
+    for (int i = at; i < at + count; i++)
+        m_blocks[i].id = m_nextId++;
+    m_rowsDirty = true;
+}
+
+void ConfidenceQueue::blocksRemoved(int at, int count)
+{
+    if (at < 0 || count <= 0 || at + count > m_blocks.size())
+        return;
+
+    for (int i = at; i < at + count; i++)
+        dequeue(m_blocks[i]);
+    m_blocks.remove(at, count);
+    m_rowsDirty = true;
+}
+
+void ConfidenceQueue::update(int first, int last, const QVector<block>& blocks)
+{
+    if (m_blocks.size() != blocks.size()) {
+        rebuild(blocks);
+        return;
+    }
+
+    for (int i = qMax(first, 0); i <= last && i < blocks.size(); i++) {
+        auto& blockConfidence = m_blocks[i];
+        dequeue(blockConfidence);
+
+        auto& words = blocks[i].words;
+        blockConfidence.words.resize(words.size());
+        for (int j = 0; j < words.size(); j++)
+            blockConfidence.words[j] = confidenceOf(blocks[i], j);
+
+        enqueue(blockConfidence);
+    }
+}
+
+int ConfidenceQueue::count(double threshold) const
+{
+    return int(std::distance(m_queue.begin(), m_queue.lower_bound({float(threshold), 0, 0})));
+}
+
+const QVector<float>& ConfidenceQueue::wordConfidences(int blockNumber) const
+{
+    static const QVector<float> none;
+    if (blockNumber < 0 || blockNumber >= m_blocks.size())
+        return none;
+    return m_blocks[blockNumber].words;
+}
+
+bool ConfidenceQueue::next(int& blockNumber, int& wordNumber, double threshold) const
+{
+    Key key;
+    auto it = queued(blockNumber, wordNumber, threshold, key) ? m_queue.upper_bound(key) : m_queue.begin();
+
+    if (it == m_queue.end() || it->confidence >= float(threshold))
+        return false;
+
+    blockNumber = rowOf(it->id);
+    wordNumber = it->word;
+    return true;
+}
+
+bool ConfidenceQueue::previous(int& blockNumber, int& wordNumber, double threshold) const
+{
+    Key key;
+    if (!queued(blockNumber, wordNumber, threshold, key))
+        key = {float(threshold), 0, 0};
+
+    auto it = m_queue.lower_bound(key);
+    if (it == m_queue.begin())
+        return false;
+    --it;
+
+    blockNumber = rowOf(it->id);
+    wordNumber = it->word;
+    return true;
+}
+
+float ConfidenceQueue::confidenceOf(const block& a_block, int wordNumber)
+{
+    auto confidence = a_block.words[wordNumber].confidence;
+    if (confidence < 0)
+        confidence = a_block.confidence;
+    return confidence < 0 ? -1 : float(confidence);
+}
+
+void ConfidenceQueue::enqueue(const BlockConfidence& blockConfidence)
+{
+    for (int j = 0; j < blockConfidence.words.size(); j++)
+        if (blockConfidence.words[j] >= 0)
+            m_queue.insert({blockConfidence.words[j], blockConfidence.id, j});
+}
+
+void ConfidenceQueue::dequeue(const BlockConfidence& blockConfidence)
+{
+    for (int j = 0; j < blockConfidence.words.size(); j++)
+        if (blockConfidence.words[j] >= 0)
+            m_queue.erase({blockConfidence.words[j], blockConfidence.id, j});
+}
+
+bool ConfidenceQueue::queued(int blockNumber, int wordNumber, double threshold, Key& key) const
+{
+    if (blockNumber < 0 || blockNumber >= m_blocks.size())
+        return false;
+
+    auto& blockConfidence = m_blocks[blockNumber];
+    if (wordNumber < 0 || wordNumber >= blockConfidence.words.size())
+        return false;
+
+    auto confidence = blockConfidence.words[wordNumber];
+    if (confidence < 0 || confidence >= float(threshold))
+        return false;
+
+    key = {confidence, blockConfidence.id, wordNumber};
+    return true;
+}
+
+int ConfidenceQueue::rowOf(quint64 id) const
+{
+    // Only lines added or removed invalidate the rows, typing doesn't
+    if (m_rowsDirty) {
+        m_rows.clear();
+        m_rows.reserve(m_blocks.size());
+        for (int i = 0; i < m_blocks.size(); i++)
+            m_rows.insert(m_blocks[i].id, i);
+        m_rowsDirty = false;
+    }
+    return m_rows.value(id, -1);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "blockobserver.h"
+
+#include <QVector>
+#include <QHash>
+#include <set>
+
+// Words with an ASR confidence, worst first. A word without its own confidence
+// takes the one of its line. Every block keeps a stable key so inserting or
+// removing lines doesn't renumber the queue, and an edit only re-sorts the
+// words of the blocks it touched.
+class ConfidenceQueue : public BlockObserver
+{
+public:
+    void rebuild(const QVector<block>& blocks);
+    void clear();
+
+    void blocksInserted(int at, int count) override;
+    void blocksRemoved(int at, int count) override;
+    void update(int first, int last, const QVector<block>& blocks) override;
+
+    int size() const {return int(m_queue.size());}
+    int count(double threshold) const;
+    // Per word of the block, negative where unknown
+    const QVector<float>& wordConfidences(int blockNumber) const;
+
+    // The queued word after the given one, or the worst one when the given
+    // word isn't below the threshold. False once the threshold is reached.
+    bool next(int& blockNumber, int& wordNumber, double threshold) const;
+    bool previous(int& blockNumber, int& wordNumber, double threshold) const;
+
+    static float confidenceOf(const block& a_block, int wordNumber);
+
+private:
+    struct Key
+    {
+        float confidence;
+        quint64 id;
+        int word;
+
+        bool operator<(const Key& other) const
+        {
+            if (confidence != other.confidence)
+                return confidence < other.confidence;
+            return id != other.id ? id < other.id : word < other.word;
+        }
+    };
+
+    struct BlockConfidence
+    {
+        quint64 id{0};
+        QVector<float> words;
+    };
+
+    void enqueue(const BlockConfidence& blockConfidence);
+    void dequeue(const BlockConfidence& blockConfidence);
+    bool queued(int blockNumber, int wordNumber, double threshold, Key& key) const;
+    int rowOf(quint64 id) const;
+
+    QVector<BlockConfidence> m_blocks;
+    std::set<Key> m_queue;
+    quint64 m_nextId{0};
+    mutable QHash<quint64, int> m_rows;
+    mutable bool m_rowsDirty{true};
+};
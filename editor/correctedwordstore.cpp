@@ -0,0 +1,113 @@
+#include "correctedwordstore.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QLockFile>
+#include <QDebug>
+#include <set>
+
+namespace {
+    const int lockTimeout = 2000;
+}
+
+QString CorrectedWordStore::fileName(const QString& lang)
+{
+    return QString("corrected_words_%1.txt").arg(lang);
+}
+
+QStringList CorrectedWordStore::read(const QString& lang)
+{
+    QLockFile lock(fileName(lang) + ".lock");
+    if (!lock.tryLock(lockTimeout))
+        qWarning() << "[Corrected Words]" << QString("reading %1 without lock").arg(fileName(lang));
+
+    QStringList words;
+
+    QFile file(fileName(lang));
+    if (!file.open(QFile::ReadOnly))
+        return {};
+
+    while (!file.atEnd()) {
+        auto line = file.readLine().trimmed();
+        if (!line.isEmpty())
+            words << QString::fromUtf8(line);
+    }
+
+    return words;
+}
+
+bool CorrectedWordStore::append(const QString& lang, const QStringList& words)
+{
+    if (words.isEmpty())
+        return true;
+
+    QLockFile lock(fileName(lang) + ".lock");
+    if (!lock.tryLock(lockTimeout))
+        return false;
+
+    QFile file(fileName(lang));
+    if (!file.open(QFile::WriteOnly | QFile::Append))
+        return false;
+
+    QByteArray lines;
+    for (auto& a_word: words)
+        lines += a_word.toUtf8() + '\n';
+
+    if (file.write(lines) != lines.size() || !file.flush())
+        return false;
+
+    appendedLanguages().insert(lang);
+    return true;
+}
+
+bool CorrectedWordStore::compact(const QString& lang)
+{
+    QLockFile lock(fileName(lang) + ".lock");
+    if (!lock.tryLock(lockTimeout))
+        return false;
+
+    QFile file(fileName(lang));
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    int lines{0};
+    std::set<QByteArray> words;
+    while (!file.atEnd()) {
+        auto line = file.readLine().trimmed();
+        if (!line.isEmpty()) {
+            words.insert(line);
+            lines++;
+        }
+    }
+    file.close();
+
+    if (lines == int(words.size()))
+        return true;
+
+    QSaveFile compacted(fileName(lang));
+    if (!compacted.open(QFile::WriteOnly))
+        return false;
+
+    for (auto& a_word: words)
+        compacted.write(a_word + '\n');
+
+    if (!compacted.commit())
+        return false;
+
+    qInfo() << "[Corrected Words Compacted]"
+            << QString("language: %1, %2 lines to %3 words").arg(lang, QString::number(lines), QString::number(words.size()));
+    return true;
+}
+
+void CorrectedWordStore::compactAll()
+{
+    for (auto& lang: qAsConst(appendedLanguages()))
+        if (!compact(lang))
+            qWarning() << "[Corrected Words]" << QString("couldn't compact %1").arg(fileName(lang));
+}
+
+QSet<QString>& CorrectedWordStore::appendedLanguages()
+{
+    static QSet<QString> langs;
+    return langs;
+}
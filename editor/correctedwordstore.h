@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QStringList>
+#include <QSet>
+
+// Words users marked correct, one file per language. Accepting a word appends
+// a single line, the file is deduplicated and sorted again on exit. Every
+// access holds a lock file, so several running instances can share the store.
+class CorrectedWordStore
+{
+public:
+    static QString fileName(const QString& lang);
+
+    static QStringList read(const QString& lang);
+    static bool append(const QString& lang, const QString& word) {return append(lang, QStringList{word});}
+    static bool append(const QString& lang, const QStringList& words);
+    static bool compact(const QString& lang);
+
+    // Compacts the files this process appended to
+    static void compactAll();
+
+private:
+    static QSet<QString>& appendedLanguages();
+};
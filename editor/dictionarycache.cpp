@@ -0,0 +1,264 @@
+#include "dictionarycache.h"
+#include "correctedwordstore.h"
+#include "tokenizer.h"
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+    const QString recentLanguagesFileName("recent_languages.txt");
+}
+
+bool Dictionary::contains(const QString& word) const
+{
+    return std::binary_search(words.begin(), words.end(), word);
+}
+
+quint64 Dictionary::hash(const QString& text)
+{
+    quint64 value = 14695981039346656037ULL;
+    for (auto c: text) {
+        value ^= c.unicode();
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+DictionaryCache* DictionaryCache::instance()
+{
+    static DictionaryCache cache;
+    return &cache;
+}
+
+QSharedPointer<const Dictionary> DictionaryCache::dictionary(const QString& lang)
+{
+    if (auto ready = cached(lang))
+        return ready;
+
+    auto self = instance();
+    auto loading = self->m_loading.constFind(lang);
+    auto loaded = (loading != self->m_loading.constEnd()) ? loading.value().result() : load(lang);
+
+    self->insert(lang, loaded);
+    return loaded;
+}
+
+QSharedPointer<const Dictionary> DictionaryCache::cached(const QString& lang)
+{
+    auto self = instance();
+
+    auto it = self->m_dictionaries.constFind(lang);
+    if (it == self->m_dictionaries.constEnd())
+        return {};
+
+    self->m_recentlyUsed.removeOne(lang);
+    self->m_recentlyUsed.prepend(lang);
+    return it.value();
+}
+
+void DictionaryCache::preload(const QString& lang)
+{
+    auto self = instance();
+    if (lang.isEmpty() || self->m_dictionaries.contains(lang) || self->m_loading.contains(lang))
+        return;
+
+    auto watcher = new QFutureWatcher<QSharedPointer<const Dictionary>>(self);
+    connect(watcher, &QFutureWatcherBase::finished, self,
+        [self, watcher, lang]()
+        {
+            watcher->deleteLater();
+
+            // dictionary() may have collected the result already
+            if (self->m_loading.contains(lang))
+                self->insert(lang, watcher->result());
+        }
+    );
+
+    auto future = QtConcurrent::run(&DictionaryCache::load, lang);
+    self->m_loading.insert(lang, future);
+    watcher->setFuture(future);
+}
+
+void DictionaryCache::preloadRecent()
+{
+    auto langs = listFromFile(recentLanguagesFileName);
+    instance()->m_recentlyUsed = langs;
+
+    for (auto& lang: qAsConst(langs))
+        preload(lang);
+}
+
+QSharedPointer<const Dictionary> DictionaryCache::addCorrectedWord(const QString& lang, const QString& word)
+{
+    auto current = dictionary(lang);
+    if (current->contains(word))
+        return current;
+
+    auto updated = QSharedPointer<Dictionary>::create(*current);
+    updated->words.insert(std::upper_bound(updated->words.begin(), updated->words.end(), word), word);
+    updated->correctedWords.insert(word);
+    updated->fingerprint += Dictionary::hash(word);
+
+    instance()->m_dictionaries.insert(lang, updated);
+    return updated;
+}
+
+QStringList DictionaryCache::mergeWords(const QString& lang, QStringList words)
+{
+    auto self = instance();
+
+    for (auto& a_word: words)
+        a_word = Tokenizer::canonical(a_word);
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    words.removeAll(QString());
+
+    // Whatever the store holds was accepted here or by another instance before
+    QStringList stored;
+    for (auto& a_word: CorrectedWordStore::read(lang))
+        stored << Tokenizer::canonical(a_word);
+    std::sort(stored.begin(), stored.end());
+
+    QStringList unstored;
+    for (auto& a_word: qAsConst(words))
+        if (!std::binary_search(stored.begin(), stored.end(), a_word))
+            unstored << a_word;
+
+    // A running load may have read the store before these words reached it.
+    // A language that isn't loaded reads them from the store when it is.
+    if (self->m_loading.contains(lang)) {
+        self->m_mergeAfterLoad[lang] += words;
+        return unstored;
+    }
+
+    auto it = self->m_dictionaries.constFind(lang);
+    if (it == self->m_dictionaries.constEnd())
+        return unstored;
+
+    auto current = it.value();
+    words.erase(std::remove_if(words.begin(), words.end(),
+                               [&current](const QString& a_word) {return current->contains(a_word);}),
+                words.end());
+
+    if (words.isEmpty())
+        return unstored;
+
+    auto updated = QSharedPointer<Dictionary>::create(*current);
+    auto middle = updated->words.size();
+    updated->words += words;
+    std::inplace_merge(updated->words.begin(), updated->words.begin() + middle, updated->words.end());
+    updated->correctedWords.insert(words.begin(), words.end());
+    for (auto& a_word: qAsConst(words))
+        updated->fingerprint += Dictionary::hash(a_word);
+
+    self->m_dictionaries.insert(lang, updated);
+    emit self->wordsAdded(lang, words);
+    return unstored;
+}
+
+void DictionaryCache::trim(const QStringList& inUse)
+{
+    auto self = instance();
+
+    for (int i = self->m_recentlyUsed.size() - 1; i >= 0 && self->m_dictionaries.size() > self->m_capacity; i--) {
+        auto lang = self->m_recentlyUsed[i];
+        if (inUse.contains(lang) || !self->m_dictionaries.remove(lang))
+            continue;
+
+        qInfo() << "[Dictionary Released]" << QString("language: %1").arg(lang);
+    }
+}
+
+void DictionaryCache::insert(const QString& lang, QSharedPointer<const Dictionary> dictionary)
+{
+    m_loading.remove(lang);
+    if (m_dictionaries.contains(lang))
+        return;
+
+    m_dictionaries.insert(lang, dictionary);
+    rememberLanguage(lang);
+    emit dictionaryLoaded(lang);
+
+    if (m_mergeAfterLoad.contains(lang))
+        mergeWords(lang, m_mergeAfterLoad.take(lang));
+}
+
+void DictionaryCache::rememberLanguage(const QString& lang)
+{
+    m_recentlyUsed.removeOne(lang);
+    m_recentlyUsed.prepend(lang);
+
+    QFile recentLanguages(recentLanguagesFileName);
+    if (!recentLanguages.open(QFile::WriteOnly | QFile::Truncate))
+        return;
+
+    for (auto& a_lang: m_recentlyUsed.mid(0, m_capacity))
+        recentLanguages.write(QString(a_lang + "\n").toUtf8());
+}
+
+QSharedPointer<const Dictionary> DictionaryCache::load(const QString& lang)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto loaded = QSharedPointer<Dictionary>::create();
+    loaded->lang = lang;
+    loaded->words = listFromFile(QString(":/wordlists/%1.txt").arg(lang));
+
+    // Word lists come in whatever normalisation form their source used
+    bool changed{false};
+    for (auto& a_word: loaded->words) {
+        auto canonical = Tokenizer::canonical(a_word);
+        if (canonical != a_word) {
+            a_word = canonical;
+            changed = true;
+        }
+    }
+    if (changed) {
+        std::sort(loaded->words.begin(), loaded->words.end());
+        loaded->words.erase(std::unique(loaded->words.begin(), loaded->words.end()), loaded->words.end());
+    }
+
+    QStringList correctedWordsList;
+    for (auto& a_word: CorrectedWordStore::read(lang))
+        correctedWordsList << Tokenizer::canonical(a_word);
+    if (!correctedWordsList.isEmpty()) {
+        std::copy(correctedWordsList.begin(),
+                  correctedWordsList.end(),
+                  std::inserter(loaded->correctedWords, loaded->correctedWords.begin()));
+
+        // Both runs are sorted, one merge instead of an insert per word
+        auto middle = loaded->words.size();
+        std::copy(loaded->correctedWords.begin(), loaded->correctedWords.end(), std::back_inserter(loaded->words));
+        std::inplace_merge(loaded->words.begin(), loaded->words.begin() + middle, loaded->words.end());
+    }
+
+    for (auto& a_word: qAsConst(loaded->words))
+        loaded->fingerprint += Dictionary::hash(a_word);
+
+    qInfo() << "[Dictionary Loaded]"
+            << QString("language: %1, %2 words in %3 ms").arg(lang, QString::number(loaded->words.size()), QString::number(timer.elapsed()));
+
+    return loaded;
+}
+
+QStringList DictionaryCache::listFromFile(const QString& fileName)
+{
+    QStringList words;
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return {};
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.isEmpty())
+            words << QString::fromUtf8(line.trimmed());
+    }
+
+    return words;
+}
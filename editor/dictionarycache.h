@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QFuture>
+#include <QHash>
+#include <set>
+
+// Sorted word list of one language, including the words users marked correct.
+// Words are kept in Tokenizer::canonical() form.
+struct Dictionary
+{
+    QString lang;
+    QStringList words;
+    std::set<QString> correctedWords;
+    // Sum of hash() over the words, the same for the same words in any order
+    // and in any session. Snapshots of dictionary scans are keyed on it.
+    quint64 fingerprint{0};
+
+    bool contains(const QString& word) const;
+    // FNV-1a over the UTF-16 of the text, stable across runs unlike qHash
+    static quint64 hash(const QString& text);
+};
+
+// One immutable dictionary per language, shared by every open transcript of
+// that language. Marking a word correct publishes a new instance instead of
+// changing the shared one, documents pick it up the next time they ask.
+//
+// Word lists are read and merged on a worker thread. A few languages stay
+// cached after their last document closes, and the languages of recently
+// opened transcripts are preloaded at startup.
+class DictionaryCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DictionaryCache* instance();
+
+    // Waits for the dictionary if it isn't cached yet
+    static QSharedPointer<const Dictionary> dictionary(const QString& lang);
+    // Null when the dictionary is still to be loaded
+    static QSharedPointer<const Dictionary> cached(const QString& lang);
+    // Starts loading in the background, dictionaryLoaded() follows
+    static void preload(const QString& lang);
+    static void preloadRecent();
+
+    static QSharedPointer<const Dictionary> addCorrectedWord(const QString& lang, const QString& word);
+    // Merges words accepted elsewhere into the cached dictionary, if any, and
+    // returns the ones the corrected word store doesn't have yet, canonical,
+    // without duplicates or empty ones, for the caller to append
+    static QStringList mergeWords(const QString& lang, QStringList words);
+
+    // Drops the least recently used languages no open document uses while
+    // more than the cache capacity are held
+    static void trim(const QStringList& inUse);
+
+signals:
+    void dictionaryLoaded(const QString& lang);
+    void wordsAdded(const QString& lang, const QStringList& words);
+
+private:
+    DictionaryCache() = default;
+
+    void insert(const QString& lang, QSharedPointer<const Dictionary> dictionary);
+    void rememberLanguage(const QString& lang);
+
+    static QSharedPointer<const Dictionary> load(const QString& lang);
+    static QStringList listFromFile(const QString& fileName);
+
+    QHash<QString, QSharedPointer<const Dictionary>> m_dictionaries;
+    QHash<QString, QFuture<QSharedPointer<const Dictionary>>> m_loading;
+    QHash<QString, QStringList> m_mergeAfterLoad;
+    QStringList m_recentlyUsed;
+    int m_capacity{4};
+};
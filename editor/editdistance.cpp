@@ -0,0 +1,159 @@
+#include "editdistance.h"
+
+#include <QHash>
+#include <QtAlgorithms>
+#include <algorithm>
+
+namespace {
+    const int wordBits = 64;
+
+    // Match masks of the reference, one bit per row for every token in it
+    class PatternMasks
+    {
+    public:
+        explicit PatternMasks(const QVector<int>& pattern)
+            : m_none((pattern.size() + wordBits - 1) / wordBits, 0)
+        {
+            for (int i = 0; i < pattern.size(); i++) {
+                auto& masks = m_masks[pattern[i]];
+                if (masks.isEmpty())
+                    masks = m_none;
+                masks[i / wordBits] |= quint64(1) << (i % wordBits);
+            }
+        }
+
+        const QVector<quint64>& operator[](int token) const
+        {
+            auto masks = m_masks.constFind(token);
+            return masks == m_masks.constEnd() ? m_none : *masks;
+        }
+
+    private:
+        QHash<int, QVector<quint64>> m_masks;
+        QVector<quint64> m_none;
+    };
+
+    // Advances one 64 row block of a column by one hypothesis token. hin is
+    // the horizontal delta coming in above the block, the one at row bit is
+    // returned to go into the next block below.
+    int advance(quint64& pv, quint64& mv, quint64 eq, int hin, int bit)
+    {
+        quint64 hinNegative = hin < 0 ? 1 : 0;
+        auto xv = eq | mv;
+        eq |= hinNegative;
+        auto xh = (((eq & pv) + pv) ^ pv) | eq;
+        auto ph = mv | ~(xh | pv);
+        auto mh = pv & xh;
+        auto hout = int((ph >> bit) & 1) - int((mh >> bit) & 1);
+
+        ph = (ph << 1) | (hin > 0 ? 1 : 0);
+        mh = (mh << 1) | hinNegative;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        return hout;
+    }
+
+    // Every column's vertical deltas, column 0 being the empty hypothesis
+    class DeltaTable
+    {
+    public:
+        DeltaTable(const QVector<int>& reference, const QVector<int>& hypothesis, bool keepColumns)
+            : m_blocks((reference.size() + wordBits - 1) / wordBits),
+              m_pv(m_blocks, ~quint64(0)), m_mv(m_blocks, 0)
+        {
+            PatternMasks masks(reference);
+            auto lastBit = (reference.size() - 1) % wordBits;
+            m_score = reference.size();
+
+            if (keepColumns) {
+                m_columns.reserve((hypothesis.size() + 1) * m_blocks * 2);
+                keepColumn();
+            }
+
+            for (auto token: hypothesis) {
+                auto& eq = masks[token];
+                // The top row counts up, it is the hypothesis against nothing
+                int h = 1;
+                for (int b = 0; b < m_blocks; b++)
+                    h = advance(m_pv[b], m_mv[b], eq[b], h, b == m_blocks - 1 ? lastBit : wordBits - 1);
+                m_score += h;
+
+                if (keepColumns)
+                    keepColumn();
+            }
+        }
+
+        int score() const {return m_score;}
+
+        // D[row][column], the column number plus the deltas down to the row
+        int cell(int row, int column) const
+        {
+            auto deltas = m_columns.constData() + column * m_blocks * 2;
+            int value = column;
+            for (int b = 0; b * wordBits < row; b++) {
+                auto bits = row - b * wordBits;
+                auto mask = bits >= wordBits ? ~quint64(0) : (quint64(1) << bits) - 1;
+                value += int(qPopulationCount(deltas[2 * b] & mask)) - int(qPopulationCount(deltas[2 * b + 1] & mask));
+            }
+            return value;
+        }
+
+    private:
+        void keepColumn()
+        {
+            for (int b = 0; b < m_blocks; b++)
+                m_columns << m_pv[b] << m_mv[b];
+        }
+
+        int m_blocks;
+        QVector<quint64> m_pv, m_mv, m_columns;
+        int m_score;
+    };
+}
+
+int EditDistance::distance(const QVector<int>& reference, const QVector<int>& hypothesis)
+{
+    if (reference.isEmpty() || hypothesis.isEmpty())
+        return qMax(reference.size(), hypothesis.size());
+
+    return DeltaTable(reference, hypothesis, false).score();
+}
+
+QVector<EditDistance::Operation> EditDistance::align(const QVector<int>& reference, const QVector<int>& hypothesis)
+{
+    QVector<Operation> operations;
+    if (reference.isEmpty() || hypothesis.isEmpty()) {
+        operations.fill(reference.isEmpty() ? Insertion : Deletion, qMax(reference.size(), hypothesis.size()));
+        return operations;
+    }
+
+    DeltaTable table(reference, hypothesis, true);
+    operations.reserve(reference.size() + hypothesis.size());
+
+    // Back from the corner, diagonal steps first so substitutions win over
+    // a deletion and an insertion of the same cost
+    int i = reference.size(), j = hypothesis.size();
+    while (i > 0 || j > 0) {
+        auto value = table.cell(i, j);
+        if (i > 0 && j > 0) {
+            auto same = reference[i - 1] == hypothesis[j - 1];
+            if (table.cell(i - 1, j - 1) + (same ? 0 : 1) == value) {
+                operations << (same ? Hit : Substitution);
+                i--;
+                j--;
+                continue;
+            }
+        }
+        if (i > 0 && table.cell(i - 1, j) + 1 == value) {
+            operations << Deletion;
+            i--;
+        }
+        else {
+            operations << Insertion;
+            j--;
+        }
+    }
+
+    std::reverse(operations.begin(), operations.end());
+    return operations;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QVector>
+
+// Levenshtein distance and alignment of two token sequences, bit-parallel
+// after Myers and Hyyrö: a column of the table is kept as vertical deltas,
+// 64 rows to a machine word, and a whole column costs a few word operations
+// per 64 reference tokens. The alignment keeps every column's deltas and
+// walks back through them, so it is meant for sequences of a few thousand.
+class EditDistance
+{
+public:
+    enum Operation : char {Hit, Substitution, Insertion, Deletion};
+
+    static int distance(const QVector<int>& reference, const QVector<int>& hypothesis);
+    // What turns the reference into the hypothesis, in order. Hits and
+    // substitutions take a token from both, deletions only from the
+    // reference and insertions only from the hypothesis.
+    static QVector<Operation> align(const QVector<int>& reference, const QVector<int>& hypothesis);
+};
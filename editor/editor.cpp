@@ -2,7 +2,9 @@
 
 #include <QPainter>
 #include <QTextBlock>
+#include <QPlainTextDocumentLayout>
 #include <QFileDialog>
+#include <QSaveFile>
 #include <QInputDialog>
 #include <QStandardPaths>
 #include <QAbstractItemView>
@@ -10,31 +12,100 @@
 #include <QStringListModel>
 #include <QMessageBox>
 #include <QMenu>
+#include <QLocale>
 #include <algorithm>
+#include <limits>
 #include <QEventLoop>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 #include <QDebug>
 
+namespace {
+    // Words scored only through their line take the line's confidence over
+    // before two lines become one, the merged line keeps the lower one
+    double mergeConfidence(block& first, block& second)
+    {
+        for (auto a_block: {&first, &second})
+            if (a_block->confidence >= 0)
+                for (auto& a_word: a_block->words)
+                    if (a_word.confidence < 0)
+                        a_word.confidence = a_block->confidence;
+
+        if (first.confidence < 0 || second.confidence < 0)
+            return -1;
+        return qMin(first.confidence, second.confidence);
+    }
+}
+
 Editor::Editor(QWidget *parent)
     : TextEditor(parent),
     m_speakerCompleter(makeCompleter()), m_textCompleter(makeCompleter()), m_transliterationCompleter(makeCompleter()),
-    m_dictionary(listFromFile(":/wordlists/english.txt")), m_transcriptLang("english"),
+    m_dictionary(QSharedPointer<Dictionary>::create()), m_transcriptLang("english"),
     timeStampExp(QRegularExpression(R"(\[(\d?\d:)?[0-5]?\d:[0-5]?\d(\.\d\d?\d?)?])")),
     speakerExp(QRegularExpression(R"(\[.*]:)")),
     m_saveTimer(new QTimer(this))
 {
+    // Undo works on the blocks, the document's own history would miss every
+    // change that doesn't come from typing
+    document()->setUndoRedoEnabled(false);
+    m_blockObservers = {&m_timeIndex, &m_oovStatistics, &m_oovJournal, &m_confidenceQueue, &m_diff, &m_wordIndex};
+    connect(this, &Editor::blocksReset, this, [this]() {m_oovJournal.invalidate();});
     connect(this->document(), &QTextDocument::contentsChange, this, &Editor::contentChanged);
     connect(this, &Editor::cursorPositionChanged, this, &Editor::updateWordEditor);
+    connect(this, &Editor::blocksChanged, this,
+        [this]()
+        {
+            m_modified = true;
+            m_blocksRevision++;
+        }
+    );
     connect(this, &Editor::cursorPositionChanged, this,
     [&]()
     {
         if (!m_blocks.isEmpty() && textCursor().blockNumber() < m_blocks.size())
             emit refreshTagList(m_blocks[textCursor().blockNumber()].tagList);
+
+        if (textCursor().blockNumber() != m_cursorBlockNumber) {
+            m_cursorBlockNumber = textCursor().blockNumber();
+            emit currentBlockChanged(m_cursorBlockNumber);
+        }
     });
 
     m_textCompleter->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
+    m_textCompleter->setModel(new QStringListModel(m_textCompleter));
     m_transliterationCompleter->setModel(new QStringListModel);
 
-    loadDictionary();
+    connect(DictionaryCache::instance(), &DictionaryCache::dictionaryLoaded, this,
+        [this](const QString& lang)
+        {
+            if (lang == m_transcriptLang)
+                applyDictionary(DictionaryCache::cached(lang));
+        }
+    );
+    connect(DictionaryCache::instance(), &DictionaryCache::wordsAdded, this,
+        [this](const QString& lang, const QStringList& words)
+        {
+            if (lang != m_transcriptLang || !dictionaryReady())
+                return;
+
+            m_dictionary = DictionaryCache::cached(lang);
+            static_cast<QStringListModel*>(m_textCompleter->model())->setStringList(m_dictionary->words);
+
+            m_oovStatistics.setDictionary(m_dictionary);
+            m_oovStatistics.removeWords(words);
+            emit oovStatisticsChanged();
+
+            if (!m_highlighter)
+                return;
+
+            QVector<QPair<int, int>> positions;
+            for (auto& a_word: words)
+                positions += wordPositions(a_word);
+            std::sort(positions.begin(), positions.end());
+            m_highlighter->rehighlightWords(positions);
+        }
+    );
 
     connect(m_speakerCompleter, QOverload<const QString &>::of(&QCompleter::activated),
             this, &Editor::insertSpeakerCompletion);
@@ -53,6 +124,120 @@ Editor::Editor(QWidget *parent)
     m_blocks.append(fromEditor(0));
 }
 
+const BlockTimeIndex& Editor::timeIndex() const
+{
+    if (!m_timeIndex.isValid())
+        m_timeIndex.rebuild(m_blocks);
+    return m_timeIndex;
+}
+
+bool Editor::blockSpan(int blockNumber, qint64& start, qint64& end) const
+{
+    auto& index = timeIndex();
+    if (blockNumber < 0 || blockNumber >= index.size() || !index.hasEnd(blockNumber))
+        return false;
+
+    start = index.blockStart(blockNumber);
+    end = index.blockEnd(blockNumber);
+    return end > start;
+}
+
+TranscriptState Editor::createState()
+{
+    TranscriptState state;
+
+    state.document = new QTextDocument(this);
+    state.document->setDocumentLayout(new QPlainTextDocumentLayout(state.document));
+    state.document->setDefaultFont(document()->defaultFont());
+    state.document->setUndoRedoEnabled(false);
+    state.blocks.append({QTime(), "", "", QStringList(), {makeWord(QTime(), "", QStringList())}});
+    state.dictionary = DictionaryCache::cached(state.transcriptLang);
+
+    return state;
+}
+
+TranscriptState Editor::takeState()
+{
+    TranscriptState state;
+
+    // setDocument() deletes a document still owned by the text control
+    state.document = document();
+    state.document->setParent(this);
+
+    state.highlighter = m_highlighter;
+    state.blocks = m_blocks;
+    state.timeIndex = m_timeIndex;
+    state.oovStatistics = m_oovStatistics;
+    state.confidenceQueue = m_confidenceQueue;
+    state.diff = m_diff;
+    state.wordIndex = m_wordIndex;
+    state.history = m_history;
+    state.modified = m_modified;
+    state.transcriptUrl = m_transcriptUrl;
+    state.transcriptLang = m_transcriptLang;
+    state.dictionary = m_dictionary;
+    state.highlightedBlock = highlightedBlock;
+    state.highlightedWord = highlightedWord;
+    state.cursorPosition = textCursor().position();
+
+    return state;
+}
+
+void Editor::restoreState(TranscriptState state)
+{
+    disconnect(document(), &QTextDocument::contentsChange, this, &Editor::contentChanged);
+
+    m_blocks = std::move(state.blocks);
+    m_timeIndex = std::move(state.timeIndex);
+    m_oovStatistics = std::move(state.oovStatistics);
+    m_confidenceQueue = std::move(state.confidenceQueue);
+    m_diff = std::move(state.diff);
+    m_wordIndex = std::move(state.wordIndex);
+    m_history = std::move(state.history);
+    m_history.setMemoryLimit(m_undoMemoryLimit);
+    m_transcriptUrl = state.transcriptUrl;
+    m_transcriptLang = state.transcriptLang;
+    if (m_tokenizer.lang() != m_transcriptLang)
+        m_tokenizer = Tokenizer(m_transcriptLang);
+    m_highlighter = state.highlighter;
+    highlightedBlock = state.highlightedBlock;
+    highlightedWord = state.highlightedWord;
+    m_cursorBlockNumber = -1;
+
+    // Changes may have been turned on or off while another tab was shown
+    if (m_showChanges != m_diff.isActive()) {
+        compareWithBaseline();
+        if (m_highlighter)
+            m_highlighter->rehighlight();
+    }
+
+    state.document->setDefaultFont(document()->defaultFont());
+    dontUpdateWordEditor = true;
+    setDocument(state.document);
+    connect(document(), &QTextDocument::contentsChange, this, &Editor::contentChanged);
+
+    QTextCursor cursor(document());
+    cursor.setPosition(qMin(state.cursorPosition, document()->characterCount() - 1));
+    setTextCursor(cursor);
+    centerCursor();
+    dontUpdateWordEditor = false;
+
+    updateWordEditor();
+    emit blocksReset();
+    emit blocksChanged();
+    emit oovStatisticsChanged();
+
+    // Another document of the same language may have published new words.
+    // After the reset, so a rescan it starts isn't taken for stale.
+    m_dictionary = state.dictionary ? state.dictionary : QSharedPointer<Dictionary>::create();
+    if (m_dictionary != DictionaryCache::cached(m_transcriptLang))
+        loadDictionary();
+    else
+        static_cast<QStringListModel*>(m_textCompleter->model())->setStringList(m_dictionary->words);
+    m_modified = state.modified;
+    emit transcriptChanged(m_transcriptUrl);
+}
+
 void Editor::setEditorFont(const QFont& font)
 {
     document()->setDefaultFont(font);
@@ -66,39 +251,30 @@ void Editor::setEditorFont(const QFont& font)
 
 void Highlighter::highlightBlock(const QString& text)
 {
-    if (invalidBlockNumbers.contains(currentBlock().blockNumber())) {
+    int blockNumber = currentBlock().blockNumber();
+    if (transcriptBlocks && blockNumber < transcriptBlocks->size() && transcriptBlocks->at(blockNumber).timeStamp.isNull()) {
         QTextCharFormat format;
         format.setForeground(Qt::red);
         setFormat(0, text.size(), format);
         return;
     }
-    if (invalidWords.contains(currentBlock().blockNumber())) {
-        auto invalidWordNumbers = invalidWords.values(currentBlock().blockNumber());
-        auto speakerEnd = 0;
-        auto speakerMatch = QRegularExpression(R"(\[.*]:)").match(text);
-        if (speakerMatch.hasMatch())
-            speakerEnd = speakerMatch.capturedEnd();
 
-        auto words = text.mid(speakerEnd + 1).split(" ");
-        int start = speakerEnd;
+    // Every layer below marks words, the line is split into them once
+    auto spans = Editor::wordSpans(text);
+
+    if (oov && !oov->invalidWords(blockNumber).isEmpty()) {
+        auto& invalidWordNumbers = oov->invalidWords(blockNumber);
 
         QTextCharFormat format;
         format.setFontUnderline(true);
         format.setUnderlineColor(Qt::red);
         format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
 
-        for (int i = 0; i < words.size() - 1; i++) {
-            if (!invalidWordNumbers.contains(i))
-                continue;
-            for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-            int count = words[i].size();
-            setFormat(start + 1, count, format);
-            start = speakerEnd;
-        }
+        for (auto wordNumber: invalidWordNumbers)
+            if (wordNumber < spans.size())
+                setFormat(spans[wordNumber].start, spans[wordNumber].length, format);
     }
-    if (blockToHighlight == -1)
-        return;
-    else if (currentBlock().blockNumber() == blockToHighlight) {
+    if (blockToHighlight != -1 && blockNumber == blockToHighlight) {
         int speakerEnd = 0;
         auto speakerMatch = QRegularExpression(R"(\[.*]:)").match(text);
         if (speakerMatch.hasMatch())
@@ -117,18 +293,68 @@ void Highlighter::highlightBlock(const QString& text)
         format.setForeground(Qt::red);
         setFormat(timeStampStart, text.size(), format);
 
-        auto words = text.mid(speakerEnd + 1).split(" ");
-
-        if (wordToHighlight != -1 && wordToHighlight < words.size()) {
-            int start = speakerEnd;
-            for (int i=0; i < wordToHighlight; i++) start += (words[i].size() + 1);
-            int count = words[wordToHighlight].size();
-
+        if (wordToHighlight != -1 && wordToHighlight < spans.size()) {
             format.setFontUnderline(true);
             format.setUnderlineColor(Qt::green);
             format.setUnderlineStyle(QTextCharFormat::DashUnderline);
             format.setForeground(Qt::green);
-            setFormat(start + 1, count, format);
+            setFormat(spans[wordToHighlight].start, spans[wordToHighlight].length, format);
+        }
+    }
+    if (confidenceQueue && confidenceThreshold > 0) {
+        auto& confidences = confidenceQueue->wordConfidences(blockNumber);
+
+        // Drawn under the other layers, the lower the confidence the darker
+        for (int i = 0; i < spans.size() && i < confidences.size(); i++) {
+            if (confidences[i] < 0 || confidences[i] >= confidenceThreshold)
+                continue;
+
+            auto strength = 1 - confidences[i] / confidenceThreshold;
+            QColor shade(255, 140, 0, 40 + int(strength * 120));
+            for (int j = spans[i].start; j < spans[i].end(); j++) {
+                auto format = QSyntaxHighlighter::format(j);
+                format.setBackground(shade);
+                setFormat(j, 1, format);
+            }
+        }
+    }
+    if (diff) {
+        auto& changes = diff->changes(blockNumber);
+
+        // Over the other layers. Deleted words leave a mark in the gap they
+        // were in, the space before the next word or after the last one.
+        for (auto& change: changes) {
+            if (change.word >= spans.size())
+                continue;
+
+            int start, end;
+            QColor color;
+            if (change.kind == TranscriptDiff::Change::Deleted) {
+                if (change.word < 0)
+                    start = Editor::wordRange(text).start;
+                else
+                    start = change.atEnd ? spans[change.word].end() : spans[change.word].start - 1;
+                start = qBound(0, start, qMax(text.size() - 1, 0));
+                end = qMin(start + 1, text.size());
+                color = QColor(220, 0, 0, 160);
+            }
+            else if (change.word >= 0) {
+                start = spans[change.word].start;
+                end = spans[change.word].end();
+                color = change.kind == TranscriptDiff::Change::Inserted ? QColor(0, 170, 0, 60) : QColor(0, 110, 255, 60);
+            }
+            else
+                continue;
+
+            for (int j = start; j < end; j++) {
+                auto format = QSyntaxHighlighter::format(j);
+                format.setBackground(color);
+                if (change.kind != TranscriptDiff::Change::Deleted) {
+                    format.setFontUnderline(true);
+                    format.setUnderlineColor(QColor(color.rgb()));
+                }
+                setFormat(j, 1, format);
+            }
         }
     }
 }
@@ -142,6 +368,15 @@ void Editor::mousePressEvent(QMouseEvent *e)
 
 void Editor::keyPressEvent(QKeyEvent *event)
 {
+    if (event->matches(QKeySequence::Undo)) {
+        undoChange();
+        return;
+    }
+    else if (event->matches(QKeySequence::Redo)) {
+        redoChange();
+        return;
+    }
+
     if (event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_R)
         createChangeSpeakerDialog();
     else if (event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_T)
@@ -206,12 +441,12 @@ void Editor::keyPressEvent(QKeyEvent *event)
         m_speakerCompleter->setModel(new QStringListModel(speakers, m_speakerCompleter));
     }
     else {
-        if (m_blocks[textCursor().blockNumber()].timeStamp.isValid()
-                && textTillCursor.count(" ") == blockText.count(" "))
-            return;
-
-        int index = textTillCursor.count(" ");
-        completionPrefix = blockText.split(" ")[index];
+        // Nothing to complete in the timestamp or between words
+        auto wordNumber = wordNumberAt(blockText, textCursor().positionInBlock());
+        if (wordNumber >= 0) {
+            auto span = wordSpans(blockText)[wordNumber];
+            completionPrefix = blockText.mid(span.start, span.length);
+        }
 
         if (completionPrefix.isEmpty()){
             m_textCompleter->popup()->hide();
@@ -268,29 +503,42 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
 {
     QMenu *menu = createStandardContextMenu();
 
-    QString blockText = textCursor().block().text();
-    QString textTillCursor = blockText.left(textCursor().positionInBlock());
-
-    const bool containsSpeakerBraces = blockText.leftRef(blockText.indexOf(" ")).contains("]:");
-    const bool containsTimeStamp = blockText.trimmed() != "" && blockText.trimmed().back() == ']';
-    bool isAWordUnderCursor = false;
-    int wordNumber;
-
-    if ((containsSpeakerBraces && textTillCursor.count(" ") > 0) || !containsSpeakerBraces) {
-        if (m_blocks.size() > textCursor().blockNumber() &&
-                !(containsTimeStamp && textTillCursor.count(" ") == blockText.count(" "))) {
-            isAWordUnderCursor = true;
-
-            if (containsSpeakerBraces) {
-                auto textWithoutSpeaker = textTillCursor.split("]:").last();
-                wordNumber = textWithoutSpeaker.trimmed().count(" ");
+    auto blockNumber = textCursor().blockNumber();
+    auto blockText = textCursor().block().text();
+    int wordNumber = wordNumberAt(blockText, textCursor().positionInBlock());
+
+    if (blockNumber < m_blocks.size() && wordNumber >= 0 && wordNumber < m_blocks[blockNumber].words.size()) {
+        auto span = wordSpans(blockText)[wordNumber];
+        auto wordText = m_tokenizer.normalized(blockText.mid(span.start, span.length));
+
+        if (dictionaryReady() && !wordText.isEmpty() && !m_dictionary->contains(wordText)) {
+            QList<QAction*> suggestionActions;
+
+            if (auto suggester = SpellSuggester::forDictionary(m_dictionary)) {
+                for (auto& suggestion: suggester->suggestions(wordText)) {
+                    auto suggestionAction = new QAction(suggestion, menu);
+                    connect(suggestionAction, &QAction::triggered, this,
+                            [this, blockNumber, wordNumber, suggestion]()
+                            {
+                                replaceWord(blockNumber, wordNumber, suggestion);
+                    });
+                    suggestionActions << suggestionAction;
+                }
+                if (suggestionActions.isEmpty()) {
+                    suggestionActions << new QAction("No Suggestions", menu);
+                    suggestionActions.first()->setEnabled(false);
+                }
             }
-            else
-                wordNumber = textTillCursor.trimmed().count(" ");
+            else {
+                suggestionActions << new QAction("Preparing Suggestions...", menu);
+                suggestionActions.first()->setEnabled(false);
+            }
+
+            auto firstAction = menu->actions().isEmpty() ? nullptr : menu->actions().first();
+            menu->insertActions(firstAction, suggestionActions);
+            menu->insertSeparator(firstAction);
         }
-    }
 
-    if (isAWordUnderCursor) {
         auto markAsCorrectAction = new QAction;
         markAsCorrectAction->setText("Mark As Correct");
 
@@ -314,34 +562,110 @@ void Editor::transcriptOpen()
     fileDialog.setWindowTitle(tr("Open File"));
     fileDialog.setDirectory(QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).value(0, QDir::homePath()));
 
-    if (fileDialog.exec() == QDialog::Accepted) {
-        QUrl *fileUrl = new QUrl(fileDialog.selectedUrls().constFirst());
-        m_transcriptUrl = *fileUrl;
-        QFile transcriptFile(fileUrl->toLocalFile());
+    if (fileDialog.exec() == QDialog::Accepted)
+        openTranscript(fileDialog.selectedUrls().constFirst());
+}
 
-        if (!transcriptFile.open(QIODevice::ReadOnly)) {
-            emit message(transcriptFile.errorString());
-            return;
-        }
+void Editor::openTranscript(const QUrl& fileUrl)
+{
+    openTranscript(fileUrl, readTranscript(fileUrl.toLocalFile()));
+}
 
-        m_saveTimer->stop();
+LoadedTranscript Editor::readTranscript(const QString& fileName)
+{
+    LoadedTranscript loaded;
+    QFile transcriptFile(fileName);
+    if (!transcriptFile.open(QIODevice::ReadOnly)) {
+        loaded.error = transcriptFile.errorString();
+        return loaded;
+    }
+    loaded.opened = true;
 
-        loadTranscriptData(transcriptFile);
+    loaded.importer = TranscriptImporter::importerFor(fileName);
+    loaded.cached = !loaded.importer && TranscriptCache::load(fileName, loaded.snapshot);
+    if (loaded.cached) {
+        qInfo() << "[Transcript Cache]" << QString("%1 lines from the cache").arg(QString::number(loaded.snapshot.transcript.blocks.size()));
+        return loaded;
+    }
 
-        if (m_transcriptLang == "")
-            m_transcriptLang = "english";
+    QElapsedTimer timer;
+    timer.start();
 
-        loadDictionary(); 
+    auto& transcript = loaded.snapshot.transcript;
+    if (!loaded.importer)
+        transcript = TranscriptReader::read(transcriptFile);
+    else if (!TranscriptImporter::read(transcriptFile, *loaded.importer, transcript))
+        loaded.error = transcriptFile.errorString();
 
-        setContent();
+    qInfo() << (loaded.importer ? "[Transcript Imported]" : "[Transcript Parsed]")
+            << QString("%1 lines in %2 ms").arg(QString::number(transcript.blocks.size()), QString::number(timer.elapsed()));
+    return loaded;
+}
 
-        if (m_transcriptLang != "")
-            emit message("Opened transcript " + fileUrl->fileName() + " Language: " + m_transcriptLang);
-        else
-            emit message("Opened transcript " + fileUrl->fileName());
+void Editor::openTranscript(const QUrl& fileUrl, const LoadedTranscript& loaded)
+{
+    m_transcriptUrl = fileUrl;
 
-        m_saveTimer->start(m_saveInterval * 1000);
+    if (!loaded.opened) {
+        emit message(loaded.error);
+        return;
+    }
+    if (!loaded.error.isEmpty())
+        emit message(loaded.error);
+
+    m_saveTimer->stop();
+
+    // Imports are saved as transcript XML beside them, never over the original
+    auto importer = loaded.importer;
+    if (importer) {
+        auto fileName = fileUrl.toLocalFile();
+        auto xmlFileName = QFileInfo(fileName).absolutePath() + "/"
+                + TranscriptExporter::recordingName(fileName) + ".xml";
+        m_transcriptUrl = QFileInfo::exists(xmlFileName) ? QUrl() : QUrl::fromLocalFile(xmlFileName);
     }
+
+    auto& snapshot = loaded.snapshot;
+    auto cached = loaded.cached;
+    m_transcriptLang = snapshot.transcript.lang;
+    m_blocks = snapshot.transcript.blocks;
+
+    if (m_transcriptLang == "")
+        m_transcriptLang = "english";
+
+    // Shared with the blocks until they are edited
+    m_diff.setBaseline(TranscriptData{m_transcriptLang, m_blocks}, m_transcriptUrl.toLocalFile());
+
+    // The snapshot's scan stands in for one with the dictionary it was made
+    // with. Taken before the content goes in, the highlighter starts with it,
+    // a rescan only starts once the content is there.
+    m_oovStatistics.clear();
+    m_cachedInvalidWords = cached ? snapshot.invalidWords : QVector<QVector<int>>();
+    m_cachedDictionaryKey = snapshot.dictionaryKey;
+    m_cachedScanRevision = m_blocksRevision;
+    m_openingTranscript = true;
+    loadDictionary();
+    restoreCachedScan();
+
+    setContent();
+    m_openingTranscript = false;
+    m_cachedScanRevision = m_blocksRevision;
+    if (!m_oovStatistics.isBuilt())
+        rescanInvalidWords();
+    m_history.clear();
+    m_modified = importer != nullptr;
+
+    if (importer)
+        emit message("Imported " + importer->name + " " + fileUrl.fileName() + ", save to keep it as a transcript");
+    else if (m_transcriptLang != "")
+        emit message("Opened transcript " + fileUrl.fileName() + " Language: " + m_transcriptLang);
+    else
+        emit message("Opened transcript " + fileUrl.fileName());
+
+    emit transcriptChanged(m_transcriptUrl);
+    m_saveTimer->start(m_saveInterval * 1000);
+
+    if (!cached && !importer)
+        storeSnapshot();
 }
 
 void Editor::transcriptSave()
@@ -349,13 +673,17 @@ void Editor::transcriptSave()
     if (m_transcriptUrl.isEmpty())
         transcriptSaveAs();
     else {
-        auto *file = new QFile(m_transcriptUrl.toLocalFile());
-        if (!file->open(QIODevice::WriteOnly | QFile::Truncate)) {
-            emit message(file->errorString());
+        // What was loaded is kept beside the file before it is first overwritten
+        QString error;
+        if (!m_diff.saveBaseline(error))
+            emit message("Baseline not saved: " + error);
+
+        if (!saveXml(m_transcriptUrl.toLocalFile()))
             return;
-        }
-        saveXml(file);
+        storeSnapshot();
+        m_modified = false;
         emit message("File Saved " + m_transcriptUrl.toLocalFile());
+        emit transcriptChanged(m_transcriptUrl);
     }
 }
 
@@ -370,13 +698,15 @@ void Editor::transcriptSaveAs()
         auto fileUrl = QUrl(fileDialog.selectedUrls().constFirst());
 
         if (!document()->isEmpty()) {
-            auto *file = new QFile(fileUrl.toLocalFile());
-            if (!file->open(QIODevice::WriteOnly)) {
-                emit message(file->errorString());
+            if (!saveXml(fileUrl.toLocalFile()))
                 return;
-            }
-            saveXml(file);
-            emit message("File Saved " + fileUrl.toLocalFile());
+
+            // Saved the same way as transcriptSave(), later saves go to the new file
+            m_transcriptUrl = fileUrl;
+            storeSnapshot();
+            m_modified = false;
+            emit message("File Saved " + m_transcriptUrl.toLocalFile());
+            emit transcriptChanged(m_transcriptUrl);
         }
     }
 }
@@ -392,10 +722,179 @@ void Editor::transcriptClose()
     emit message("Closing file " + m_transcriptUrl.toLocalFile());
     m_transcriptUrl.clear();
     m_blocks.clear();
+    m_oovStatistics.clear();
+    m_confidenceQueue.clear();
+    m_diff = TranscriptDiff();
+    m_wordIndex.clear();
     m_transcriptLang = "english";
     
-    loadDictionary();
     clear();
+    m_history.clear();
+    m_timeIndex.invalidate();
+    emit blocksReset();
+    emit blocksChanged();
+    emit oovStatisticsChanged();
+    loadDictionary();
+    m_modified = false;
+    emit transcriptChanged(m_transcriptUrl);
+}
+
+void Editor::exportTranscript()
+{
+    if (m_blocks.isEmpty()) {
+        emit message("Nothing to export");
+        return;
+    }
+
+    QStringList nameFilters;
+    for (int i = 0; i < TranscriptExporter::formatNames().size(); i++)
+        nameFilters << TranscriptExporter::nameFilter(TranscriptExporter::Format(i));
+
+    QFileDialog fileDialog(this);
+    fileDialog.setAcceptMode(QFileDialog::AcceptSave);
+    fileDialog.setWindowTitle(tr("Export Transcript"));
+    fileDialog.setNameFilters(nameFilters);
+    fileDialog.setDirectory(QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).value(0, QDir::homePath()));
+    if (!m_transcriptUrl.isEmpty())
+        fileDialog.selectFile(TranscriptExporter::recordingName(m_transcriptUrl.toLocalFile()));
+
+    if (fileDialog.exec() != QDialog::Accepted)
+        return;
+
+    auto format = TranscriptExporter::Format(qMax(0, nameFilters.indexOf(fileDialog.selectedNameFilter())));
+    auto fileName = fileDialog.selectedFiles().constFirst();
+    if (QFileInfo(fileName).suffix().isEmpty())
+        fileName += "." + TranscriptExporter::suffix(format);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    if (!TranscriptExporter::exportFile(fileName, format, m_blocks, m_subtitleOptions, &error)) {
+        emit message(error);
+        return;
+    }
+
+    qInfo() << "[Transcript Exported]" << QString("%1 in %2 ms").arg(fileName, QString::number(timer.elapsed()));
+    emit message("File Exported " + fileName);
+}
+
+void Editor::exportTranscripts()
+{
+    QFileDialog fileDialog(this);
+    fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
+    fileDialog.setFileMode(QFileDialog::ExistingFiles);
+    fileDialog.setWindowTitle(tr("Export Transcripts"));
+    fileDialog.setDirectory(QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).value(0, QDir::homePath()));
+
+    if (fileDialog.exec() != QDialog::Accepted)
+        return;
+    auto fileNames = fileDialog.selectedFiles();
+
+    bool ok{false};
+    auto formatName = QInputDialog::getItem(this, tr("Export Transcripts"), tr("Format:"),
+                                            TranscriptExporter::formatNames(), 0, false, &ok);
+    TranscriptExporter::Format format;
+    if (!ok || !TranscriptExporter::formatOf(formatName, format))
+        return;
+
+    auto outputDirectory = QFileDialog::getExistingDirectory(this, tr("Export To"), QFileInfo(fileNames.constFirst()).absolutePath());
+    if (outputDirectory.isEmpty())
+        return;
+
+    emit message(QString("Exporting %1 transcripts...").arg(fileNames.size()), 0);
+
+    auto timer = QSharedPointer<QElapsedTimer>::create();
+    timer->start();
+    auto watcher = new QFutureWatcher<QStringList>(this);
+
+    connect(watcher, &QFutureWatcherBase::finished, this,
+        [this, watcher, timer, fileNames]()
+        {
+            watcher->deleteLater();
+            auto errors = watcher->result();
+
+            for (auto& error: qAsConst(errors))
+                qInfo() << "[Transcript Exported]" << error;
+            qInfo() << "[Transcript Exported]"
+                    << QString("%1 of %2 files in %3 ms").arg(QString::number(fileNames.size() - errors.size()),
+                                                              QString::number(fileNames.size()),
+                                                              QString::number(timer->elapsed()));
+
+            if (errors.isEmpty())
+                emit message(QString("Exported %1 transcripts").arg(fileNames.size()));
+            else
+                emit message(QString("%1 of %2 transcripts failed: %3").arg(QString::number(errors.size()),
+                                                                            QString::number(fileNames.size()),
+                                                                            errors.constFirst()));
+        }
+    );
+    watcher->setFuture(QtConcurrent::run(&TranscriptExporter::exportFiles, fileNames, format, outputDirectory, m_subtitleOptions));
+}
+
+void Editor::scoreAgainstHypothesis()
+{
+    if (m_blocks.isEmpty()) {
+        emit message("Nothing to score");
+        return;
+    }
+
+    QFileDialog fileDialog(this);
+    fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
+    fileDialog.setWindowTitle(tr("Score Against ASR Output"));
+    fileDialog.setDirectory(m_transcriptUrl.isEmpty()
+                            ? QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).value(0, QDir::homePath())
+                            : QFileInfo(m_transcriptUrl.toLocalFile()).absolutePath());
+
+    if (fileDialog.exec() != QDialog::Accepted)
+        return;
+    auto hypothesisFileName = fileDialog.selectedFiles().constFirst();
+
+    emit message("Scoring against " + hypothesisFileName + "...", 0);
+
+    auto timer = QSharedPointer<QElapsedTimer>::create();
+    timer->start();
+    auto watcher = new QFutureWatcher<ScoreReport>(this);
+
+    connect(watcher, &QFutureWatcherBase::finished, this,
+        [this, watcher, timer]()
+        {
+            watcher->deleteLater();
+            auto report = watcher->result();
+            if (!report.error.isEmpty()) {
+                emit message(report.error);
+                return;
+            }
+
+            auto summary = QString("WER %1%, CER %2% over %3 words")
+                    .arg(QString::number(report.overall.wer() * 100, 'f', 2),
+                         QString::number(report.overall.cer() * 100, 'f', 2),
+                         QString::number(report.overall.words));
+            qInfo() << "[Transcript Scored]" << QString("%1 in %2 ms").arg(summary, QString::number(timer->elapsed()));
+            emit message(summary);
+
+            QMessageBox box(QMessageBox::Information, tr("Score Against ASR Output"), summary, QMessageBox::Ok, this);
+            box.setInformativeText(report.hypothesis);
+            box.setDetailedText(TranscriptScorer::table(report));
+            box.exec();
+        }
+    );
+
+    // The edited transcript is the reference, the blocks are shared until edited
+    auto reference = m_blocks;
+    auto lang = m_transcriptLang;
+    watcher->setFuture(QtConcurrent::run([reference, lang, hypothesisFileName]() {
+        ScoreReport report;
+        TranscriptData hypothesis;
+        if (!TranscriptImporter::readFile(hypothesisFileName, hypothesis, report.error)) {
+            report.error = hypothesisFileName + ": " + report.error;
+            return report;
+        }
+
+        report = TranscriptScorer::score(reference, hypothesis.blocks, lang);
+        report.hypothesis = hypothesisFileName;
+        return report;
+    }));
 }
 
 void Editor::showBlocksFromData()
@@ -410,34 +909,21 @@ void Editor::showBlocksFromData()
 
 void Editor::highlightTranscript(const QTime& elapsedTime)
 {
-    int blockToHighlight = -1;
-    int wordToHighlight = -1;
-
-    if (!m_blocks.isEmpty()) {
-        for (int i=0; i < m_blocks.size(); i++) {
-            if (m_blocks[i].timeStamp > elapsedTime) {
-                blockToHighlight = i;
-                break;
-            }
-        }
-    }
+    auto& index = timeIndex();
+    auto position = BlockTimeIndex::toPosition(elapsedTime);
+    int blockToHighlight = index.blockAt(position);
 
     if (blockToHighlight != highlightedBlock) {
         highlightedBlock = blockToHighlight;
         if (!m_highlighter)
-            m_highlighter = new Highlighter(document());
+            createHighlighter();
         m_highlighter->setBlockToHighlight(blockToHighlight);
     }
 
     if (blockToHighlight == -1)
         return;
 
-    for (int i = 0; i < m_blocks[blockToHighlight].words.size(); i++) {
-        if (m_blocks[blockToHighlight].words[i].timeStamp > elapsedTime) {
-            wordToHighlight = i;
-            break;
-        }
-    }
+    int wordToHighlight = index.wordAt(blockToHighlight, position);
 
     if (wordToHighlight != highlightedWord) {
         highlightedWord = wordToHighlight;
@@ -447,14 +933,7 @@ void Editor::highlightTranscript(const QTime& elapsedTime)
 
 QTime Editor::getTime(const QString& text)
 {
-    if (text.contains(".")) {
-        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s.z");
-        return QTime::fromString(text, "m:s.z");
-    }
-    else {
-        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s");
-        return QTime::fromString(text, "m:s");
-    }
+    return TranscriptReader::getTime(text);
 }
 
 word Editor::makeWord(const QTime& t, const QString& s, const QStringList& tagList)
@@ -478,276 +957,522 @@ block Editor::fromEditor(qint64 blockNumber) const
 {
     QTime timeStamp;
     QVector<word> words;
-    QString text, speaker, blockText(document()->findBlockByNumber(blockNumber).text());
+    QString speaker, blockText(document()->findBlockByNumber(blockNumber).text());
 
     QRegularExpressionMatch match = timeStampExp.match(blockText);
-    if (match.hasMatch()) {
+    if (match.hasMatch() && blockText.mid(match.capturedEnd()).trimmed() == "") {
+        // Get timestamp for string after removing the enclosing []
         QString matchedTimeStampString = match.captured();
-        if (blockText.mid(match.capturedEnd()).trimmed() == "") {
-            // Get timestamp for string after removing the enclosing []
-            timeStamp = getTime(matchedTimeStampString.mid(1,matchedTimeStampString.size() - 2));
-            text = blockText.split(matchedTimeStampString)[0];
-        }
+        timeStamp = getTime(matchedTimeStampString.mid(1,matchedTimeStampString.size() - 2));
     }
 
     match = speakerExp.match(blockText);
     if (match.hasMatch()) {
         speaker = match.captured();
-        if (text != "")
-            text = text.split(speaker)[1];
         speaker = speaker.left(speaker.size() - 2);
         speaker = speaker.right(speaker.size() - 1);
     }
 
-    if (text == "")
-        text = blockText.trimmed();
-    else
-        text = text.trimmed();
+    auto range = wordRange(blockText);
+    auto text = blockText.mid(range.start, range.length).trimmed();
+
+    auto list = Tokenizer::words(text);
+    for (auto& m_word: qAsConst(list)) {
+        words.append(makeWord(QTime(), m_word, QStringList()));
+    }
+    // An empty line still has its one empty word
+    if (words.isEmpty())
+        words.append(makeWord(QTime(), "", QStringList()));
+
+    block b = {timeStamp, text, speaker, QStringList(), words};
+    return b;
+}
+
+TokenSpan Editor::wordRange(const QString& lineText)
+{
+    static const QRegularExpression speaker(R"(\[.*]:)");
+    static const QRegularExpression timeStamp(R"(\[(\d?\d:)?[0-5]?\d:[0-5]?\d(\.\d\d?\d?)?])");
+
+    int from{0}, to = lineText.size();
+
+    auto match = timeStamp.match(lineText);
+    if (match.hasMatch() && lineText.midRef(match.capturedEnd()).trimmed().isEmpty())
+        to = match.capturedStart();
+
+    match = speaker.match(lineText);
+    if (match.hasMatch() && match.capturedEnd() <= to)
+        from = match.capturedEnd();
+
+    return {from, to - from};
+}
+
+QVector<TokenSpan> Editor::wordSpans(const QString& lineText)
+{
+    auto range = wordRange(lineText);
+    return Tokenizer::spans(lineText, range.start, range.end());
+}
+
+int Editor::wordNumberAt(const QString& lineText, int positionInBlock)
+{
+    auto spans = wordSpans(lineText);
+    for (int i = 0; i < spans.size() && spans[i].start <= positionInBlock; i++)
+        if (positionInBlock <= spans[i].end())
+            return i;
+    return -1;
+}
+
+bool Editor::saveXml(const QString& fileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Written beside the transcript and moved over it once complete, a failed
+    // save leaves the file as it was
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        emit message("File not saved: " + file.errorString());
+        return false;
+    }
+
+    bool written;
+    QString error;
+    if (GzipDevice::isCompressedName(fileName)) {
+        GzipDevice gzip(&file);
+        written = gzip.open(QIODevice::WriteOnly)
+                && TranscriptWriter::write(&gzip, m_transcriptLang, m_blocks)
+                && gzip.finish();
+        if (!written)
+            error = gzip.errorString();
+    }
+    else
+        written = TranscriptWriter::write(&file, m_transcriptLang, m_blocks);
+
+    if (!written)
+        file.cancelWriting();
+    if (!file.commit()) {
+        emit message("File not saved: " + (error.isEmpty() ? file.errorString() : error));
+        return false;
+    }
+
+    qInfo() << "[Transcript Written]"
+            << QString("%1 bytes in %2 ms").arg(QString::number(QFileInfo(fileName).size()), QString::number(timer.elapsed()));
+    return true;
+}
+
+void Editor::storeSnapshot()
+{
+    if (m_transcriptUrl.isEmpty())
+        return;
+
+    TranscriptSnapshot snapshot;
+    snapshot.transcript = {m_transcriptLang, m_blocks};
+    if (m_oovStatistics.isBuilt() && dictionaryReady()) {
+        snapshot.invalidWords = m_oovStatistics.invalidWordNumbers();
+        snapshot.dictionaryKey = dictionaryKey();
+    }
+
+    // As reading the file back would give them, the writer leaves out lines
+    // without text
+    auto isEmpty = [](const block& a_block) {return a_block.text == "";};
+    if (std::any_of(m_blocks.begin(), m_blocks.end(), isEmpty)) {
+        auto& blocks = snapshot.transcript.blocks;
+        auto& invalidWords = snapshot.invalidWords;
+        int kept{0};
+        for (int i = 0; i < blocks.size(); i++) {
+            if (isEmpty(blocks[i]))
+                continue;
+            blocks[kept] = blocks[i];
+            if (i < invalidWords.size())
+                invalidWords[kept] = invalidWords[i];
+            kept++;
+        }
+        blocks.resize(kept);
+        if (!invalidWords.isEmpty())
+            invalidWords.resize(kept);
+    }
+
+    // Written behind the editor's back, the blocks are shared until edited.
+    // The key is the file as it was just saved, not whatever is there later.
+    auto fileName = m_transcriptUrl.toLocalFile();
+    QFileInfo info(fileName);
+    auto size = info.size();
+    auto lastModified = info.lastModified();
+    QtConcurrent::run([fileName, size, lastModified, snapshot] {
+        TranscriptCache::store(fileName, size, lastModified, snapshot);
+    });
+}
+
+void Editor::helpJumpToPlayer()
+{
+    auto currentBlockNumber = textCursor().blockNumber();
+    auto& index = timeIndex();
+
+    if (!index.hasEnd(currentBlockNumber))
+        return;
+
+    int wordNumber = wordNumberAt(textCursor().block().text(), textCursor().positionInBlock());
+
+    // If we can jump to a word, then do so
+    if (wordNumber >= 0 &&
+        wordNumber < index.wordCount(currentBlockNumber) &&
+        index.wordEnd(currentBlockNumber, wordNumber) != -1
+        ) {
+        jumpPlayerTo(index.wordStart(currentBlockNumber, wordNumber));
+        return;
+    }
+
+    jumpPlayerTo(index.blockStart(currentBlockNumber));
+}
+
+void Editor::jumpPlayerTo(qint64 position)
+{
+    // Lines and words without a time leave the player where it is
+    if (position >= 0)
+        emit jumpToPlayer(position);
+}
+
+void Editor::loadDictionary()
+{
+    if (m_tokenizer.lang() != m_transcriptLang) {
+        m_tokenizer = Tokenizer(m_transcriptLang);
+        m_wordIndex.clear();
+    }
+
+    if (auto dictionary = DictionaryCache::cached(m_transcriptLang)) {
+        applyDictionary(dictionary);
+        return;
+    }
+
+    // Applied from dictionaryLoaded() once the worker thread is done
+    m_oovStatistics.clear();
+    emit oovStatisticsChanged();
+    emit message("Loading dictionary, language: " + m_transcriptLang);
+    DictionaryCache::preload(m_transcriptLang);
+}
+
+void Editor::applyDictionary(QSharedPointer<const Dictionary> dictionary)
+{
+    if (!dictionary || dictionary == m_dictionary)
+        return;
+
+    m_dictionary = dictionary;
+    static_cast<QStringListModel*>(m_textCompleter->model())->setStringList(m_dictionary->words);
+
+    // Suggestions are ready by the time anyone right-clicks a word
+    SpellSuggester::forDictionary(m_dictionary);
+    rescanInvalidWords();
+}
+
+void Editor::rescanInvalidWords()
+{
+    if (m_openingTranscript || !m_highlighter || !dictionaryReady())
+        return;
+
+    if (restoreCachedScan()) {
+        emit oovStatisticsChanged();
+        m_highlighter->rehighlight();
+        return;
+    }
+
+    // Edits made meanwhile are journaled and brought into the result
+    auto scan = ++m_oovScan;
+    auto dictionary = m_dictionary;
+    m_oovJournal.start(m_blocks.size());
+    auto watcher = new QFutureWatcher<OovStatistics>(this);
+
+    connect(watcher, &QFutureWatcherBase::finished, this,
+        [this, watcher, scan, dictionary]()
+        {
+            watcher->deleteLater();
+
+            // A later scan took over
+            if (scan != m_oovScan)
+                return;
+
+            // The words moved on, or the content was replaced as a whole
+            auto statistics = watcher->result();
+            if (dictionary != m_dictionary || !m_oovJournal.replay(statistics, m_blocks)) {
+                m_oovJournal.invalidate();
+                if (!m_oovStatistics.isBuilt())
+                    rescanInvalidWords();
+                return;
+            }
+            m_oovJournal.invalidate();
+            m_oovStatistics = statistics;
+            emit oovStatisticsChanged();
+
+            if (m_highlighter)
+                m_highlighter->rehighlight();
+        }
+    );
+    watcher->setFuture(QtConcurrent::run(&OovStatistics::build, m_blocks, m_dictionary, m_tokenizer));
+}
+
+bool Editor::restoreCachedScan()
+{
+    // Kept until the dictionary is there, then only for the blocks as they
+    // were read and the dictionary of the scan
+    if (m_cachedInvalidWords.isEmpty() || !dictionaryReady())
+        return false;
+
+    auto invalidWords = std::move(m_cachedInvalidWords);
+    m_cachedInvalidWords.clear();
+    if (m_cachedScanRevision != m_blocksRevision || m_cachedDictionaryKey != dictionaryKey())
+        return false;
+
+    // Any scan still running is outdated by it
+    m_oovStatistics.restore(m_blocks, invalidWords, m_dictionary, m_tokenizer);
+    m_oovScan++;
+    qInfo() << "[Transcript Cache]" << QString("dictionary scan of %1 lines skipped").arg(QString::number(m_blocks.size()));
+    return true;
+}
+
+QVector<QPair<int, int>> Editor::wordPositions(const QString& word) const
+{
+    if (!m_wordIndex.isBuilt())
+        m_wordIndex.rebuild(m_blocks, m_tokenizer);
+    return m_wordIndex.positions(word);
+}
+
+void Editor::setContent()
+{
+    if (!settingContent) {
+        settingContent = true;
+
+        QString content("");
+        for (auto& a_block: qAsConst(m_blocks))
+            content.append(lineText(a_block) + "\n");
+        setPlainText(content.trimmed());
+
+        createHighlighter();
+        m_timeIndex.invalidate();
+        m_confidenceQueue.rebuild(m_blocks);
+        if (m_showChanges)
+            m_diff.rebuild(m_blocks, m_timeIndex);
+
+        m_highlighter->setBlockToHighlight(highlightedBlock);
+        m_highlighter->setWordToHighlight(highlightedWord);
+
+        settingContent = false;
+        m_wordIndex.clear();
+        emit blocksReset();
+        emit blocksChanged();
+        emit oovStatisticsChanged();
+    }
+}
+
+QString Editor::lineText(const block& a_block)
+{
+    return "[" + a_block.speaker + "]: " + a_block.text + " [" + a_block.timeStamp.toString("hh:mm:ss.zzz") + "]";
+}
 
-    auto list = text.split(" ");
-    for (auto& m_word: qAsConst(list)) {
-        words.append(makeWord(QTime(), m_word, QStringList()));
-    }
+void Editor::beginChange(const QString& name)
+{
+    m_history.beginStep(name);
 
-    block b = {timeStamp, text, speaker, QStringList(), words};
-    return b;
+    // The edits below are the model's, contentChanged() must not read them back
+    settingContent = true;
+    QTextCursor(document()).beginEditBlock();
 }
 
-void Editor::loadTranscriptData(QFile& file)
+void Editor::compareWithBaseline()
 {
-    QXmlStreamReader reader(&file);
-    m_transcriptLang = "";
-    m_blocks.clear();
-    if (reader.readNextStartElement()) {
-        if (reader.name() == "transcript") {
-            m_transcriptLang = reader.attributes().value("lang").toString();
-
-            while(reader.readNextStartElement()) {
-                if(reader.name() == "line") {
-                    auto blockTimeStamp = getTime(reader.attributes().value("timestamp").toString());
-                    auto blockText = QString("");
-                    auto blockSpeaker = reader.attributes().value("speaker").toString();
-                    auto tagString = reader.attributes().value("tags").toString();
-                    QStringList tagList;
-                    if (tagString != "")
-                        tagList = tagString.split(",");
-
-                    struct block line = {blockTimeStamp, "", blockSpeaker, tagList, QVector<word>()};
-                    while(reader.readNextStartElement()){
-                        if(reader.name() == "word"){
-                            auto wordTimeStamp  = getTime(reader.attributes().value("timestamp").toString());
-                            auto wordTagString  = reader.attributes().value("tags").toString();
-                            auto wordText       = reader.readElementText();
-                            QStringList wordTagList;
-                            if (wordTagString != "")
-                                wordTagList = wordTagString.split(",");
-
-                            blockText += (wordText + " ");
-                            line.words.append(makeWord(wordTimeStamp, wordText, wordTagList));
-                        }
-                        else
-                            reader.skipCurrentElement();
-                    }
-                    line.text = blockText.trimmed();
-                    m_blocks.append(line);
-                }
-                else
-                    reader.skipCurrentElement();
-            }
-        }
-        else
-            reader.raiseError(QObject::tr("Incorrect file"));
+    // Nothing is compared while changes are hidden
+    if (!m_showChanges)
+        m_diff.clear();
+    else if (!m_diff.isActive()) {
+        QElapsedTimer timer;
+        timer.start();
+        m_diff.rebuild(m_blocks, m_timeIndex);
+        qInfo() << "[Changes Compared]"
+                << QString("%1 changes in %2 ms").arg(QString::number(m_diff.count()), QString::number(timer.elapsed()));
     }
+
+    if (m_highlighter)
+        m_highlighter->setDiff(m_showChanges ? &m_diff : nullptr);
 }
 
-void Editor::saveXml(QFile* file)
+void Editor::replaceBlocks(int at, int count, const QVector<block>& blocks)
 {
-    QXmlStreamWriter writer(file);
-    writer.setAutoFormatting(true);
-    writer.writeStartDocument();
-    writer.writeStartElement("transcript");
-
-    if (m_transcriptLang != "")
-        writer.writeAttribute("lang", m_transcriptLang);
+    m_history.record(at, m_blocks.mid(at, count), blocks);
+    applyBlocks(at, count, blocks);
+}
 
-    for (auto& a_block: qAsConst(m_blocks)) {
-        if (a_block.text != "") {
-            auto timeStamp = a_block.timeStamp;
-            QString timeStampString = timeStamp.toString("hh:mm:ss.zzz");
-            auto speaker = a_block.speaker;
+void Editor::applyBlocks(int at, int count, const QVector<block>& blocks)
+{
+    int kept = qMin(count, blocks.size());
+    int removed = count - kept, added = blocks.size() - kept;
 
-            writer.writeStartElement("line");
-            writer.writeAttribute("timestamp", timeStampString);
-            writer.writeAttribute("speaker", speaker);
+    // Lines both runs have are overwritten in place, only where they differ
+    for (int i = 0; i < kept; i++) {
+        m_blocks[at + i] = blocks[i];
 
-            if (!a_block.tagList.isEmpty())
-                writer.writeAttribute("tags", a_block.tagList.join(","));
+        auto text = lineText(blocks[i]);
+        auto textBlock = document()->findBlockByNumber(at + i);
+        if (textBlock.text() == text)
+            continue;
 
-            for (auto& a_word: qAsConst(a_block.words)) {
-                writer.writeStartElement("word");
-                writer.writeAttribute("timestamp", a_word.timeStamp.toString("hh:mm:ss.zzz"));
+        QTextCursor cursor(textBlock);
+        cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+    }
 
-                if (!a_word.tagList.isEmpty())
-                    writer.writeAttribute("tags", a_word.tagList.join(","));
+    if (removed) {
+        m_blocks.remove(at + kept, removed);
 
-                writer.writeCharacters(a_word.text);
-                writer.writeEndElement();
-            }
-            writer.writeEndElement();
+        // The lines go with the line break before them, or after them at the top
+        auto firstLine = document()->findBlockByNumber(at + kept);
+        auto lastLine = document()->findBlockByNumber(at + kept + removed - 1);
+        QTextCursor cursor(document());
+        if (firstLine.previous().isValid()) {
+            cursor.setPosition(firstLine.previous().position() + firstLine.previous().length() - 1);
+            cursor.setPosition(lastLine.position() + lastLine.length() - 1, QTextCursor::KeepAnchor);
+        }
+        else {
+            cursor.setPosition(firstLine.position());
+            if (lastLine.next().isValid())
+                cursor.setPosition(lastLine.next().position(), QTextCursor::KeepAnchor);
+            else
+                cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
         }
+        cursor.removeSelectedText();
     }
-    writer.writeEndElement();
-    file->close();
-    delete file;
-}
-
-void Editor::helpJumpToPlayer()
-{
-    auto currentBlockNumber = textCursor().blockNumber();
-    auto timeToJump = QTime(0, 0);
-
-    if (m_blocks[currentBlockNumber].timeStamp.isNull())
-        return;
+    else if (added) {
+        m_blocks.insert(at + kept, added, block());
 
-    int positionInBlock = textCursor().positionInBlock();
-    auto blockText = textCursor().block().text();
-    auto textBeforeCursor = blockText.left(positionInBlock);
-    int wordNumber = textBeforeCursor.count(" ");
-    if (m_blocks[currentBlockNumber].speaker != "" || textCursor().block().text().contains("[]:"))
-        wordNumber--;
-
-    for (int i = currentBlockNumber - 1; i >= 0; i--) {
-        if (m_blocks[i].timeStamp.isValid()) {
-            timeToJump = m_blocks[i].timeStamp;
-            break;
+        QStringList lines;
+        for (int i = kept; i < blocks.size(); i++) {
+            m_blocks[at + i] = blocks[i];
+            lines << lineText(blocks[i]);
         }
-    }
 
-    // If we can jump to a word, then do so
-    if (wordNumber >= 0 &&
-        wordNumber < m_blocks[currentBlockNumber].words.size() &&
-        m_blocks[currentBlockNumber].words[wordNumber].timeStamp.isValid()
-        ) {
-        for (int i = wordNumber - 1; i >= 0; i--) {
-            if (m_blocks[currentBlockNumber].words[i].timeStamp.isValid()) {
-                timeToJump = m_blocks[currentBlockNumber].words[i].timeStamp;
-                emit jumpToPlayer(timeToJump);
-                return;
-            }
+        QTextCursor cursor(document());
+        if (at + kept > 0) {
+            auto previous = document()->findBlockByNumber(at + kept - 1);
+            cursor.setPosition(previous.position() + previous.length() - 1);
+            cursor.insertText("\n" + lines.join("\n"));
         }
+        else if (m_blocks.size() == added)
+            cursor.insertText(lines.join("\n"));
+        else
+            cursor.insertText(lines.join("\n") + "\n");
     }
 
-    emit jumpToPlayer(timeToJump);
+    if (removed)
+        notifyBlocksRemoved(at + kept, removed);
+    if (added)
+        notifyBlocksInserted(at + kept, added);
+    notifyBlocksUpdated(at, at + blocks.size() - 1);
 }
 
-void Editor::loadDictionary()
+void Editor::notifyBlocksInserted(int at, int count)
 {
-    m_correctedWords.clear();
-    m_dictionary.clear();
-
-    auto dictionaryFileName = QString(":/wordlists/%1.txt").arg(m_transcriptLang);
-    m_dictionary = listFromFile(dictionaryFileName);
+    for (auto observer: qAsConst(m_blockObservers))
+        observer->blocksInserted(at, count);
+    emit blocksInserted(at, count);
+}
 
-    auto correctedWordsList = listFromFile(QString("corrected_words_%1.txt").arg(m_transcriptLang));
-    if (!correctedWordsList.isEmpty()) {
-        std::copy(correctedWordsList.begin(),
-                  correctedWordsList.end(),
-                  std::inserter(m_correctedWords, m_correctedWords.begin()));
+void Editor::notifyBlocksRemoved(int at, int count)
+{
+    for (auto observer: qAsConst(m_blockObservers))
+        observer->blocksRemoved(at, count);
+    emit blocksRemoved(at, count);
+}
 
-        for (auto& a_word: m_correctedWords) {
-            m_dictionary.insert
-            (
-                std::upper_bound(m_dictionary.begin(), m_dictionary.end(), a_word),
-                a_word
-            );
-        }
-    }
-    m_textCompleter->setModel(new QStringListModel(m_dictionary, m_textCompleter));
+void Editor::notifyBlocksUpdated(int first, int last)
+{
+    for (auto observer: qAsConst(m_blockObservers))
+        observer->update(first, last, m_blocks);
+    emit blocksUpdated(first, last);
 
+    // The diff compares the lines around an edit too, they are redrawn with it
     if (!m_highlighter)
         return;
-
-    QMultiMap<int, int> invalidWords;
-    for (int i = 0; i < m_blocks.size(); i++) {
-        for (int j = 0; j < m_blocks[i].words.size(); j++) {
-            auto wordText = m_blocks[i].words[j].text.toLower();
-
-            if (wordText != "" && m_punctuation.contains(wordText.back()))
-                wordText = wordText.left(wordText.size() - 1);
-
-            if (!std::binary_search(m_dictionary.begin(),
-                                    m_dictionary.end(),
-                                    wordText)
-                )
-                invalidWords.insert(i, j);
-        }
+    if (m_diff.isActive()) {
+        first = qMin(first, m_diff.comparedFirst());
+        last = qMax(last, m_diff.comparedLast());
     }
-    m_highlighter->setInvalidWords(invalidWords);
-    m_highlighter->rehighlight();
+    m_highlighter->rehighlightBlocks(first, last);
 }
 
-QStringList Editor::listFromFile(const QString& fileName)
+void Editor::createHighlighter()
 {
-    QStringList words;
+    delete m_highlighter;
+    m_highlighter = new Highlighter(document());
+    m_highlighter->setInvalid(&m_blocks, &m_oovStatistics);
+    m_highlighter->setConfidence(m_shadeConfidence ? &m_confidenceQueue : nullptr, m_confidenceThreshold);
+    m_highlighter->setDiff(m_showChanges ? &m_diff : nullptr);
+}
 
-    QFile file(fileName);
-    if (!file.open(QFile::ReadOnly))
-        return {};
+void Editor::endChange()
+{
+    QTextCursor(document()).endEditBlock();
+    settingContent = false;
+    m_history.endStep();
 
-    while (!file.atEnd()) {
-        QByteArray line = file.readLine();
-        if (!line.isEmpty())
-            words << QString::fromUtf8(line.trimmed());
-    }
+    if (!m_highlighter)
+        createHighlighter();
 
-    return words;
+    updateWordEditor();
+    emit blocksChanged();
+    emit oovStatisticsChanged();
 }
 
-void Editor::setContent()
+void Editor::undoChange()
 {
-    if (!settingContent) {
-        settingContent = true;
+    auto step = m_history.undo();
+    if (!step) {
+        emit message("Nothing to undo", 2000);
+        return;
+    }
 
-        if (m_highlighter)
-            delete m_highlighter;
+    // Nothing is recorded while a step is replayed, the step itself stays
+    beginChange(step->name);
+    for (int i = step->hunks.size() - 1; i >= 0; i--) {
+        auto& hunk = step->hunks[i];
+        applyBlocks(hunk.at, hunk.after.size(), hunk.before);
+    }
 
-        QString content("");
-        for (auto& a_block: qAsConst(m_blocks)) {
-            auto blockText = "[" + a_block.speaker + "]: " + a_block.text + " [" + a_block.timeStamp.toString("hh:mm:ss.zzz") + "]";
-            content.append(blockText + "\n");
-        }
-        setPlainText(content.trimmed());
+    auto& first = step->hunks.first();
+    QTextCursor cursor(document()->findBlockByNumber(qMin(first.at, blockCount() - 1)));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    setTextCursor(cursor);
+    endChange();
+    centerCursor();
 
-        m_highlighter = new Highlighter(document());
+    qInfo() << "[Undo]" << QString("%1, %2 hunks").arg(step->name, QString::number(step->hunks.size()));
+}
 
-        QList<int> invalidBlocks;
-        QMultiMap<int, int> invalidWords;
-        for (int i = 0; i < m_blocks.size(); i++) {
-            if (m_blocks[i].timeStamp.isNull())
-                invalidBlocks.append(i);
-            else {
-                for (int j = 0; j < m_blocks[i].words.size(); j++) {
-                    auto wordText = m_blocks[i].words[j].text.toLower();
+void Editor::redoChange()
+{
+    auto step = m_history.redo();
+    if (!step) {
+        emit message("Nothing to redo", 2000);
+        return;
+    }
 
-                    if (wordText != "" && m_punctuation.contains(wordText.back()))
-                        wordText = wordText.left(wordText.size() - 1);
+    beginChange(step->name);
+    for (auto& hunk: step->hunks)
+        applyBlocks(hunk.at, hunk.before.size(), hunk.after);
 
-                    if (!std::binary_search(m_dictionary.begin(),
-                                            m_dictionary.end(),
-                                            wordText)
-                       )
-                        invalidWords.insert(i, j);
-                }
-            }
-        }
+    auto& last = step->hunks.last();
+    QTextCursor cursor(document()->findBlockByNumber(qMin(last.at + qMax(last.after.size() - 1, 0), blockCount() - 1)));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    setTextCursor(cursor);
+    endChange();
+    centerCursor();
 
-        m_highlighter->setInvalidBlocks(invalidBlocks);
-        m_highlighter->setInvalidWords(invalidWords);
-        m_highlighter->setBlockToHighlight(highlightedBlock);
-        m_highlighter->setWordToHighlight(highlightedWord);
+    qInfo() << "[Redo]" << QString("%1, %2 hunks").arg(step->name, QString::number(step->hunks.size()));
+}
 
-        settingContent = false;
-    }
+void Editor::setUndoMemoryLimit(qint64 bytes)
+{
+    m_undoMemoryLimit = bytes;
+    m_history.setMemoryLimit(bytes);
+
+    emit message(QString("Undo history: %1 of %2 MB used")
+                 .arg(QString::number(m_history.memoryUsed() / (1024.0 * 1024.0), 'f', 1),
+                      QString::number(bytes / (1024 * 1024))));
 }
 
 void Editor::contentChanged(int position, int charsRemoved, int charsAdded)
@@ -758,13 +1483,37 @@ void Editor::contentChanged(int position, int charsRemoved, int charsAdded)
     else if (m_blocks.isEmpty()) { // If block data is empty (i.e. no file opened) just fill them from editor
         for (int i = 0; i < document()->blockCount(); i++)
             m_blocks.append(fromEditor(i));
+        m_timeIndex.invalidate();
+        m_wordIndex.clear();
+        if (m_oovStatistics.isBuilt())
+            m_oovStatistics.rebuild(m_blocks, m_dictionary, m_tokenizer);
+        m_confidenceQueue.rebuild(m_blocks);
+        if (m_diff.isActive())
+            m_diff.rebuild(m_blocks, m_timeIndex);
+        m_history.record(0, {}, m_blocks);
+        emit blocksReset();
+        emit blocksChanged();
+        emit oovStatisticsChanged();
         return;
     }
 
-    delete m_highlighter;
-    m_highlighter = new Highlighter(this->document());
+    if (!m_highlighter)
+        createHighlighter();
 
     int currentBlockNumber = textCursor().blockNumber();
+    int firstChangedBlock = currentBlockNumber;
+
+    // The lines the edit replaces: the current one and those joined into it,
+    // or the one that was split into the lines up to the current one
+    int sizeBefore = m_blocks.size();
+    int historyAt = currentBlockNumber, historyCount = 1;
+    if (sizeBefore > blockCount())
+        historyCount += sizeBefore - blockCount();
+    else
+        historyAt -= blockCount() - sizeBefore;
+    historyAt = qBound(0, historyAt, sizeBefore - 1);
+    historyCount = qMin(historyCount, sizeBefore - historyAt);
+    auto before = m_blocks.mid(historyAt, historyCount);
 
     if(m_blocks.size() != blockCount()) {
         auto blocksChanged = m_blocks.size() - blockCount();
@@ -772,14 +1521,18 @@ void Editor::contentChanged(int position, int charsRemoved, int charsAdded)
             qInfo() << "[Lines Deleted]" << QString("%1 lines deleted").arg(QString::number(blocksChanged));
             for (int i = 1; i <= blocksChanged; i++)
                 m_blocks.removeAt(currentBlockNumber + 1);
+            notifyBlocksRemoved(currentBlockNumber + 1, blocksChanged);
         }
         else { // Blocks added
             qInfo() << "[Lines Inserted]" << QString("%1 lines inserted").arg(QString::number(-blocksChanged));
             for (int i = 1; i <= -blocksChanged; i++) {
+                int insertAt = currentBlockNumber + blocksChanged;
                 if (document()->findBlockByNumber(currentBlockNumber + blocksChanged).text().trimmed() == "")
-                    m_blocks.insert(currentBlockNumber + blocksChanged, fromEditor(currentBlockNumber - i));
+                    m_blocks.insert(insertAt, fromEditor(currentBlockNumber - i));
                 else
-                    m_blocks.insert(currentBlockNumber + blocksChanged + 1, fromEditor(currentBlockNumber - i + 1));
+                    m_blocks.insert(++insertAt, fromEditor(currentBlockNumber - i + 1));
+                notifyBlocksInserted(insertAt, 1);
+                firstChangedBlock = qMin(firstChangedBlock, insertAt);
             }
         }
     }
@@ -823,27 +1576,36 @@ void Editor::contentChanged(int position, int charsRemoved, int charsAdded)
                 break;
             }
 
+        // The timestamp stays with its position, the confidence only with an
+        // unchanged word since it scored the word the recognizer heard
+        auto carry = [&wordsFromEditor, &wordsFromData](int i, int j) {
+            wordsFromEditor[i].timeStamp = wordsFromData[j].timeStamp;
+            if (wordsFromEditor[i].text == wordsFromData[j].text)
+                wordsFromEditor[i].confidence = wordsFromData[j].confidence;
+        };
+
         if (diffStart == -1)
             diffStart = wordsFromEditor.size() - 1;
         for (int i = 0; i <= diffStart; i++)
             if (i < wordsFromData.size())
-                wordsFromEditor[i].timeStamp = wordsFromData[i].timeStamp;
+                carry(i, i);
         if (!wordsDifference) {
             for (int i = diffStart; i < wordsFromEditor.size(); i++)
-                wordsFromEditor[i].timeStamp = wordsFromData[i].timeStamp;
+                carry(i, i);
         }
 
         if (wordsDifference > 0) {
             for (int i = wordsFromEditor.size() - 1, j = wordsFromData.size() - 1; j > diffStart; i--, j--)
                 if (wordsFromEditor[i].text == wordsFromData[j].text)
-                    wordsFromEditor[i].timeStamp = wordsFromData[j].timeStamp;
+                    carry(i, j);
         }
         else if (wordsDifference < 0) {
             for (int i = wordsFromEditor.size() - 1, j = wordsFromData.size() - 1; i > diffStart; i--, j--)
                 if (wordsFromEditor[i].text == wordsFromData[j].text)
-                    wordsFromEditor[i].timeStamp = wordsFromData[j].timeStamp;
+                    carry(i, j);
         }
 
+        // An edited line loses its line confidence, the hypothesis it scored is gone
         currentBlockFromData = currentBlockFromEditor;
         currentBlockFromData.tagList = tagList;
     }
@@ -851,30 +1613,16 @@ void Editor::contentChanged(int position, int charsRemoved, int charsAdded)
     m_highlighter->setBlockToHighlight(highlightedBlock);
     m_highlighter->setWordToHighlight(highlightedWord);
 
-    QList<int> invalidBlocks;
-    QMultiMap<int, int> invalidWords;
-    for (int i = 0; i < m_blocks.size(); i++) {
-        if (m_blocks[i].timeStamp.isNull())
-            invalidBlocks.append(i);
-        else {
-            for (int j = 0; j < m_blocks[i].words.size(); j++) {
-                auto wordText = m_blocks[i].words[j].text.toLower();
-
-                if (wordText != "" && m_punctuation.contains(wordText.back()))
-                    wordText = wordText.left(wordText.size() - 1);
+    // Only the changed blocks are scanned against the dictionary again
+    notifyBlocksUpdated(firstChangedBlock, currentBlockNumber);
 
-                if (!std::binary_search(m_dictionary.begin(),
-                                        m_dictionary.end(),
-                                        wordText)
-                    )
-                    invalidWords.insert(i, j);
-            }
-        }
-    }
-    m_highlighter->setInvalidBlocks(invalidBlocks);
-    m_highlighter->setInvalidWords(invalidWords);
+    auto after = m_blocks.mid(historyAt, historyCount + m_blocks.size() - sizeBefore);
+    if (!(before == after))
+        m_history.recordTyping(historyAt, before, after);
 
     updateWordEditor();
+    emit blocksChanged();
+    emit oovStatisticsChanged();
 }
 
 void Editor::jumpToHighlightedLine()
@@ -893,53 +1641,52 @@ void Editor::splitLine(const QTime& elapsedTime)
 
     int positionInBlock = cursor.positionInBlock();
     auto blockText = cursor.block().text();
-    auto textBeforeCursor = blockText.left(positionInBlock);
-    auto textAfterCursor = blockText.right(blockText.size() - positionInBlock);
-    auto cutWordLeft = textBeforeCursor.split(" ").last();
-    auto cutWordRight = textAfterCursor.split(" ").first();
-    int wordNumber = textBeforeCursor.count(" ");
-
-    if (m_blocks[highlightedBlock].speaker != "" || blockText.contains("[]:"))
-        wordNumber--;
+    int wordNumber = wordNumberAt(blockText, positionInBlock);
+
     if (wordNumber < 0 || wordNumber >= m_blocks[highlightedBlock].words.size())
         return;
 
-    if (textBeforeCursor.contains("]:"))
-        textBeforeCursor = textBeforeCursor.split("]:").last();
-    if (textAfterCursor.contains("["))
-        textAfterCursor = textAfterCursor.split("[").first();
+    auto range = wordRange(blockText);
+    auto cutWord = wordSpans(blockText)[wordNumber];
+    auto textBeforeCursor = blockText.mid(range.start, positionInBlock - range.start);
+    auto textAfterCursor = blockText.mid(positionInBlock, range.end() - positionInBlock);
+    auto cutWordLeft = blockText.mid(cutWord.start, positionInBlock - cutWord.start);
+    auto cutWordRight = blockText.mid(positionInBlock, cutWord.end() - positionInBlock);
 
-    auto timeStampOfCutWord = m_blocks[highlightedBlock].words[wordNumber].timeStamp;
-    auto tagsOfCutWord = m_blocks[highlightedBlock].words[wordNumber].tagList;
+    auto current = m_blocks[highlightedBlock];
+    auto timeStampOfCutWord = current.words[wordNumber].timeStamp;
+    auto tagsOfCutWord = current.words[wordNumber].tagList;
     QVector<word> words;
-    int sizeOfWordsAfter = m_blocks[highlightedBlock].words.size() - wordNumber - 1;
+    int sizeOfWordsAfter = current.words.size() - wordNumber - 1;
 
     if (cutWordRight != "")
         words.append(makeWord(timeStampOfCutWord, cutWordRight, tagsOfCutWord));
     for (int i = 0; i < sizeOfWordsAfter; i++) {
-        words.append(m_blocks[highlightedBlock].words[wordNumber + 1]);
-        m_blocks[highlightedBlock].words.removeAt(wordNumber + 1);
+        words.append(current.words[wordNumber + 1]);
+        current.words.removeAt(wordNumber + 1);
     }
 
     if (cutWordLeft == "")
-        m_blocks[highlightedBlock].words.removeAt(wordNumber);
+        current.words.removeAt(wordNumber);
     else {
-        m_blocks[highlightedBlock].words[wordNumber].text = cutWordLeft;
-        m_blocks[highlightedBlock].words[wordNumber].timeStamp = elapsedTime;
+        current.words[wordNumber].text = cutWordLeft;
+        current.words[wordNumber].timeStamp = elapsedTime;
+        if (cutWordRight != "")
+            current.words[wordNumber].confidence = -1;
     }
 
-    block blockToInsert = {m_blocks[highlightedBlock].timeStamp,
+    block blockToInsert = {current.timeStamp,
                            textAfterCursor.trimmed(),
-                           m_blocks[highlightedBlock].speaker,
-                           m_blocks[highlightedBlock].tagList,
-                           words};
-    m_blocks.insert(highlightedBlock + 1, blockToInsert);
+                           current.speaker,
+                           current.tagList,
+                           words,
+                           current.confidence};
+    current.text = textBeforeCursor.trimmed();
+    current.timeStamp = elapsedTime;
 
-    m_blocks[highlightedBlock].text = textBeforeCursor.trimmed();
-    m_blocks[highlightedBlock].timeStamp = elapsedTime;
-
-    setContent();
-    updateWordEditor();
+    beginChange("Split Line");
+    replaceBlocks(highlightedBlock, 1, {current, blockToInsert});
+    endChange();
 
     qInfo() << "[Line Split]"
             << QString("line number: %1").arg(QString::number(highlightedBlock + 1))
@@ -954,18 +1701,19 @@ void Editor::mergeUp()
     if (m_blocks.isEmpty() || blockNumber == 0 || m_blocks[blockNumber].speaker != m_blocks[previousBlockNumber].speaker)
         return;
 
-    auto currentWords = m_blocks[blockNumber].words;
-
-    m_blocks[previousBlockNumber].words.append(currentWords);                 // Add current words to previous block
-    m_blocks[previousBlockNumber].timeStamp = m_blocks[blockNumber].timeStamp;  // Update time stamp of previous block
-    m_blocks[previousBlockNumber].text.append(" " + m_blocks[blockNumber].text);// Append text to previous block
+    auto previous = m_blocks[previousBlockNumber], current = m_blocks[blockNumber];
+    auto lineConfidence = mergeConfidence(previous, current);
 
-    m_blocks.removeAt(blockNumber);
-    setContent();
-    updateWordEditor();
+    previous.words.append(current.words);           // Add current words to previous block
+    previous.timeStamp = current.timeStamp;         // Update time stamp of previous block
+    previous.text.append(" " + current.text);       // Append text to previous block
+    previous.confidence = lineConfidence;
 
+    beginChange("Merge Up");
+    replaceBlocks(previousBlockNumber, 2, {previous});
     QTextCursor cursor(document()->findBlockByNumber(previousBlockNumber));
     setTextCursor(cursor);
+    endChange();
     centerCursor();
 
     qInfo() << "[Merge Up]"
@@ -981,27 +1729,23 @@ void Editor::mergeDown()
     if (m_blocks.isEmpty() || blockNumber == m_blocks.size() - 1 || m_blocks[blockNumber].speaker != m_blocks[nextBlockNumber].speaker)
         return;
 
-    auto currentWords = m_blocks[blockNumber].words;
-
-    auto temp = m_blocks[nextBlockNumber].words;
-    m_blocks[nextBlockNumber].words = currentWords;
-    m_blocks[nextBlockNumber].words.append(temp);
-
-    auto tempText = m_blocks[nextBlockNumber].text;
-    m_blocks[nextBlockNumber].text = m_blocks[blockNumber].text;
-    m_blocks[nextBlockNumber].text.append(" " + tempText);
+    auto current = m_blocks[blockNumber], next = m_blocks[nextBlockNumber];
+    auto lineConfidence = mergeConfidence(current, next);
 
-    m_blocks.removeAt(blockNumber);
-    setContent();
-    updateWordEditor();
+    next.words = current.words + next.words;
+    next.text = current.text + " " + next.text;
+    next.confidence = lineConfidence;
 
+    beginChange("Merge Down");
+    replaceBlocks(blockNumber, 2, {next});
     QTextCursor cursor(document()->findBlockByNumber(blockNumber));
     setTextCursor(cursor);
+    endChange();
     centerCursor();
 
     qInfo() << "[Merge Down]"
             << QString("line number: %1, %2").arg(QString::number(blockNumber + 1), QString::number(nextBlockNumber + 1))
-            << QString("final line: %1, %2").arg(QString::number(blockNumber + 1), m_blocks[nextBlockNumber].text);
+            << QString("final line: %1, %2").arg(QString::number(blockNumber + 1), m_blocks[blockNumber].text);
 }
 
 void Editor::createChangeSpeakerDialog()
@@ -1075,6 +1819,43 @@ void Editor::createTagSelectionDialog()
     m_selectTag->show();
 }
 
+void Editor::createOovStatisticsDialog()
+{
+    if (m_oovStatisticsDialog) {
+        m_oovStatisticsDialog->raise();
+        m_oovStatisticsDialog->activateWindow();
+        return;
+    }
+
+    m_oovStatisticsDialog = new OovStatisticsDialog(this);
+    m_oovStatisticsDialog->setAttribute(Qt::WA_DeleteOnClose);
+    m_oovStatisticsDialog->setStatistics(m_oovStatistics);
+
+    connect(this, &Editor::oovStatisticsChanged, m_oovStatisticsDialog,
+            [this]() {m_oovStatisticsDialog->setStatistics(m_oovStatistics);});
+    connect(m_oovStatisticsDialog, &OovStatisticsDialog::acceptWords, this, &Editor::markWordsAsCorrect);
+    connect(m_oovStatisticsDialog, &OovStatisticsDialog::findWord, this,
+            [this](const QString& word) {
+                // Cycles through the occurrences after the cursor
+                auto positions = wordPositions(word);
+                if (positions.isEmpty())
+                    return;
+
+                auto cursorBlock = textCursor().blockNumber();
+                auto next = std::upper_bound(positions.begin(), positions.end(), qMakePair(cursorBlock, std::numeric_limits<int>::max()));
+                auto position = (next == positions.end()) ? positions.first() : *next;
+
+                QTextCursor cursor(document()->findBlockByNumber(position.first));
+                setTextCursor(cursor);
+                centerCursor();
+            }
+    );
+    connect(m_oovStatisticsDialog, &OovStatisticsDialog::message, this, &Editor::message);
+    connect(m_oovStatisticsDialog, &OovStatisticsDialog::destroyed, this, [this]() {m_oovStatisticsDialog = nullptr;});
+
+    m_oovStatisticsDialog->show();
+}
+
 void Editor::insertTimeStamp(const QTime& elapsedTime)
 {
     auto blockNumber = textCursor().blockNumber();
@@ -1082,13 +1863,16 @@ void Editor::insertTimeStamp(const QTime& elapsedTime)
     if (m_blocks.size() <= blockNumber)
         return;
 
-    m_blocks[blockNumber].timeStamp = elapsedTime;
+    auto changed = m_blocks[blockNumber];
+    changed.timeStamp = elapsedTime;
 
     dontUpdateWordEditor = true;
-    setContent();
+    beginChange("Insert TimeStamp");
+    replaceBlocks(blockNumber, 1, {changed});
     QTextCursor cursor(document()->findBlockByNumber(blockNumber));
     cursor.movePosition(QTextCursor::EndOfBlock);
     setTextCursor(cursor);
+    endChange();
     centerCursor();
     dontUpdateWordEditor = false;
 
@@ -1097,6 +1881,71 @@ void Editor::insertTimeStamp(const QTime& elapsedTime)
 
 }
 
+void Editor::retime(int blockNumber, int wordNumber, const QTime& time)
+{
+    if (time.isNull() || blockNumber < 0 || blockNumber >= m_blocks.size()
+            || wordNumber >= m_blocks[blockNumber].words.size())
+        return;
+
+    auto changed = m_blocks[blockNumber];
+    auto& timeStamp = (wordNumber < 0) ? changed.timeStamp : changed.words[wordNumber].timeStamp;
+    if (timeStamp == time)
+        return;
+
+    auto initialTime = timeStamp;
+    timeStamp = time;
+
+    // Block timestamps are part of the line text, the cursor is kept where it was
+    auto cursorPosition = textCursor().position();
+    beginChange("Retime");
+    replaceBlocks(blockNumber, 1, {changed});
+    if (wordNumber < 0) {
+        QTextCursor cursor(document());
+        cursor.setPosition(qMin(cursorPosition, document()->characterCount() - 1));
+        setTextCursor(cursor);
+    }
+    endChange();
+
+    qInfo() << "[Retimed From Timeline]"
+            << QString("line number: %1, word number: %2").arg(QString::number(blockNumber + 1), QString::number(wordNumber + 1))
+            << QString("initial: %1").arg(initialTime.toString("hh:mm:ss.zzz"))
+            << QString("final: %1").arg(time.toString("hh:mm:ss.zzz"));
+}
+
+void Editor::alignMissingTimeStamps(QSharedPointer<const PeakPyramid> envelope)
+{
+    if (m_blocks.isEmpty())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto before = m_blocks;
+    auto report = TimeStampAligner(envelope).alignAll(m_blocks);
+    m_timeIndex.invalidate();
+
+    // Word times aren't part of the text, only the history needs the change
+    m_history.beginStep("Fill Missing Word Times");
+    for (int i = 0; i < m_blocks.size(); i++)
+        if (!(before[i] == m_blocks[i]))
+            m_history.record(i, {before[i]}, {m_blocks[i]});
+    m_history.endStep();
+
+    updateWordEditor();
+    emit blocksReset();
+    emit blocksChanged();
+
+    auto source = (envelope && !envelope->isEmpty()) ? QString("audio") : QString("word length only");
+    emit message(QString("Filled %1 word timestamps (%2), mean shift %3 ms, max shift %4 ms")
+                 .arg(QString::number(report.filled), source,
+                      QString::number(report.meanShift()), QString::number(report.maxShift)));
+
+    qInfo() << "[Aligned Missing TimeStamps]"
+            << QString("filled: %1, mean shift: %2 ms, max shift: %3 ms")
+               .arg(QString::number(report.filled), QString::number(report.meanShift()), QString::number(report.maxShift))
+            << QString("time taken: %1 ms").arg(QString::number(timer.elapsed()));
+}
+
 void Editor::changeTranscriptLang()
 {
     auto newLang = QInputDialog::getText(this, "Change Transcript Language", "Current Language: " + m_transcriptLang);
@@ -1137,16 +1986,7 @@ void Editor::speakerWiseJump(const QString& jumpDirection)
         return;
     }
 
-    QTime timeToJump(0, 0);
-
-    for (int i = blockToJump - 1; i >= 0; i--) {
-        if (m_blocks[i].timeStamp.isValid()) {
-            timeToJump = m_blocks[i].timeStamp;
-            break;
-        }
-    }
-
-    emit jumpToPlayer(timeToJump);
+    jumpPlayerTo(timeIndex().blockStart(blockToJump));
 }
 
 void Editor::wordWiseJump(const QString& jumpDirection)
@@ -1158,8 +1998,7 @@ void Editor::wordWiseJump(const QString& jumpDirection)
         return;
     }
 
-    auto& highlightedBlockWords = m_blocks[highlightedBlock].words;
-    QTime timeToJump;
+    auto& index = timeIndex();
     int wordToJump{-1};
 
     if (jumpDirection == "left")
@@ -1167,39 +2006,24 @@ void Editor::wordWiseJump(const QString& jumpDirection)
     else if (jumpDirection == "right")
         wordToJump = wordNumber + 1;
 
-    if (wordToJump < 0 || wordToJump >= highlightedBlockWords.size()) {
+    if (wordToJump < 0 || wordToJump >= index.wordCount(highlightedBlock)) {
         emit message("Can't jump, end of block reached!", 2000);
         return;
     }
 
-    if (jumpDirection == "left") {
-        if (wordToJump == 0){
-            timeToJump = QTime(0, 0);
-            for (int i = highlightedBlock - 1; i >= 0; i--) {
-                if (m_blocks[i].timeStamp.isValid()) {
-                    timeToJump = m_blocks[i].timeStamp;
-                    break;
-                }
-            }
-        }
-        else {
-            for (int i = wordToJump - 1; i >= 0; i--)
-                if (highlightedBlockWords[i].timeStamp.isValid()) {
-                    timeToJump = highlightedBlockWords[i].timeStamp;
-                    break;
-                }
-        }
-    }
-    
-    if (jumpDirection == "right")
-        timeToJump = highlightedBlockWords[wordToJump - 1].timeStamp;
+    qint64 positionToJump{-1};
+
+    if (jumpDirection == "left")
+        positionToJump = index.wordStart(highlightedBlock, wordToJump);
+    else if (jumpDirection == "right")
+        positionToJump = index.wordEnd(highlightedBlock, wordToJump - 1);
 
-    if (timeToJump.isNull()) {
+    if (positionToJump == -1) {
         emit message("Couldn't find a word to jump to");
         return;
     }
 
-    emit jumpToPlayer(timeToJump);
+    jumpPlayerTo(positionToJump);
 }
 
 
@@ -1218,22 +2042,157 @@ void Editor::blockWiseJump(const QString& jumpDirection)
     if (blockToJump == -1 || blockToJump == blockCount())
         return;
 
-    QTime timeToJump;
+    jumpPlayerTo(timeIndex().blockStart(blockToJump));
+}
 
-    if (jumpDirection == "up") {
-        timeToJump = QTime(0, 0);
-        for (int i = blockToJump - 1; i >= 0; i--) {
-            if (m_blocks[i].timeStamp.isValid()) {
-                timeToJump = m_blocks[i].timeStamp;
-                break;
-            }
-        }
+void Editor::nextLowConfidenceWord()
+{
+    int blockNumber = textCursor().blockNumber();
+    int wordNumber = wordNumberAt(textCursor().block().text(), textCursor().positionInBlock());
+
+    if (!m_confidenceQueue.next(blockNumber, wordNumber, m_confidenceThreshold)) {
+        emit message(QString("No more words below confidence %1").arg(m_confidenceThreshold), 2000);
+        return;
     }
-    else if (jumpDirection == "down")
-        timeToJump = m_blocks[highlightedBlock].timeStamp;
+    jumpToLowConfidenceWord(blockNumber, wordNumber);
+}
+
+void Editor::previousLowConfidenceWord()
+{
+    int blockNumber = textCursor().blockNumber();
+    int wordNumber = wordNumberAt(textCursor().block().text(), textCursor().positionInBlock());
+
+    if (!m_confidenceQueue.previous(blockNumber, wordNumber, m_confidenceThreshold)) {
+        emit message("Already at the lowest confidence word", 2000);
+        return;
+    }
+    jumpToLowConfidenceWord(blockNumber, wordNumber);
+}
+
+void Editor::setConfidenceThreshold(double threshold)
+{
+    m_confidenceThreshold = qBound(0.0, threshold, 1.0);
+    useConfidenceShading(m_shadeConfidence);
+
+    emit message(QString("%1 words below confidence %2")
+                 .arg(QString::number(m_confidenceQueue.count(m_confidenceThreshold)),
+                      QString::number(m_confidenceThreshold)));
+}
+
+void Editor::useConfidenceShading(bool value)
+{
+    m_shadeConfidence = value;
+    if (m_highlighter) {
+        m_highlighter->setConfidence(m_shadeConfidence ? &m_confidenceQueue : nullptr, m_confidenceThreshold);
+        m_highlighter->rehighlight();
+    }
+}
+
+void Editor::showChanges(bool value)
+{
+    m_showChanges = value;
+    compareWithBaseline();
+    if (m_highlighter)
+        m_highlighter->rehighlight();
+
+    if (m_showChanges)
+        emit message(QString("%1 changes since the transcript was loaded").arg(QString::number(m_diff.count())));
+}
+
+void Editor::nextChange()
+{
+    if (!m_showChanges) {
+        emit message("Changes aren't shown", 2000);
+        return;
+    }
+
+    int blockNumber = textCursor().blockNumber();
+    int wordNumber = wordNumberAt(textCursor().block().text(), textCursor().positionInBlock());
+
+    if (!m_diff.next(blockNumber, wordNumber)) {
+        emit message("No more changes", 2000);
+        return;
+    }
+    jumpToChange(blockNumber, wordNumber);
+}
+
+void Editor::previousChange()
+{
+    if (!m_showChanges) {
+        emit message("Changes aren't shown", 2000);
+        return;
+    }
+
+    int blockNumber = textCursor().blockNumber();
+    int wordNumber = wordNumberAt(textCursor().block().text(), textCursor().positionInBlock());
+
+    if (!m_diff.previous(blockNumber, wordNumber)) {
+        emit message("Already at the first change", 2000);
+        return;
+    }
+    jumpToChange(blockNumber, wordNumber);
+}
+
+void Editor::jumpToWord(int blockNumber, int wordNumber)
+{
+    auto textBlock = document()->findBlockByNumber(blockNumber);
+    auto spans = wordSpans(textBlock.text());
+    if (wordNumber >= spans.size())
+        return;
+
+    // A line without words is entered where they would be
+    QTextCursor cursor(textBlock);
+    if (wordNumber < 0)
+        cursor.setPosition(textBlock.position() + wordRange(textBlock.text()).start);
+    else {
+        cursor.setPosition(textBlock.position() + spans[wordNumber].start);
+        cursor.setPosition(textBlock.position() + spans[wordNumber].end(), QTextCursor::KeepAnchor);
+    }
+    setTextCursor(cursor);
+    centerCursor();
+
+    auto& index = timeIndex();
+    if (blockNumber >= index.size())
+        return;
+    if (wordNumber < 0)
+        jumpPlayerTo(index.blockStart(blockNumber));
+    else if (wordNumber < index.wordCount(blockNumber) && index.wordEnd(blockNumber, wordNumber) != -1)
+        jumpPlayerTo(index.wordStart(blockNumber, wordNumber));
+}
+
+void Editor::jumpToLowConfidenceWord(int blockNumber, int wordNumber)
+{
+    jumpToWord(blockNumber, wordNumber);
+
+    auto confidence = m_confidenceQueue.wordConfidences(blockNumber).value(wordNumber, -1);
+    qInfo() << "[Low Confidence Word]"
+            << QString("line number: %1, word number: %2, confidence: %3")
+               .arg(QString::number(blockNumber + 1), QString::number(wordNumber + 1), QString::number(confidence));
+}
 
-    emit jumpToPlayer(timeToJump);
+void Editor::jumpToChange(int blockNumber, int wordNumber)
+{
+    jumpToWord(blockNumber, wordNumber);
+
+    QStringList descriptions;
+    for (auto& change: m_diff.changes(blockNumber)) {
+        if (change.word != wordNumber)
+            continue;
+
+        auto& words = m_blocks[blockNumber].words;
+        auto text = change.word >= 0 && change.word < words.size() ? words[change.word].text : QString();
+        if (change.kind == TranscriptDiff::Change::Inserted)
+            descriptions << QString("inserted \"%1\"").arg(text);
+        else if (change.kind == TranscriptDiff::Change::Substituted)
+            descriptions << QString("\"%1\" was \"%2\"").arg(text, change.original);
+        else
+            descriptions << QString("deleted \"%1\"").arg(change.original);
+    }
 
+    qInfo() << "[Change]"
+            << QString("line number: %1, word number: %2, %3")
+               .arg(QString::number(blockNumber + 1), QString::number(wordNumber + 1), descriptions.join(", "));
+    emit message(QString("Line %1: %2").arg(QString::number(blockNumber + 1), descriptions.join(", ")));
 }
 
 void Editor::useTransliteration(bool value, const QString& langCode)
@@ -1265,31 +2224,45 @@ void Editor::wordEditorChanged()
 {
     auto editorBlockNumber = textCursor().blockNumber();
 
-    if (document()->isEmpty() || m_blocks.isEmpty())
+    if (document()->isEmpty() || m_blocks.isEmpty()) {
         m_blocks.append(fromEditor(0));
+        m_timeIndex.invalidate();
+        m_wordIndex.clear();
+        emit blocksReset();
+    }
 
     if (settingContent || updatingWordEditor || editorBlockNumber >= m_blocks.size())
         return;
 
     auto& block = m_blocks[editorBlockNumber];
     if (block.words.isEmpty()) {
+        auto previous = block;
         block.words = m_wordEditor->currentWords();
+        m_history.record(editorBlockNumber, {previous}, {block});
+        notifyBlocksUpdated(editorBlockNumber, editorBlockNumber);
+        emit blocksChanged();
+        emit oovStatisticsChanged();
         return;
     }
 
-    auto& words = block.words;
-    words.clear();
+    auto changed = block;
+    auto& words = changed.words;
 
     QString blockText;
     words = m_wordEditor->currentWords();
+    for (int i = 0; i < words.size() && i < block.words.size(); i++)
+        if (words[i].text == block.words[i].text)
+            words[i].confidence = block.words[i].confidence;
     for (auto& a_word: words)
         blockText += a_word.text + " ";
-    block.text = blockText.trimmed();
+    changed.text = blockText.trimmed();
 
     dontUpdateWordEditor = true;
-    setContent();
+    beginChange("Edit Words");
+    replaceBlocks(editorBlockNumber, 1, {changed});
     QTextCursor cursor(document()->findBlockByNumber(editorBlockNumber));
     setTextCursor(cursor);
+    endChange();
     centerCursor();
     dontUpdateWordEditor = false;
 }
@@ -1301,18 +2274,17 @@ void Editor::changeSpeaker(const QString& newSpeaker, bool replaceAllOccurrences
     auto blockNumber = textCursor().blockNumber();
     auto blockSpeaker = m_blocks[blockNumber].speaker;
 
-    if (!replaceAllOccurrences)
-        m_blocks[blockNumber].speaker = newSpeaker;
-    else {
-        for (auto& a_block: m_blocks){
-            if (a_block.speaker == blockSpeaker)
-                a_block.speaker = newSpeaker;
+    beginChange("Change Speaker");
+    for (int i = 0; i < m_blocks.size(); i++) {
+        if (i == blockNumber || (replaceAllOccurrences && m_blocks[i].speaker == blockSpeaker)) {
+            auto changed = m_blocks[i];
+            changed.speaker = newSpeaker;
+            replaceBlocks(i, 1, {changed});
         }
     }
-
-    setContent();
     QTextCursor cursor(document()->findBlockByNumber(blockNumber));
     setTextCursor(cursor);
+    endChange();
     centerCursor();
 
     qInfo() << "[Speaker Changed]"
@@ -1334,8 +2306,9 @@ void Editor::propagateTime(const QTime& time, int start, int end, bool negateTim
         return;
     }
 
-    for (int i = start - 1; i < end; i++) {
-        auto& currentTimeStamp = m_blocks[i].timeStamp;
+    auto changed = m_blocks.mid(start - 1, end - start + 1);
+    for (auto& a_block: changed) {
+        auto& currentTimeStamp = a_block.timeStamp;
 
         if (currentTimeStamp.isNull())
             currentTimeStamp = QTime(0, 0, 0);
@@ -1355,9 +2328,11 @@ void Editor::propagateTime(const QTime& time, int start, int end, bool negateTim
 
     int blockNumber = textCursor().blockNumber();
 
-    setContent();
+    beginChange("Propagate Time");
+    replaceBlocks(start - 1, changed.size(), changed);
     QTextCursor cursor(document()->findBlockByNumber(blockNumber));
     setTextCursor(cursor);
+    endChange();
     centerCursor();
 
     qInfo() << "[Time propagated]"
@@ -1367,7 +2342,16 @@ void Editor::propagateTime(const QTime& time, int start, int end, bool negateTim
 
 void Editor::selectTags(const QStringList& newTagList)
 {
-    m_blocks[textCursor().blockNumber()].tagList = newTagList;
+    auto blockNumber = textCursor().blockNumber();
+    if (blockNumber >= m_blocks.size())
+        return;
+
+    auto changed = m_blocks[blockNumber];
+    changed.tagList = newTagList;
+
+    beginChange("Edit Tags");
+    replaceBlocks(blockNumber, 1, {changed});
+    endChange();
 
     emit refreshTagList(newTagList);
 
@@ -1377,57 +2361,90 @@ void Editor::selectTags(const QStringList& newTagList)
 
 void Editor::markWordAsCorrect(int blockNumber, int wordNumber)
 {
-    auto textToInsert = m_blocks[blockNumber].words[wordNumber].text.toLower();
+    auto textToInsert = m_tokenizer.normalized(m_blocks[blockNumber].words[wordNumber].text);
 
     if (textToInsert.trimmed() == "")
         return;
 
-    if (std::binary_search(m_dictionary.begin(),
-           m_dictionary.end(),
-           textToInsert))
+    // Without waiting for the dictionary, the word is merged once it's there
+    if (!dictionaryReady()) {
+        markWordsAsCorrect({textToInsert});
+        return;
+    }
+
+    if (m_dictionary->contains(textToInsert))
     {
         emit message("Word is already correct.");
         return;
     }
 
-    m_dictionary.insert
-    (
-            std::upper_bound(m_dictionary.begin(), m_dictionary.end(), textToInsert),
-            textToInsert
-    );
+    m_dictionary = DictionaryCache::addCorrectedWord(m_transcriptLang, textToInsert);
+    static_cast<QStringListModel*>(m_textCompleter->model())->setStringList(m_dictionary->words);
+    m_oovStatistics.setDictionary(m_dictionary);
 
-    static_cast<QStringListModel*>(m_textCompleter->model())->setStringList(m_dictionary);
-    m_correctedWords.insert(textToInsert);
+    // Only the occurrences of this word can have changed
+    m_oovStatistics.removeWords({textToInsert});
+    emit oovStatisticsChanged();
+    if (m_highlighter)
+        m_highlighter->rehighlightWords(wordPositions(textToInsert));
 
-    QMultiMap<int, int> invalidWords;
-    for (int i = 0; i < m_blocks.size(); i++) {
-        for (int j = 0; j < m_blocks[i].words.size(); j++) {
-            auto wordText = m_blocks[i].words[j].text.toLower();
+    if (!CorrectedWordStore::append(m_transcriptLang, textToInsert))
+        emit message("Couldn't write corrected words to file.");
+    emit wordMarkedCorrect(m_transcriptLang, textToInsert);
+
+    qInfo() << "[Mark As Correct]"
+            << QString("text: %1").arg(textToInsert);
+}
 
-            if (wordText != "" && m_punctuation.contains(wordText.back()))
-                wordText = wordText.left(wordText.size() - 1);
+void Editor::replaceWord(int blockNumber, int wordNumber, const QString& replacement)
+{
+    auto textBlock = document()->findBlockByNumber(blockNumber);
+    auto spans = wordSpans(textBlock.text());
+    if (!textBlock.isValid() || wordNumber >= spans.size())
+        return;
 
-            if (!std::binary_search(m_dictionary.begin(),
-                                    m_dictionary.end(),
-                                    wordText)
-                )
-                invalidWords.insert(i, j);
-        }
-    }
-    m_highlighter->setInvalidWords(invalidWords);
-    m_highlighter->rehighlight();
+    // Punctuation around the word stays, so does a capital first letter
+    auto wordText = textBlock.text().mid(spans[wordNumber].start, spans[wordNumber].length);
+    auto core = m_tokenizer.core(wordText);
+    auto original = wordText.mid(core.start, core.length);
+    auto text = replacement;
+    if (!original.isEmpty() && original[0].isUpper())
+        text[0] = text[0].toUpper();
+
+    // Through the editor's own cursor, contentChanged() reads the block from it
+    QTextCursor cursor(textBlock);
+    cursor.setPosition(textBlock.position() + spans[wordNumber].start + core.start);
+    cursor.setPosition(cursor.position() + core.length, QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+    textCursor().insertText(text);
 
-    QFile correctedWords(QString("corrected_words_%1.txt").arg(m_transcriptLang));
+    qInfo() << "[Suggestion Applied]"
+            << QString("line number: %1, %2 -> %3").arg(QString::number(blockNumber + 1), original, text);
+}
 
-    if (!correctedWords.open(QFile::WriteOnly | QFile::Truncate))
+void Editor::markWordsAsCorrect(const QStringList& words)
+{
+    // One merge for the whole batch, wordsAdded() clears the underlines
+    auto added = DictionaryCache::mergeWords(m_transcriptLang, words);
+    if (!CorrectedWordStore::append(m_transcriptLang, added))
         emit message("Couldn't write corrected words to file.");
-    else {
-        for (auto& a_word: m_correctedWords)
-            correctedWords.write(QString(a_word + "\n").toStdString().c_str());
+
+    // A dictionary still to be loaded reads the words from the store, it is
+    // applied through dictionaryLoaded() like any other
+    if (!dictionaryReady())
+        loadDictionary();
+
+    if (added.isEmpty()) {
+        emit message("Words are already correct.");
+        return;
     }
 
+    for (auto& a_word: qAsConst(added))
+        emit wordMarkedCorrect(m_transcriptLang, a_word);
+
+    emit message(QString("%1 words marked as correct.").arg(added.size()));
     qInfo() << "[Mark As Correct]"
-            << QString("text: %1").arg(textToInsert);
+            << QString("%1 words: %2").arg(QString::number(added.size()), added.join(", "));
 }
 
 void Editor::insertSpeakerCompletion(const QString& completion)
@@ -3,14 +3,35 @@
 #include "blockandword.h"
 #include "texteditor.h"
 #include "wordeditor.h"
+#include "timestampaligner.h"
+#include "blocktimeindex.h"
+#include "dictionarycache.h"
+#include "correctedwordstore.h"
+#include "oovstatistics.h"
+#include "confidencequeue.h"
+#include "transcripthistory.h"
+#include "transcriptreader.h"
+#include "transcriptwriter.h"
+#include "gzipdevice.h"
+#include "transcriptcache.h"
+#include "transcriptexporter.h"
+#include "transcriptimporter.h"
+#include "transcriptscorer.h"
+#include "transcriptdiff.h"
+#include "wordindex.h"
+#include "blockjournal.h"
+#include "tokenizer.h"
+#include "spellsuggester.h"
 #include "utilities/changespeakerdialog.h"
 #include "utilities/timepropagationdialog.h"
 #include "utilities/tagselectiondialog.h"
+#include "utilities/oovstatisticsdialog.h"
 
 #include <QXmlStreamReader>
 #include <QRegularExpression>
 #include <QSyntaxHighlighter>
 #include <QTextDocument>
+#include <QTextBlock>
 #include <QCompleter>
 #include <QAbstractItemModel>
 #include <qcompleter.h>
@@ -22,6 +43,38 @@
 
 class Highlighter;
 
+// A transcript file as openTranscript() reads it, parsed or taken from the
+// cache. Reading touches no widget, so it may run on a worker thread.
+struct LoadedTranscript
+{
+    bool opened{false};
+    QString error;
+    const TranscriptImporter::Importer *importer = nullptr;
+    bool cached{false};
+    TranscriptSnapshot snapshot;
+};
+
+// Everything that belongs to one open transcript. The workspace keeps one per
+// tab and swaps it into the Editor, so switching tabs doesn't reparse anything.
+struct TranscriptState
+{
+    QTextDocument *document = nullptr;
+    Highlighter *highlighter = nullptr;
+    QVector<block> blocks;
+    BlockTimeIndex timeIndex;
+    OovStatistics oovStatistics;
+    ConfidenceQueue confidenceQueue;
+    TranscriptDiff diff;
+    WordIndex wordIndex;
+    TranscriptHistory history;
+    bool modified{false};
+    QUrl transcriptUrl;
+    QString transcriptLang{"english"};
+    QSharedPointer<const Dictionary> dictionary;
+    qint64 highlightedBlock{-1}, highlightedWord{-1};
+    int cursorPosition{0};
+};
+
 class Editor : public TextEditor
 {
     Q_OBJECT
@@ -36,6 +89,37 @@ public:
     }
 
     void setEditorFont(const QFont& font);
+    const QVector<block>& blocks() const {return m_blocks;}
+    const BlockTimeIndex& timeIndex() const;
+    bool blockSpan(int blockNumber, qint64& start, qint64& end) const;
+    const OovStatistics& oovStatistics() const {return m_oovStatistics;}
+    const ConfidenceQueue& confidenceQueue() const {return m_confidenceQueue;}
+    double confidenceThreshold() const {return m_confidenceThreshold;}
+    const SubtitleOptions& subtitleOptions() const {return m_subtitleOptions;}
+    const TranscriptDiff& diff() const {return m_diff;}
+    const TranscriptHistory& history() const {return m_history;}
+
+    // Where the words of a displayed line are, without speaker and timestamp
+    static TokenSpan wordRange(const QString& lineText);
+    static QVector<TokenSpan> wordSpans(const QString& lineText);
+    // Word the position is in or touches, -1 outside of words
+    static int wordNumberAt(const QString& lineText, int positionInBlock);
+
+    // Not done on construction so it stays off the first paint
+    void loadDictionary();
+
+    const QUrl& transcriptUrl() const {return m_transcriptUrl;}
+    const QString& transcriptLang() const {return m_transcriptLang;}
+    bool isModified() const {return m_modified;}
+
+    TranscriptState createState();
+    TranscriptState takeState();
+    void restoreState(TranscriptState state);
+
+    // openTranscript() in two halves, the file is read on any thread and
+    // shown on the GUI thread
+    static LoadedTranscript readTranscript(const QString& fileName);
+    void openTranscript(const QUrl& fileUrl, const LoadedTranscript& loaded);
 
     QRegularExpression timeStampExp, speakerExp;
 
@@ -45,15 +129,32 @@ protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
 
 signals:
-    void jumpToPlayer(const QTime& time);
+    // In milliseconds, never wraps like a QTime would past 24 hours
+    void jumpToPlayer(qint64 position);
     void refreshTagList(const QStringList& tagList);
     void replyCame();
+    void blocksChanged();
+    // The lines a change inserted, removed or rewrote, once m_blocks has it.
+    // blocksReset() is sent instead when any line may have changed.
+    void blocksInserted(int at, int count);
+    void blocksRemoved(int at, int count);
+    void blocksUpdated(int first, int last);
+    void blocksReset();
+    void currentBlockChanged(int blockNumber);
+    void transcriptChanged(const QUrl& transcriptUrl);
+    void wordMarkedCorrect(const QString& lang, const QString& word);
+    void oovStatisticsChanged();
 
 public slots:
     void transcriptOpen();
+    void openTranscript(const QUrl& fileUrl);
     void transcriptSave();
     void transcriptSaveAs();
     void transcriptClose();
+    void exportTranscript();
+    void exportTranscripts();
+    void scoreAgainstHypothesis();
+    void setSubtitleOptions(const SubtitleOptions& options) {m_subtitleOptions = options;}
     void highlightTranscript(const QTime& elapsedTime);
 
     void showBlocksFromData();
@@ -64,16 +165,31 @@ public slots:
     void createChangeSpeakerDialog();
     void createTimePropagationDialog();
     void createTagSelectionDialog();
+    void createOovStatisticsDialog();
+    void markWordsAsCorrect(const QStringList& words);
     void insertTimeStamp(const QTime& elapsedTime);
+    void retime(int blockNumber, int wordNumber, const QTime& time);
+    void alignMissingTimeStamps(QSharedPointer<const PeakPyramid> envelope);
     void changeTranscriptLang();
 
     void speakerWiseJump(const QString& jumpDirection);
     void wordWiseJump(const QString& jumpDirection);
     void blockWiseJump(const QString& jumpDirection);
+    void nextLowConfidenceWord();
+    void previousLowConfidenceWord();
+    void setConfidenceThreshold(double threshold);
+    void useConfidenceShading(bool value);
+    void showChanges(bool value);
+    void nextChange();
+    void previousChange();
 
     void useTransliteration(bool value, const QString& langCode = "en");
     void useAutoSave(bool value) {m_autoSave = value;}
 
+    void undoChange();
+    void redoChange();
+    void setUndoMemoryLimit(qint64 bytes);
+
 private slots:
     void contentChanged(int position, int charsRemoved, int charsAdded);
     void wordEditorChanged();
@@ -84,6 +200,7 @@ private slots:
     void propagateTime(const QTime& time, int start, int end, bool negateTime);
     void selectTags(const QStringList& newTagList);
     void markWordAsCorrect(int blockNumber, int wordNumber);
+    void replaceWord(int blockNumber, int wordNumber, const QString& replacement);
 
     void insertSpeakerCompletion(const QString& completion);
     void insertTextCompletion(const QString& completion);
@@ -97,20 +214,67 @@ private:
     static word makeWord(const QTime& t, const QString& s, const QStringList& tagList);
     QCompleter* makeCompleter(); 
 
-    void loadTranscriptData(QFile& file);
     void setContent();
-    void saveXml(QFile* file);
+    static QString lineText(const block& a_block);
+
+    // Every change to the blocks outside of typing goes through these, so it
+    // is recorded for undo. applyBlocks() redraws the lines it replaced, and
+    // those the diff compared again with them, through notifyBlocksUpdated().
+    void beginChange(const QString& name);
+    void replaceBlocks(int at, int count, const QVector<block>& blocks);
+    void applyBlocks(int at, int count, const QVector<block>& blocks);
+    void endChange();
+    void createHighlighter();
+    // Every structure kept per block hears of a change through these, once
+    // m_blocks has it
+    void notifyBlocksInserted(int at, int count);
+    void notifyBlocksRemoved(int at, int count);
+    void notifyBlocksUpdated(int first, int last);
+    bool saveXml(const QString& fileName);
+    void storeSnapshot();
     void helpJumpToPlayer();
-    void loadDictionary();
+    void jumpPlayerTo(qint64 position);
+    void applyDictionary(QSharedPointer<const Dictionary> dictionary);
+    void rescanInvalidWords();
+    bool restoreCachedScan();
+    void jumpToWord(int blockNumber, int wordNumber);
+    void jumpToLowConfidenceWord(int blockNumber, int wordNumber);
+    void jumpToChange(int blockNumber, int wordNumber);
+    void compareWithBaseline();
+    bool dictionaryReady() const {return m_dictionary->lang == m_transcriptLang;}
+    // What a dictionary scan depends on, snapshots keep it with their scan
+    quint64 dictionaryKey() const {return m_dictionary->fingerprint * 31 + Dictionary::hash(m_tokenizer.punctuation());}
+    // Built on first use, kept up to date with every edit after that
+    QVector<QPair<int, int>> wordPositions(const QString& word) const;
 
     block fromEditor(qint64 blockNumber) const;
-    static QStringList listFromFile(const QString& fileName) ;
 
     bool settingContent{false}, updatingWordEditor{false}, dontUpdateWordEditor{false};
-    bool m_transliterate{false}, m_autoSave{false};
+    bool m_openingTranscript{false};
+    bool m_transliterate{false}, m_autoSave{false}, m_modified{false};
 
     QVector<block> m_blocks;
-    QString m_transcriptLang, m_punctuation{",.!;:"};
+    mutable BlockTimeIndex m_timeIndex;
+    OovStatistics m_oovStatistics;
+    BlockJournal m_oovJournal;
+    quint64 m_oovScan{0};
+    // The scan of the last snapshot read, until the dictionary is there
+    QVector<QVector<int>> m_cachedInvalidWords;
+    quint64 m_cachedDictionaryKey{0}, m_cachedScanRevision{0};
+    ConfidenceQueue m_confidenceQueue;
+    double m_confidenceThreshold{0.6};
+    bool m_shadeConfidence{true};
+    TranscriptDiff m_diff;
+    bool m_showChanges{false};
+    mutable WordIndex m_wordIndex;
+    QVector<BlockObserver*> m_blockObservers;
+    SubtitleOptions m_subtitleOptions;
+    TranscriptHistory m_history;
+    qint64 m_undoMemoryLimit{64 * 1024 * 1024};
+    int m_cursorBlockNumber{-1};
+    quint64 m_blocksRevision{0};
+    QString m_transcriptLang;
+    Tokenizer m_tokenizer;
     QUrl m_transcriptUrl;
     Highlighter* m_highlighter = nullptr;
     qint64 highlightedBlock = -1, highlightedWord = -1;
@@ -118,9 +282,9 @@ private:
     ChangeSpeakerDialog* m_changeSpeaker = nullptr;
     TimePropagationDialog* m_propagateTime = nullptr;
     TagSelectionDialog* m_selectTag = nullptr;
+    OovStatisticsDialog* m_oovStatisticsDialog = nullptr;
     QCompleter *m_speakerCompleter = nullptr, *m_textCompleter = nullptr, *m_transliterationCompleter = nullptr;
-    QStringList m_dictionary;
-    std::set<QString> m_correctedWords;
+    QSharedPointer<const Dictionary> m_dictionary;
     QString m_transliterateLangCode;
     QStringList m_lastReplyList;
     QNetworkAccessManager m_manager;
@@ -143,29 +307,66 @@ public:
         blockToHighlight = -1;
         wordToHighlight = -1;
     }
-    void setBlockToHighlight(qint64 blockNumber)
+    // Only the line that had the highlight and the one that gets it are
+    // redrawn. The old one is followed with a cursor, lines may have been
+    // inserted or removed above it since.
+    void setBlockToHighlight(int blockNumber)
     {
+        if (blockNumber == blockToHighlight && highlighted.blockNumber() == blockNumber)
+            return;
+
+        auto previous = highlighted.block();
+        auto textBlock = document()->findBlockByNumber(blockNumber);
         blockToHighlight = blockNumber;
-        rehighlight();
+        highlighted = textBlock.isValid() ? QTextCursor(textBlock) : QTextCursor();
+        if (previous.isValid() && previous != textBlock)
+            rehighlightBlock(previous);
+        if (textBlock.isValid())
+            rehighlightBlock(textBlock);
     }
     void setWordToHighlight(int wordNumber)
     {
+        if (wordNumber == wordToHighlight)
+            return;
+
         wordToHighlight = wordNumber;
-        rehighlight();
+        auto textBlock = document()->findBlockByNumber(blockToHighlight);
+        if (textBlock.isValid())
+            rehighlightBlock(textBlock);
+    }
+    // Lines without a timestamp are drawn red and out-of-vocabulary words
+    // underlined, both looked up per line while it is drawn
+    void setInvalid(const QVector<block>* blocks, const OovStatistics* oovStatistics)
+    {
+        transcriptBlocks = blocks;
+        oov = oovStatistics;
+    }
+    void rehighlightBlocks(int first, int last)
+    {
+        for (auto textBlock = document()->findBlockByNumber(qMax(first, 0));
+             textBlock.isValid() && textBlock.blockNumber() <= last; textBlock = textBlock.next())
+            rehighlightBlock(textBlock);
     }
-    void setInvalidBlocks(const QList<int>& invalidBlocks)
+    // Positions come in document order, each block is redrawn once
+    void rehighlightWords(const QVector<QPair<int, int>>& positions)
     {
-        invalidBlockNumbers = invalidBlocks;
-        rehighlight();
+        int lastBlock{-1};
+        for (auto& position: positions) {
+            if (position.first != lastBlock)
+                rehighlightBlock(document()->findBlockByNumber(position.first));
+            lastBlock = position.first;
+        }
     }
-    void setInvalidWords(const QMultiMap<int, int>& invalidWordsMap)
+    // Shades words below the threshold, the lower the darker. Null turns it off.
+    void setConfidence(const ConfidenceQueue* queue, double threshold)
     {
-        invalidWords = invalidWordsMap;
-        rehighlight();
+        confidenceQueue = queue;
+        confidenceThreshold = threshold;
     }
-    void clearInvalidBlocks()
+    // Marks the words changed since the baseline. Null turns it off.
+    void setDiff(const TranscriptDiff* transcriptDiff)
     {
-        invalidBlockNumbers.clear();
+        diff = transcriptDiff;
     }
 
     void highlightBlock(const QString&) override;
@@ -173,7 +374,11 @@ public:
 private:
     int blockToHighlight{-1};
     int wordToHighlight{-1};
-    QList<int> invalidBlockNumbers;
-    QMultiMap<int, int> invalidWords;
+    QTextCursor highlighted;
+    const QVector<block>* transcriptBlocks = nullptr;
+    const OovStatistics* oov = nullptr;
+    const ConfidenceQueue* confidenceQueue = nullptr;
+    double confidenceThreshold{0};
+    const TranscriptDiff* diff = nullptr;
 };
 
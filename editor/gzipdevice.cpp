@@ -0,0 +1,173 @@
+#include "gzipdevice.h"
+
+#include <limits>
+
+#ifdef USE_QT_ZLIB
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+namespace {
+    // 15 bits of window, plus 16 for a gzip header instead of a zlib one
+    const int gzipWindowBits = 15 + 16;
+}
+
+GzipDevice::GzipDevice(QIODevice* device, QObject* parent)
+    : QIODevice(parent), m_device(device), m_stream(new z_stream)
+{
+}
+
+GzipDevice::~GzipDevice()
+{
+    if (isOpen())
+        close();
+    delete m_stream;
+}
+
+bool GzipDevice::open(OpenMode mode)
+{
+    if ((mode & ReadWrite) == ReadWrite || !(mode & ReadWrite)) {
+        setErrorString(tr("Compressed files are either read or written"));
+        return false;
+    }
+    if (!m_device || !m_device->isOpen()) {
+        setErrorString(tr("The compressed file isn't open"));
+        return false;
+    }
+
+    *m_stream = z_stream();
+    m_finished = false;
+    m_buffer.resize(bufferSize);
+
+    auto result = (mode & ReadOnly)
+            ? inflateInit2(m_stream, gzipWindowBits)
+            : deflateInit2(m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzipWindowBits, 8, Z_DEFAULT_STRATEGY);
+    if (result != Z_OK) {
+        setErrorString(m_stream->msg ? QString(m_stream->msg) : tr("Couldn't start zlib"));
+        return false;
+    }
+
+    return QIODevice::open(mode & ~Text);
+}
+
+bool GzipDevice::finish()
+{
+    if (!(openMode() & WriteOnly)) {
+        setErrorString(tr("The compressed file isn't open for writing"));
+        return false;
+    }
+    if (m_finished)
+        return true;
+
+    m_stream->next_in = nullptr;
+    m_stream->avail_in = 0;
+    if (!deflateBuffer(Z_FINISH))
+        return false;
+    m_finished = true;
+    return true;
+}
+
+void GzipDevice::close()
+{
+    if (!isOpen())
+        return;
+
+    if (openMode() & WriteOnly) {
+        finish();
+        deflateEnd(m_stream);
+    }
+    else
+        inflateEnd(m_stream);
+
+    QIODevice::close();
+}
+
+bool GzipDevice::isCompressedName(const QString& fileName)
+{
+    return fileName.endsWith(".gz", Qt::CaseInsensitive);
+}
+
+bool GzipDevice::isCompressed(QIODevice* device)
+{
+    return device->peek(2) == QByteArray("\x1f\x8b");
+}
+
+qint64 GzipDevice::readData(char* data, qint64 maxSize)
+{
+    if (m_finished || maxSize <= 0)
+        return 0;
+
+    m_stream->next_out = reinterpret_cast<Bytef*>(data);
+    m_stream->avail_out = uInt(qMin<qint64>(maxSize, bufferSize));
+
+    while (m_stream->avail_out > 0) {
+        if (m_stream->avail_in == 0) {
+            auto bytesRead = m_device->read(m_buffer.data(), bufferSize);
+            if (bytesRead < 0) {
+                setErrorString(m_device->errorString());
+                return -1;
+            }
+            if (bytesRead == 0)
+                break;
+            m_stream->next_in = reinterpret_cast<Bytef*>(m_buffer.data());
+            m_stream->avail_in = uInt(bytesRead);
+        }
+
+        auto result = inflate(m_stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            // gzip files may hold several members one after the other
+            if (m_stream->avail_in == 0 && m_device->atEnd()) {
+                m_finished = true;
+                break;
+            }
+            inflateReset(m_stream);
+        }
+        else if (result != Z_OK) {
+            setErrorString(m_stream->msg ? QString(m_stream->msg) : tr("Corrupt compressed data"));
+            return -1;
+        }
+    }
+
+    auto produced = qMin<qint64>(maxSize, bufferSize) - m_stream->avail_out;
+    if (produced == 0 && !m_finished) {
+        setErrorString(tr("The compressed file ends too early"));
+        return -1;
+    }
+    return produced;
+}
+
+qint64 GzipDevice::writeData(const char* data, qint64 size)
+{
+    auto remaining = size;
+    while (remaining > 0) {
+        auto chunk = qMin<qint64>(remaining, std::numeric_limits<uInt>::max());
+        m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + (size - remaining)));
+        m_stream->avail_in = uInt(chunk);
+        if (!deflateBuffer(Z_NO_FLUSH))
+            return -1;
+        remaining -= chunk;
+    }
+    return size;
+}
+
+bool GzipDevice::deflateBuffer(int flush)
+{
+    do {
+        m_stream->next_out = reinterpret_cast<Bytef*>(m_buffer.data());
+        m_stream->avail_out = bufferSize;
+
+        if (deflate(m_stream, flush) == Z_STREAM_ERROR) {
+            setErrorString(tr("Couldn't compress the file"));
+            return false;
+        }
+
+        auto bytes = bufferSize - qint64(m_stream->avail_out);
+        if (bytes > 0 && m_device->write(m_buffer.constData(), bytes) != bytes) {
+            setErrorString(m_device->errorString());
+            return false;
+        }
+    } while (m_stream->avail_out == 0);
+
+    return true;
+}
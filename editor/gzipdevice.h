@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QIODevice>
+
+struct z_stream_s;
+
+// Reads or writes gzip data through another, already open device, inflating
+// and deflating as it goes so the whole file is never held uncompressed.
+// Only one direction at a time, the other device is left open on close.
+class GzipDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit GzipDevice(QIODevice* device, QObject* parent = nullptr);
+    ~GzipDevice() override;
+
+    bool open(OpenMode mode) override;
+    // Compresses what is still buffered and writes the gzip trailer. close()
+    // does it too if needed, but can't report a failure, writers check this.
+    bool finish();
+    void close() override;
+    bool isSequential() const override {return true;}
+
+    // Saved transcripts are compressed by name, opened ones by content
+    static bool isCompressedName(const QString& fileName);
+    static bool isCompressed(QIODevice* device);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private:
+    bool deflateBuffer(int flush);
+
+    static const int bufferSize = 64 * 1024;
+
+    QIODevice* m_device;
+    z_stream_s* m_stream;
+    QByteArray m_buffer;
+    bool m_finished{false};
+};
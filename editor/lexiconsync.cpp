@@ -0,0 +1,215 @@
+#include "lexiconsync.h"
+#include "dictionarycache.h"
+#include "correctedwordstore.h"
+
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace {
+    const QString serverFileName("lexicon_server.txt");
+    const int uploadDelay = 2000;
+    const int pullInterval = 60000;
+}
+
+LexiconSync::LexiconSync(QObject *parent)
+    : QObject(parent)
+{
+    QFile serverFile(serverFileName);
+    if (serverFile.open(QFile::ReadOnly))
+        m_serverUrl = QUrl(QString::fromUtf8(serverFile.readLine().trimmed()));
+
+    m_uploadTimer.setSingleShot(true);
+    m_uploadTimer.setInterval(uploadDelay);
+    connect(&m_uploadTimer, &QTimer::timeout, this, [this] {upload();});
+
+    m_pullTimer.setInterval(pullInterval);
+    connect(&m_pullTimer, &QTimer::timeout, this, [this] {
+        upload();
+        for (auto& lang: m_languages.keys())
+            pull(lang);
+    });
+    m_pullTimer.start();
+}
+
+void LexiconSync::setServerUrl(const QUrl& serverUrl)
+{
+    m_serverUrl = serverUrl;
+
+    QSaveFile serverFile(serverFileName);
+    if (serverFile.open(QFile::WriteOnly)) {
+        serverFile.write(serverUrl.toString().toUtf8() + '\n');
+        serverFile.commit();
+    }
+
+    if (m_serverUrl.isEmpty())
+        emit message("Lexicon sync is off, accepted words stay queued");
+    else
+        syncAll();
+}
+
+void LexiconSync::queueWord(const QString& lang, const QString& word)
+{
+    auto& langState = state(lang);
+    if (langState.pending.contains(word))
+        return;
+
+    langState.pending << word;
+    saveState(lang);
+    m_uploadTimer.start();
+}
+
+void LexiconSync::pull(const QString& lang)
+{
+    auto& langState = state(lang);
+    if (!m_serverUrl.isValid() || m_serverUrl.isEmpty() || langState.pulling)
+        return;
+
+    auto url = endpoint(lang);
+    url.setQuery(QUrlQuery{{"since", QString::number(langState.version)}});
+
+    langState.pulling = true;
+    auto reply = m_manager.get(QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, this, [this, reply, lang] {
+        reply->deleteLater();
+
+        auto& langState = state(lang);
+        langState.pulling = false;
+
+        if (reply->error() != QNetworkReply::NoError) {
+            qWarning() << "[Lexicon Sync]" << QString("pull %1 failed: %2").arg(lang, reply->errorString());
+            return;
+        }
+
+        auto response = QJsonDocument::fromJson(reply->readAll()).object();
+        QStringList words;
+        for (auto a_word: response["words"].toArray())
+            words << a_word.toString();
+
+        auto added = DictionaryCache::mergeWords(lang, words);
+        if (!CorrectedWordStore::append(lang, added))
+            qWarning() << "[Lexicon Sync]" << QString("couldn't store pulled words in %1").arg(CorrectedWordStore::fileName(lang));
+
+        langState.version = qMax(langState.version, qint64(response["version"].toDouble()));
+        saveState(lang);
+
+        if (!added.isEmpty()) {
+            qInfo() << "[Lexicon Pulled]" << QString("language: %1, %2 new words").arg(lang, QString::number(added.size()));
+            emit message(QString("%1 words added from the team lexicon").arg(added.size()));
+        }
+    });
+}
+
+void LexiconSync::syncAll()
+{
+    if (!m_serverUrl.isValid() || m_serverUrl.isEmpty()) {
+        emit message("Lexicon server isn't set");
+        return;
+    }
+
+    upload();
+    for (auto& lang: m_languages.keys())
+        pull(lang);
+}
+
+void LexiconSync::upload()
+{
+    for (auto& lang: m_languages.keys())
+        upload(lang);
+}
+
+void LexiconSync::upload(const QString& lang)
+{
+    auto& langState = state(lang);
+    if (!m_serverUrl.isValid() || m_serverUrl.isEmpty() || langState.pending.isEmpty() || langState.uploading)
+        return;
+
+    auto sent = langState.pending;
+    QJsonObject body{{"words", QJsonArray::fromStringList(sent)}};
+
+    QNetworkRequest request(endpoint(lang));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    langState.uploading = true;
+    auto reply = m_manager.post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+    connect(reply, &QNetworkReply::finished, this, [this, reply, lang, sent] {
+        reply->deleteLater();
+
+        auto& langState = state(lang);
+        langState.uploading = false;
+
+        if (reply->error() != QNetworkReply::NoError) {
+            qWarning() << "[Lexicon Sync]" << QString("upload %1 failed: %2").arg(lang, reply->errorString());
+            return;
+        }
+
+        // Words accepted while the request was out stay queued
+        for (auto& a_word: sent)
+            langState.pending.removeOne(a_word);
+        saveState(lang);
+
+        qInfo() << "[Lexicon Uploaded]" << QString("language: %1, %2 words").arg(lang, QString::number(sent.size()));
+        pull(lang);
+    });
+}
+
+LexiconSync::LanguageState& LexiconSync::state(const QString& lang)
+{
+    auto it = m_languages.find(lang);
+    if (it != m_languages.end())
+        return it.value();
+
+    LanguageState loaded;
+
+    QFile stateFile(stateFileName(lang));
+    if (stateFile.open(QFile::ReadOnly)) {
+        auto saved = QJsonDocument::fromJson(stateFile.readAll()).object();
+        loaded.version = qint64(saved["version"].toDouble());
+        for (auto a_word: saved["pending"].toArray())
+            loaded.pending << a_word.toString();
+    }
+
+    if (!loaded.pending.isEmpty())
+        m_uploadTimer.start();
+
+    return m_languages.insert(lang, loaded).value();
+}
+
+void LexiconSync::saveState(const QString& lang)
+{
+    auto& langState = state(lang);
+    QJsonObject saved{
+        {"version", double(langState.version)},
+        {"pending", QJsonArray::fromStringList(langState.pending)}
+    };
+
+    QSaveFile stateFile(stateFileName(lang));
+    if (!stateFile.open(QFile::WriteOnly)) {
+        qWarning() << "[Lexicon Sync]" << QString("couldn't save %1").arg(stateFileName(lang));
+        return;
+    }
+
+    stateFile.write(QJsonDocument(saved).toJson());
+    stateFile.commit();
+}
+
+QUrl LexiconSync::endpoint(const QString& lang) const
+{
+    auto url = m_serverUrl;
+    auto path = url.path();
+    if (!path.endsWith('/'))
+        path += '/';
+
+    url.setPath(path + "lexicon/" + lang);
+    return url;
+}
+
+QString LexiconSync::stateFileName(const QString& lang)
+{
+    return QString("lexicon_%1.json").arg(lang);
+}
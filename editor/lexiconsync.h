@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QTimer>
+#include <QHash>
+#include <QUrl>
+
+// Shares accepted words with a team lexicon service.
+//
+//   GET  <server>/lexicon/<lang>?since=<version>  -> {"version": n, "words": [...]}
+//   POST <server>/lexicon/<lang>  {"words": [...]} -> {"version": n}
+//
+// Accepted words are batched and uploaded a few seconds later, pulls ask only
+// for what changed since the last version seen. The version and the words not
+// uploaded yet are kept in lexicon_<lang>.json, pulled words go to the local
+// corrected words store, so everything keeps working offline.
+class LexiconSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LexiconSync(QObject *parent = nullptr);
+
+    const QUrl& serverUrl() const {return m_serverUrl;}
+    void setServerUrl(const QUrl& serverUrl);
+
+public slots:
+    void queueWord(const QString& lang, const QString& word);
+    void pull(const QString& lang);
+    void syncAll();
+
+signals:
+    void message(const QString& text, int timeout = 5000);
+
+private:
+    struct LanguageState
+    {
+        qint64 version{0};
+        QStringList pending;
+        bool uploading{false}, pulling{false};
+    };
+
+    void upload();
+    void upload(const QString& lang);
+    LanguageState& state(const QString& lang);
+    void saveState(const QString& lang);
+    QUrl endpoint(const QString& lang) const;
+
+    static QString stateFileName(const QString& lang);
+
+    QNetworkAccessManager m_manager;
+    QUrl m_serverUrl;
+    QHash<QString, LanguageState> m_languages;
+    QTimer m_uploadTimer, m_pullTimer;
+};
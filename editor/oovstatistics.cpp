@@ -0,0 +1,213 @@
+#include "oovstatistics.h"
+
+#include <QtConcurrent>
+#include <QSet>
+#include <functional>
+
+OovStatistics OovStatistics::build(const QVector<block>& blocks,
+                                   QSharedPointer<const Dictionary> dictionary,
+                                   const Tokenizer& tokenizer)
+{
+    OovStatistics statistics;
+    statistics.rebuild(blocks, dictionary, tokenizer);
+    return statistics;
+}
+
+void OovStatistics::rebuild(const QVector<block>& blocks, QSharedPointer<const Dictionary> dictionary, const Tokenizer& tokenizer)
+{
+    clear();
+
+    // The dictionary is immutable, workers can share it without locking
+    std::function<BlockOov(const block&)> scanBlock = [dictionary, &tokenizer](const block& a_block) {
+        return scan(a_block, *dictionary, tokenizer);
+    };
+    m_blocks = QtConcurrent::blockingMapped(blocks, scanBlock);
+
+    for (auto& blockOov: qAsConst(m_blocks))
+        count(blockOov, 1);
+    m_dictionary = dictionary;
+    m_tokenizer = tokenizer;
+    m_built = true;
+}
+
+void OovStatistics::restore(const QVector<block>& blocks, const QVector<QVector<int>>& wordNumbers,
+                            QSharedPointer<const Dictionary> dictionary, const Tokenizer& tokenizer)
+{
+    clear();
+    if (wordNumbers.size() != blocks.size())
+        return;
+
+    m_blocks.resize(blocks.size());
+    for (int i = 0; i < blocks.size(); i++) {
+        auto& blockOov = m_blocks[i];
+        blockOov.speaker = blocks[i].speaker;
+        blockOov.time = blocks[i].timeStamp.isValid() ? blocks[i].timeStamp.msecsSinceStartOfDay() : -1;
+
+        for (auto wordNumber: wordNumbers[i]) {
+            if (wordNumber < 0 || wordNumber >= blocks[i].words.size())
+                continue;
+            blockOov.wordNumbers.append(wordNumber);
+            blockOov.words.append(tokenizer.normalized(blocks[i].words[wordNumber].text));
+        }
+        count(blockOov, 1);
+    }
+    m_dictionary = dictionary;
+    m_tokenizer = tokenizer;
+    m_built = true;
+}
+
+void OovStatistics::clear()
+{
+    m_blocks.clear();
+    m_counts.clear();
+    m_tokens = 0;
+    m_built = false;
+}
+
+void OovStatistics::blocksInserted(int first, int count)
+{
+    if (!m_built || first < 0 || first > m_blocks.size())
+        return;
+
+    m_blocks.insert(first, count, BlockOov());
+}
+
+void OovStatistics::blocksRemoved(int first, int count)
+{
+    if (!m_built || first < 0 || first + count > m_blocks.size())
+        return;
+
+    for (int i = first; i < first + count; i++)
+        this->count(m_blocks[i], -1);
+    m_blocks.remove(first, count);
+}
+
+void OovStatistics::update(int first, int last, const QVector<block>& blocks)
+{
+    if (!m_built)
+        return;
+
+    // A missed structural change, start over instead of guessing
+    if (m_blocks.size() != blocks.size()) {
+        rebuild(blocks, m_dictionary, m_tokenizer);
+        return;
+    }
+
+    for (int i = qMax(first, 0); i <= last && i < blocks.size(); i++) {
+        count(m_blocks[i], -1);
+        m_blocks[i] = scan(blocks[i], *m_dictionary, m_tokenizer);
+        count(m_blocks[i], 1);
+    }
+}
+
+void OovStatistics::removeWords(const QStringList& words)
+{
+    QSet<QString> removed;
+    for (auto& a_word: words)
+        if (m_counts.contains(a_word))
+            removed.insert(a_word);
+
+    if (removed.isEmpty())
+        return;
+
+    for (auto& blockOov: m_blocks) {
+        for (int i = blockOov.words.size() - 1; i >= 0; i--) {
+            if (!removed.contains(blockOov.words[i]))
+                continue;
+            blockOov.words.removeAt(i);
+            blockOov.wordNumbers.remove(i);
+            m_tokens--;
+        }
+    }
+
+    for (auto& a_word: qAsConst(removed))
+        m_counts.remove(a_word);
+}
+
+const QVector<int>& OovStatistics::invalidWords(int blockNumber) const
+{
+    static const QVector<int> none;
+    return blockNumber >= 0 && blockNumber < m_blocks.size() ? m_blocks[blockNumber].wordNumbers : none;
+}
+
+QVector<QVector<int>> OovStatistics::invalidWordNumbers() const
+{
+    QVector<QVector<int>> wordNumbers(m_blocks.size());
+    for (int i = 0; i < m_blocks.size(); i++)
+        wordNumbers[i] = m_blocks[i].wordNumbers;
+    return wordNumbers;
+}
+
+QStringList OovStatistics::speakers() const
+{
+    QSet<QString> speakers;
+    for (auto& blockOov: m_blocks)
+        if (!blockOov.words.isEmpty())
+            speakers.insert(blockOov.speaker);
+
+    auto sorted = speakers.values();
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+QVector<OovEntry> OovStatistics::report(const QString& speaker, qint64 from, qint64 to) const
+{
+    QHash<QString, int> entryIndex;
+    QVector<OovEntry> entries;
+
+    for (auto& blockOov: m_blocks) {
+        if (!speaker.isEmpty() && blockOov.speaker != speaker)
+            continue;
+        if ((from >= 0 || to >= 0) && blockOov.time < 0)
+            continue;
+        if ((from >= 0 && blockOov.time < from) || (to >= 0 && blockOov.time > to))
+            continue;
+
+        auto time = blockOov.time < 0 ? QTime() : QTime(0, 0).addMSecs(blockOov.time);
+        for (auto& a_word: blockOov.words) {
+            auto it = entryIndex.constFind(a_word);
+            if (it == entryIndex.constEnd()) {
+                it = entryIndex.insert(a_word, entries.size());
+                entries.append({a_word, 0, {}, time, time});
+            }
+
+            auto& entry = entries[it.value()];
+            entry.count++;
+            entry.speakers[blockOov.speaker]++;
+            if (time.isValid()) {
+                if (!entry.first.isValid())
+                    entry.first = time;
+                entry.last = time;
+            }
+        }
+    }
+
+    return entries;
+}
+
+OovStatistics::BlockOov OovStatistics::scan(const block& a_block, const Dictionary& dictionary, const Tokenizer& tokenizer)
+{
+    BlockOov blockOov;
+    blockOov.speaker = a_block.speaker;
+    blockOov.time = a_block.timeStamp.isValid() ? a_block.timeStamp.msecsSinceStartOfDay() : -1;
+
+    for (int j = 0; j < a_block.words.size(); j++) {
+        auto wordText = tokenizer.normalized(a_block.words[j].text);
+        if (!wordText.isEmpty() && !dictionary.contains(wordText)) {
+            blockOov.wordNumbers.append(j);
+            blockOov.words.append(wordText);
+        }
+    }
+    return blockOov;
+}
+
+void OovStatistics::count(const BlockOov& blockOov, int sign)
+{
+    for (auto& a_word: blockOov.words) {
+        auto& wordCount = m_counts[a_word];
+        wordCount += sign;
+        if (!wordCount)
+            m_counts.remove(a_word);
+    }
+    m_tokens += sign * blockOov.words.size();
+}
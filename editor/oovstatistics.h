@@ -0,0 +1,73 @@
+#pragma once
+
+#include "blockobserver.h"
+#include "dictionarycache.h"
+#include "tokenizer.h"
+
+#include <QMap>
+#include <QHash>
+
+// One out-of-vocabulary word with where it occurs in the transcript
+struct OovEntry
+{
+    QString word;
+    int count{0};
+    QMap<QString, int> speakers;
+    QTime first, last;
+};
+
+// Out-of-vocabulary words of a transcript, kept per block so that an edit only
+// rescans the blocks it touched. Blocks are scanned in parallel on rebuild.
+// Edits are scanned with the dictionary and tokenizer of the last rebuild,
+// setDictionary() brings in words accepted since.
+class OovStatistics : public BlockObserver
+{
+public:
+    static OovStatistics build(const QVector<block>& blocks,
+                               QSharedPointer<const Dictionary> dictionary,
+                               const Tokenizer& tokenizer);
+
+    void rebuild(const QVector<block>& blocks, QSharedPointer<const Dictionary> dictionary, const Tokenizer& tokenizer);
+    // From the word numbers of an earlier scan, without looking anything up
+    void restore(const QVector<block>& blocks, const QVector<QVector<int>>& wordNumbers,
+                 QSharedPointer<const Dictionary> dictionary, const Tokenizer& tokenizer);
+    void clear();
+    bool isBuilt() const {return m_built;}
+    void setDictionary(QSharedPointer<const Dictionary> dictionary) {m_dictionary = dictionary;}
+
+    void blocksInserted(int first, int count) override;
+    void blocksRemoved(int first, int count) override;
+    void update(int first, int last, const QVector<block>& blocks) override;
+    // Words that became valid, e.g. accepted into the dictionary
+    void removeWords(const QStringList& words);
+
+    int tokenCount() const {return m_tokens;}
+    int wordCount() const {return m_counts.size();}
+    // Out-of-vocabulary word numbers of one block
+    const QVector<int>& invalidWords(int blockNumber) const;
+    QVector<QVector<int>> invalidWordNumbers() const;
+    QStringList speakers() const;
+
+    // Aggregated by word, an empty speaker and negative times don't filter.
+    // Blocks without a timestamp are left out once a time range is given.
+    QVector<OovEntry> report(const QString& speaker = QString(), qint64 from = -1, qint64 to = -1) const;
+
+private:
+    struct BlockOov
+    {
+        QString speaker;
+        qint64 time{-1};
+        QVector<int> wordNumbers;
+        QStringList words;
+    };
+
+    static BlockOov scan(const block& a_block, const Dictionary& dictionary, const Tokenizer& tokenizer);
+    void count(const BlockOov& blockOov, int sign);
+
+    QVector<BlockOov> m_blocks;
+    QHash<QString, int> m_counts;
+    int m_tokens{0};
+    bool m_built{false};
+    QSharedPointer<const Dictionary> m_dictionary;
+    Tokenizer m_tokenizer;
+};
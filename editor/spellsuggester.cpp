@@ -0,0 +1,186 @@
+#include "spellsuggester.h"
+
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+    // Indexes of languages nobody asked for lately are dropped
+    const int capacity = 2;
+
+    struct Indexes
+    {
+        QHash<QString, QSharedPointer<const SpellSuggester>> ready;
+        QSet<QString> building;
+        QStringList recentlyUsed;
+    };
+
+    Indexes& indexes()
+    {
+        static Indexes all;
+        return all;
+    }
+}
+
+SpellSuggester::SpellSuggester(QSharedPointer<const Dictionary> dictionary)
+    : m_dictionary(dictionary)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto& words = m_dictionary->words;
+    m_entries.reserve(size_t(words.size()) * 8);
+
+    for (int i = 0; i < words.size(); i++)
+        for (auto& a_delete: deletes(words[i].left(prefixLength)))
+            m_entries.push_back({qHash(a_delete), i});
+
+    std::sort(m_entries.begin(), m_entries.end());
+    m_entries.shrink_to_fit();
+
+    qInfo() << "[Suggestion Index Built]"
+            << QString("language: %1, %2 words, %3 entries in %4 ms")
+               .arg(m_dictionary->lang, QString::number(words.size()),
+                    QString::number(m_entries.size()), QString::number(timer.elapsed()));
+}
+
+QSharedPointer<const SpellSuggester> SpellSuggester::forDictionary(QSharedPointer<const Dictionary> dictionary)
+{
+    if (!dictionary || dictionary->lang.isEmpty())
+        return {};
+
+    auto& all = indexes();
+    auto lang = dictionary->lang;
+    auto current = all.ready.value(lang);
+
+    all.recentlyUsed.removeOne(lang);
+    all.recentlyUsed.prepend(lang);
+
+    // Rebuilt one at a time, words accepted meanwhile trigger the next one
+    if ((!current || current->dictionary() != dictionary) && !all.building.contains(lang)) {
+        all.building.insert(lang);
+
+        auto watcher = new QFutureWatcher<QSharedPointer<const SpellSuggester>>;
+        QObject::connect(watcher, &QFutureWatcherBase::finished, watcher,
+            [watcher, lang]()
+            {
+                auto& all = indexes();
+                all.building.remove(lang);
+                all.ready.insert(lang, watcher->result());
+
+                while (all.recentlyUsed.size() > capacity)
+                    all.ready.remove(all.recentlyUsed.takeLast());
+
+                watcher->deleteLater();
+            }
+        );
+        watcher->setFuture(QtConcurrent::run([dictionary]() {
+            return QSharedPointer<const SpellSuggester>(new SpellSuggester(dictionary));
+        }));
+    }
+
+    return current;
+}
+
+QStringList SpellSuggester::suggestions(const QString& word, int count) const
+{
+    if (word.isEmpty())
+        return {};
+
+    auto& words = m_dictionary->words;
+    QVector<int> candidates;
+
+    for (auto& a_delete: deletes(word.left(prefixLength))) {
+        Entry key{qHash(a_delete), 0};
+        auto first = std::lower_bound(m_entries.begin(), m_entries.end(), key);
+        for (auto it = first; it != m_entries.end() && it->hash == key.hash; ++it)
+            candidates.append(it->word);
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Hash collisions and edits outside the prefix are settled here
+    QVector<QPair<int, int>> ranked;
+    for (auto candidate: qAsConst(candidates)) {
+        auto& a_word = words[candidate];
+        if (qAbs(a_word.size() - word.size()) > maxDistance)
+            continue;
+
+        auto editDistance = distance(word, a_word, maxDistance);
+        if (editDistance > 0 && editDistance <= maxDistance)
+            ranked.append({editDistance, candidate});
+    }
+
+    std::sort(ranked.begin(), ranked.end(),
+              [&words, &word](const QPair<int, int>& a, const QPair<int, int>& b) {
+                  if (a.first != b.first)
+                      return a.first < b.first;
+                  auto aLength = qAbs(words[a.second].size() - word.size());
+                  auto bLength = qAbs(words[b.second].size() - word.size());
+                  return aLength != bLength ? aLength < bLength : a.second < b.second;
+              });
+
+    QStringList nearest;
+    for (int i = 0; i < ranked.size() && i < count; i++)
+        nearest << words[ranked[i].second];
+    return nearest;
+}
+
+int SpellSuggester::distance(const QString& a, const QString& b, int maxDistance)
+{
+    // Optimal string alignment, adjacent transpositions count as one edit
+    const int n = a.size(), m = b.size();
+    if (qAbs(n - m) > maxDistance)
+        return maxDistance + 1;
+
+    QVector<int> previous2(m + 1), previous(m + 1), current(m + 1);
+    for (int j = 0; j <= m; j++)
+        previous[j] = j;
+
+    for (int i = 1; i <= n; i++) {
+        current[0] = i;
+        int rowMinimum = current[0];
+
+        for (int j = 1; j <= m; j++) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                current[j] = std::min(current[j], previous2[j - 2] + 1);
+            rowMinimum = std::min(rowMinimum, current[j]);
+        }
+
+        if (rowMinimum > maxDistance)
+            return maxDistance + 1;
+
+        std::swap(previous2, previous);
+        std::swap(previous, current);
+    }
+
+    return previous[m];
+}
+
+QStringList SpellSuggester::deletes(const QString& word)
+{
+    QSet<QString> found{word};
+    QStringList level{word};
+
+    for (int d = 0; d < maxDistance; d++) {
+        QStringList next;
+        for (auto& a_word: qAsConst(level)) {
+            for (int i = 0; i < a_word.size(); i++) {
+                auto shorter = QString(a_word).remove(i, 1);
+                if (!found.contains(shorter)) {
+                    found.insert(shorter);
+                    next << shorter;
+                }
+            }
+        }
+        level = next;
+    }
+
+    return found.values();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "dictionarycache.h"
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <vector>
+
+// Correction suggestions over a dictionary with a symmetric delete index:
+// every word is stored under the strings its prefix turns into with up to
+// maxDistance deletions, a lookup generates the same deletions of the input
+// and checks the few words they lead to with the real edit distance.
+//
+// Only hashes of the deletions are kept, next to the word they came from, in
+// one sorted array. That keeps a 100k word list at a few ten megabytes.
+class SpellSuggester
+{
+public:
+    static const int maxDistance = 2;
+    static const int prefixLength = 7;
+
+    explicit SpellSuggester(QSharedPointer<const Dictionary> dictionary);
+
+    // The latest index of the dictionary's language, null while the first one
+    // is built. Starts a rebuild in the background when it is out of date.
+    static QSharedPointer<const SpellSuggester> forDictionary(QSharedPointer<const Dictionary> dictionary);
+
+    QSharedPointer<const Dictionary> dictionary() const {return m_dictionary;}
+    // Nearest words first, expects a word in Tokenizer::normalized() form
+    QStringList suggestions(const QString& word, int count = 5) const;
+
+    static int distance(const QString& a, const QString& b, int maxDistance);
+
+private:
+    struct Entry
+    {
+        uint hash;
+        int word;
+
+        bool operator<(const Entry& other) const
+        {
+            return hash < other.hash || (hash == other.hash && word < other.word);
+        }
+    };
+
+    static QStringList deletes(const QString& word);
+
+    QSharedPointer<const Dictionary> m_dictionary;
+    std::vector<Entry> m_entries;
+};
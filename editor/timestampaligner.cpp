@@ -0,0 +1,144 @@
+#include "timestampaligner.h"
+
+#include <QtConcurrent>
+#include <limits>
+
+namespace {
+    const qint64 snapRadius = 150;
+    const qint64 snapStep = 10;
+
+    struct AlignmentTask
+    {
+        int blockNumber;
+        qint64 blockStart;
+        AlignmentReport report;
+    };
+
+    bool hasMissingTimeStamp(const block& a_block)
+    {
+        for (auto& a_word: a_block.words)
+            if (a_word.timeStamp.isNull())
+                return true;
+        return false;
+    }
+}
+
+AlignmentReport TimeStampAligner::alignBlock(block& a_block, qint64 blockStart) const
+{
+    AlignmentReport report;
+    auto& words = a_block.words;
+    const QTime zero(0, 0);
+
+    if (a_block.timeStamp.isNull() || words.isEmpty())
+        return report;
+
+    qint64 blockEnd = zero.msecsTo(a_block.timeStamp);
+    if (blockEnd <= blockStart)
+        return report;
+
+    int anchorIndex = -1;
+    qint64 anchorTime = blockStart;
+
+    for (int i = 0; i < words.size(); i++) {
+        bool isLast = (i == words.size() - 1);
+        bool known = words[i].timeStamp.isValid();
+        qint64 knownTime = known ? zero.msecsTo(words[i].timeStamp) : 0;
+
+        // Known times that go backwards or leave the block can't anchor a gap
+        bool isAnchor = known && knownTime >= anchorTime && knownTime <= blockEnd;
+        if (!isAnchor && !isLast)
+            continue;
+
+        qint64 nextTime = isAnchor ? knownTime : blockEnd;
+
+        int totalLength = 0;
+        for (int j = anchorIndex + 1; j <= i; j++)
+            totalLength += qMax(1, words[j].text.size());
+
+        int lengthSoFar = 0;
+        qint64 previousEnd = anchorTime;
+        for (int j = anchorIndex + 1; j < i; j++) {
+            lengthSoFar += qMax(1, words[j].text.size());
+            if (words[j].timeStamp.isValid())
+                continue;
+
+            qint64 estimate = anchorTime + (nextTime - anchorTime) * lengthSoFar / totalLength;
+            qint64 lower = qMax(previousEnd + 1, estimate - snapRadius);
+            qint64 upper = qMin(nextTime - 1, estimate + snapRadius);
+            qint64 end = (lower <= upper) ? quietestPoint(estimate, lower, upper)
+                                          : qBound(previousEnd, estimate, nextTime);
+
+            words[j].timeStamp = zero.addMSecs(static_cast<int>(end));
+            previousEnd = end;
+
+            auto shift = qAbs(end - estimate);
+            report.filled++;
+            report.totalShift += shift;
+            report.maxShift = qMax(report.maxShift, shift);
+        }
+
+        // The last word always ends with the block
+        if (isLast && !known) {
+            words[i].timeStamp = a_block.timeStamp;
+            report.filled++;
+        }
+
+        anchorIndex = i;
+        anchorTime = nextTime;
+    }
+
+    return report;
+}
+
+AlignmentReport TimeStampAligner::alignAll(QVector<block>& blocks) const
+{
+    QVector<AlignmentTask> tasks;
+    const QTime zero(0, 0);
+
+    // A block starts where the last timed block before it ended
+    qint64 blockStart = 0;
+    for (int i = 0; i < blocks.size(); i++) {
+        if (hasMissingTimeStamp(blocks[i]))
+            tasks.append({i, blockStart, AlignmentReport()});
+        if (blocks[i].timeStamp.isValid())
+            blockStart = zero.msecsTo(blocks[i].timeStamp);
+    }
+
+    // Detach once up front, the workers only touch their own blocks
+    block* data = blocks.data();
+    QtConcurrent::blockingMap(tasks,
+                              [this, data](AlignmentTask& task)
+                              {
+                                  task.report = alignBlock(data[task.blockNumber], task.blockStart);
+                              });
+
+    AlignmentReport report;
+    for (auto& task: qAsConst(tasks)) {
+        report.filled += task.report.filled;
+        report.totalShift += task.report.totalShift;
+        report.maxShift = qMax(report.maxShift, task.report.maxShift);
+    }
+
+    return report;
+}
+
+qint64 TimeStampAligner::quietestPoint(qint64 estimate, qint64 lower, qint64 upper) const
+{
+    if (!m_envelope || m_envelope->isEmpty())
+        return qBound(lower, estimate, upper);
+
+    qint64 best = qBound(lower, estimate, upper);
+    int bestEnergy = std::numeric_limits<int>::max();
+
+    for (qint64 t = lower; t <= upper; t += snapStep) {
+        auto peak = m_envelope->peakInRange(t - snapStep / 2, t + snapStep / 2);
+        int energy = qMax(qAbs(int(peak.min)), qAbs(int(peak.max)));
+
+        if (energy < bestEnergy || (energy == bestEnergy && qAbs(t - estimate) < qAbs(best - estimate))) {
+            bestEnergy = energy;
+            best = t;
+        }
+    }
+
+    return best;
+}
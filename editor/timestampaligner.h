@@ -0,0 +1,31 @@
+#pragma once
+
+#include "blockandword.h"
+#include "mediaplayer/peakpyramid.h"
+
+struct AlignmentReport
+{
+    int filled{0};
+    qint64 totalShift{0};
+    qint64 maxShift{0};
+
+    qint64 meanShift() const {return filled ? totalShift / filled : 0;}
+};
+
+// Estimates missing word end-times from the neighbouring known timestamps. Each
+// gap is first split in proportion to word length, then every boundary is
+// moved to the quietest point of the audio envelope close to the estimate.
+// The reported shift is how far that snapping moved the boundaries.
+class TimeStampAligner
+{
+public:
+    explicit TimeStampAligner(QSharedPointer<const PeakPyramid> envelope = {}) : m_envelope(envelope) {}
+
+    AlignmentReport alignBlock(block& a_block, qint64 blockStart) const;
+    AlignmentReport alignAll(QVector<block>& blocks) const;
+
+private:
+    qint64 quietestPoint(qint64 estimate, qint64 lower, qint64 upper) const;
+
+    QSharedPointer<const PeakPyramid> m_envelope;
+};
@@ -0,0 +1,102 @@
+#include "tokenizer.h"
+
+#include <QFile>
+
+namespace {
+    const QChar zeroWidthNonJoiner(0x200C), zeroWidthJoiner(0x200D);
+
+    // Latin sentence punctuation, quotes and brackets, danda and double danda
+    const QString defaultPunctuation = QString::fromUtf8(",.!?;:\"'()[]{}“”‘’|।॥");
+
+    // Grapheme break rules GB9 and GB9a: extending marks and joiners attach to
+    // whatever precedes them, whitespace included
+    inline bool extendsCluster(QChar c)
+    {
+        return c.isMark() || c == zeroWidthJoiner || c == zeroWidthNonJoiner;
+    }
+
+    inline bool isSeparator(const QString& text, int i, int to)
+    {
+        return text[i].isSpace() && !(i + 1 < to && extendsCluster(text[i + 1]));
+    }
+}
+
+Tokenizer::Tokenizer(const QString& lang)
+    : m_lang(lang), m_punctuation(punctuationFor(lang))
+{
+}
+
+QVector<TokenSpan> Tokenizer::spans(const QString& text, int from, int to)
+{
+    if (to < 0 || to > text.size())
+        to = text.size();
+
+    QVector<TokenSpan> spans;
+    int start{-1};
+
+    for (int i = qMax(from, 0); i < to; i++) {
+        if (isSeparator(text, i, to)) {
+            if (start != -1)
+                spans.append({start, i - start});
+            start = -1;
+        }
+        else if (start == -1)
+            start = i;
+    }
+    if (start != -1)
+        spans.append({start, to - start});
+
+    return spans;
+}
+
+QStringList Tokenizer::words(const QString& text)
+{
+    QStringList words;
+    for (auto& span: spans(text))
+        words << text.mid(span.start, span.length);
+    return words;
+}
+
+QString Tokenizer::canonical(const QString& word)
+{
+    auto wordText = word.normalized(QString::NormalizationForm_C);
+
+    if (wordText.contains(zeroWidthJoiner) || wordText.contains(zeroWidthNonJoiner)) {
+        wordText.remove(zeroWidthJoiner);
+        wordText.remove(zeroWidthNonJoiner);
+    }
+
+    return wordText.toLower();
+}
+
+QString Tokenizer::normalized(const QString& word) const
+{
+    auto wordText = canonical(word);
+    auto span = core(wordText);
+
+    return (span.length == wordText.size()) ? wordText : wordText.mid(span.start, span.length);
+}
+
+TokenSpan Tokenizer::core(const QString& word) const
+{
+    int start{0}, end = word.size();
+    while (start < end && m_punctuation.contains(word[start]))
+        start++;
+    while (end > start && m_punctuation.contains(word[end - 1]))
+        end--;
+
+    return {start, end - start};
+}
+
+QString Tokenizer::punctuationFor(const QString& lang)
+{
+    QFile punctuationFile(QString("punctuation_%1.txt").arg(lang));
+    if (!punctuationFile.open(QFile::ReadOnly))
+        return defaultPunctuation;
+
+    QString punctuation;
+    for (auto c: QString::fromUtf8(punctuationFile.readAll()))
+        if (!c.isSpace())
+            punctuation += c;
+    return punctuation;
+}
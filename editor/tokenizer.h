@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct TokenSpan
+{
+    int start{0}, length{0};
+
+    int end() const {return start + length;}
+};
+
+// The one place lines are cut into words and words are brought into the form
+// they are looked up in. Splitting happens on whitespace that stands alone as
+// a grapheme, so a matra or a joiner typed after a space stays with its word.
+// Normalising applies NFC, drops zero-width joiners and trims the punctuation
+// of the transcript language (dandas included) from both ends.
+class Tokenizer
+{
+public:
+    explicit Tokenizer(const QString& lang = "english");
+
+    const QString& lang() const {return m_lang;}
+    const QString& punctuation() const {return m_punctuation;}
+
+    static QVector<TokenSpan> spans(const QString& text, int from = 0, int to = -1);
+    static QStringList words(const QString& text);
+
+    // NFC without joiners, lower case. Dictionaries store words in this form.
+    static QString canonical(const QString& word);
+    // canonical() without leading and trailing punctuation
+    QString normalized(const QString& word) const;
+    // Where the word is without its leading and trailing punctuation
+    TokenSpan core(const QString& word) const;
+
+    // Defaults shared by every language, punctuation_<lang>.txt replaces them
+    static QString punctuationFor(const QString& lang);
+
+private:
+    QString m_lang, m_punctuation;
+};
@@ -0,0 +1,191 @@
+#include "transcriptcache.h"
+
+#include <QDir>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <limits>
+
+namespace {
+    const quint32 cacheMagic = 0x5452534e; // "TRSN"
+    const quint16 cacheVersion = 3;
+    // Fixed so snapshots read back the same whatever Qt wrote them
+    const int streamVersion = QDataStream::Qt_5_12;
+
+    void writeBlock(QDataStream& out, const block& a_block, const QVector<int>& invalidWords)
+    {
+        out << a_block.timeStamp << a_block.text << a_block.speaker << a_block.tagList << a_block.confidence;
+        out << qint32(a_block.words.size());
+        for (auto& a_word: a_block.words)
+            out << a_word.timeStamp << a_word.text << a_word.tagList << a_word.confidence;
+        out << invalidWords;
+    }
+
+    // Counts are checked against the bytes left before anything is allocated,
+    // a damaged snapshot can't ask for more items than it could hold
+    bool readCount(QDataStream& in, qint64 itemSize, int& count)
+    {
+        quint32 n;
+        in >> n;
+        if (in.status() != QDataStream::Ok)
+            return false;
+        if (n > quint32(std::numeric_limits<int>::max()) || qint64(n) * itemSize > in.device()->bytesAvailable()) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            return false;
+        }
+        count = int(n);
+        return true;
+    }
+
+    void readStringList(QDataStream& in, QStringList& list)
+    {
+        int count;
+        list.clear();
+        if (!readCount(in, sizeof(quint32), count))
+            return;
+
+        list.reserve(count);
+        for (int i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+            QString text;
+            in >> text;
+            list.append(text);
+        }
+    }
+
+    void readBlock(QDataStream& in, block& a_block, QVector<int>& invalidWords)
+    {
+        // A word takes at least its time, two empty lengths and its confidence
+        const qint64 minWordSize = 3 * sizeof(quint32) + sizeof(double);
+
+        int wordCount;
+        in >> a_block.timeStamp >> a_block.text >> a_block.speaker;
+        readStringList(in, a_block.tagList);
+        in >> a_block.confidence;
+        if (in.status() != QDataStream::Ok || !readCount(in, minWordSize, wordCount))
+            return;
+
+        a_block.words.resize(wordCount);
+        for (int i = 0; i < wordCount && in.status() == QDataStream::Ok; i++) {
+            auto& a_word = a_block.words[i];
+            in >> a_word.timeStamp >> a_word.text;
+            readStringList(in, a_word.tagList);
+            in >> a_word.confidence;
+        }
+
+        int invalidCount;
+        if (in.status() != QDataStream::Ok || !readCount(in, sizeof(qint32), invalidCount))
+            return;
+        invalidWords.resize(invalidCount);
+        for (auto& wordNumber: invalidWords)
+            in >> wordNumber;
+    }
+}
+
+bool TranscriptCache::load(const QString& transcriptFileName, TranscriptSnapshot& snapshot)
+{
+    QFileInfo info(transcriptFileName);
+    if (!info.exists())
+        return false;
+
+    QFile file(cacheFileName(info));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    auto size = file.size();
+    auto map = (size > 0 && size <= std::numeric_limits<int>::max()) ? file.map(0, size) : nullptr;
+    if (!map)
+        return false;
+
+    QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char*>(map), int(size)));
+    in.setVersion(streamVersion);
+    quint32 magic;
+    quint16 version;
+    QString path;
+    qint64 fileSize, modified;
+    quint64 dictionaryKey;
+    qint32 blockCount;
+
+    // The key comes first, a changed transcript costs a few bytes to notice
+    in >> magic >> version >> path >> fileSize >> modified;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion
+            || path != info.canonicalFilePath() || fileSize != info.size()
+            || modified != info.lastModified().toMSecsSinceEpoch()) {
+        file.unmap(map);
+        file.remove();
+        return false;
+    }
+
+    TranscriptSnapshot loaded;
+    in >> loaded.transcript.lang >> dictionaryKey >> blockCount;
+    if (in.status() == QDataStream::Ok && blockCount >= 0 && blockCount < size) {
+        loaded.dictionaryKey = dictionaryKey;
+        loaded.transcript.blocks.resize(blockCount);
+        loaded.invalidWords.resize(blockCount);
+        for (int i = 0; i < blockCount && in.status() == QDataStream::Ok; i++)
+            readBlock(in, loaded.transcript.blocks[i], loaded.invalidWords[i]);
+    }
+
+    auto ok = in.status() == QDataStream::Ok && blockCount >= 0 && blockCount < size;
+    file.unmap(map);
+    if (!ok)
+        return false;
+
+    // Loading counts as use for the least recently used order
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    snapshot = loaded;
+    return true;
+}
+
+bool TranscriptCache::store(const QString& transcriptFileName, qint64 size, const QDateTime& lastModified,
+                            const TranscriptSnapshot& snapshot)
+{
+    QFileInfo info(transcriptFileName);
+    if (!info.exists())
+        return false;
+
+    QDir().mkpath(directory());
+    QSaveFile file(cacheFileName(info));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    auto& blocks = snapshot.transcript.blocks;
+    QDataStream out(&file);
+    out.setVersion(streamVersion);
+    out << cacheMagic << cacheVersion << info.canonicalFilePath() << size << lastModified.toMSecsSinceEpoch();
+    out << snapshot.transcript.lang << snapshot.dictionaryKey << qint32(blocks.size());
+    for (int i = 0; i < blocks.size(); i++)
+        writeBlock(out, blocks[i], snapshot.invalidWords.value(i));
+
+    if (out.status() != QDataStream::Ok || !file.commit())
+        return false;
+
+    evict();
+    return true;
+}
+
+void TranscriptCache::evict(qint64 limit)
+{
+    qint64 used{0};
+
+    // Newest first, so whatever is past the limit is least recently used
+    auto entries = QDir(directory()).entryInfoList({"*.transcript"}, QDir::Files, QDir::Time);
+    for (auto& entry: qAsConst(entries)) {
+        used += entry.size();
+        if (used > limit && QFile::remove(entry.absoluteFilePath()))
+            qInfo() << "[Transcript Cache]" << QString("evicted %1").arg(entry.fileName());
+    }
+}
+
+QString TranscriptCache::directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/transcripts";
+}
+
+QString TranscriptCache::cacheFileName(const QFileInfo& transcriptInfo)
+{
+    auto hash = QCryptographicHash::hash(transcriptInfo.canonicalFilePath().toUtf8(), QCryptographicHash::Sha1);
+    return directory() + "/" + QString::fromLatin1(hash.toHex()) + ".transcript";
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "transcriptreader.h"
+
+#include <QFileInfo>
+
+// A parsed transcript with the words its dictionary scan flagged, per block.
+// The scan is current while the dictionary fingerprint and the punctuation it
+// was made with still give the same key, 0 when there was no scan.
+struct TranscriptSnapshot
+{
+    TranscriptData transcript;
+    QVector<QVector<int>> invalidWords;
+    quint64 dictionaryKey{0};
+};
+
+// Binary snapshots of parsed transcripts in the user cache, so reopening an
+// unchanged file skips the XML and the dictionary scan. A snapshot is keyed
+// on the canonical path, size and modification time of its transcript and
+// read with a single mmap. The least recently used ones are dropped once the
+// directory outgrows its limit.
+class TranscriptCache
+{
+public:
+    static const qint64 sizeLimit = 256 * 1024 * 1024;
+
+    static bool load(const QString& transcriptFileName, TranscriptSnapshot& snapshot);
+    // Keyed on the size and modification time the transcript had when the
+    // snapshot was taken, in case it changes again before this runs
+    static bool store(const QString& transcriptFileName, qint64 size, const QDateTime& lastModified,
+                      const TranscriptSnapshot& snapshot);
+    static void evict(qint64 limit = sizeLimit);
+
+    static QString directory();
+    static QString cacheFileName(const QFileInfo& transcriptInfo);
+};
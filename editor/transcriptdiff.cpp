@@ -0,0 +1,295 @@
+#include "transcriptdiff.h"
+#include "editdistance.h"
+#include "blocktimeindex.h"
+#include "transcriptimporter.h"
+#include "transcriptwriter.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QHash>
+#include <QDebug>
+#include <algorithm>
+
+void TranscriptDiff::setBaseline(const TranscriptData& loaded, const QString& transcriptFileName)
+{
+    clear();
+    m_baseline = loaded;
+    m_transcriptFileName = transcriptFileName;
+    m_baselineSaved = !transcriptFileName.isEmpty() && QFileInfo::exists(baselineFileName(transcriptFileName));
+    m_baselinePending = m_baselineSaved;
+    m_prepared = false;
+}
+
+bool TranscriptDiff::saveBaseline(QString& errorString)
+{
+    if (m_baselineSaved || m_transcriptFileName.isEmpty() || m_baseline.blocks.isEmpty())
+        return true;
+
+    QSaveFile file(baselineFileName(m_transcriptFileName));
+    if (!file.open(QIODevice::WriteOnly) || !TranscriptWriter::write(&file, m_baseline.lang, m_baseline.blocks)
+            || !file.commit()) {
+        errorString = file.errorString();
+        return false;
+    }
+
+    // The baseline in memory is what was written, it isn't read back
+    m_baselineSaved = true;
+    return true;
+}
+
+QString TranscriptDiff::baselineFileName(const QString& transcriptFileName)
+{
+    return transcriptFileName + ".baseline";
+}
+
+void TranscriptDiff::rebuild(const QVector<block>& blocks, BlockTimeIndex& timeIndex)
+{
+    prepare();
+    clear();
+    m_active = true;
+    m_timeIndex = &timeIndex;
+    if (m_timed && !m_timeIndex->isValid())
+        m_timeIndex->rebuild(blocks);
+
+    m_blocks.resize(blocks.size());
+    for (int i = 0; i < blocks.size(); i++)
+        compare(i, blocks);
+    m_comparedFirst = 0;
+    m_comparedLast = blocks.size() - 1;
+}
+
+void TranscriptDiff::clear()
+{
+    m_blocks.clear();
+    m_count = 0;
+    m_active = false;
+}
+
+void TranscriptDiff::blocksInserted(int at, int count)
+{
+    if (!m_active || at < 0 || at > m_blocks.size() || count <= 0)
+        return;
+
+    m_blocks.insert(at, count, QVector<Change>());
+}
+
+void TranscriptDiff::blocksRemoved(int at, int count)
+{
+    if (!m_active || at < 0 || count <= 0 || at + count > m_blocks.size())
+        return;
+
+    for (int i = at; i < at + count; i++)
+        m_count -= m_blocks[i].size();
+    m_blocks.remove(at, count);
+}
+
+void TranscriptDiff::update(int first, int last, const QVector<block>& blocks)
+{
+    if (!m_active)
+        return;
+    if (m_blocks.size() != blocks.size()) {
+        rebuild(blocks, *m_timeIndex);
+        return;
+    }
+    if (m_timed && !m_timeIndex->isValid())
+        m_timeIndex->rebuild(blocks);
+
+    // The last line takes whatever the baseline has after it
+    first = qMax(first, 0);
+    if (first > 0 && last >= blocks.size() - 1)
+        first--;
+
+    int i = first;
+    for (; i <= last && i < blocks.size(); i++)
+        compare(i, blocks);
+    m_comparedFirst = first;
+    m_comparedLast = i - 1;
+    for (; m_timed && i < blocks.size(); i++) {
+        compare(i, blocks);
+        m_comparedLast = i;
+        if (blocks[i].timeStamp.isValid())
+            break;
+    }
+}
+
+const QVector<TranscriptDiff::Change>& TranscriptDiff::changes(int blockNumber) const
+{
+    static const QVector<Change> none;
+    return blockNumber >= 0 && blockNumber < m_blocks.size() ? m_blocks[blockNumber] : none;
+}
+
+bool TranscriptDiff::next(int& blockNumber, int& wordNumber) const
+{
+    if (!m_count)
+        return false;
+
+    for (int i = qMax(blockNumber, 0); i < m_blocks.size(); i++) {
+        for (auto& change: m_blocks[i]) {
+            if (i > blockNumber || change.word > wordNumber) {
+                blockNumber = i;
+                wordNumber = change.word;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool TranscriptDiff::previous(int& blockNumber, int& wordNumber) const
+{
+    if (!m_count)
+        return false;
+
+    for (int i = qMin(blockNumber, m_blocks.size() - 1); i >= 0; i--) {
+        auto& changes = m_blocks[i];
+        for (int j = changes.size() - 1; j >= 0; j--) {
+            if (i < blockNumber || changes[j].word < wordNumber) {
+                blockNumber = i;
+                wordNumber = changes[j].word;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TranscriptDiff::prepare()
+{
+    if (m_baselinePending) {
+        m_baselinePending = false;
+
+        TranscriptData saved;
+        QString error;
+        auto fileName = baselineFileName(m_transcriptFileName);
+        if (TranscriptImporter::readFile(fileName, saved, error))
+            m_baseline = saved;
+        else
+            qInfo() << "[Baseline]" << QString("%1 not read: %2").arg(fileName, error);
+        m_prepared = false;
+    }
+    if (m_prepared)
+        return;
+
+    m_words.clear();
+    m_ends.clear();
+    m_lineStarts.clear();
+
+    qint64 end = -1;
+    for (auto& a_block: qAsConst(m_baseline.blocks)) {
+        auto lineEnd = BlockTimeIndex::toPosition(a_block.timeStamp);
+        m_lineStarts.append(m_words.size());
+
+        for (auto& a_word: a_block.words) {
+            if (a_word.text.isEmpty())
+                continue;
+
+            auto wordEnd = BlockTimeIndex::toPosition(a_word.timeStamp);
+            end = qMax(end, wordEnd != -1 ? wordEnd : lineEnd);
+            m_words.append(a_word.text);
+            m_ends.append(end);
+        }
+        end = qMax(end, lineEnd);
+    }
+    m_timed = end != -1;
+    m_prepared = true;
+}
+
+void TranscriptDiff::compare(int blockNumber, const QVector<block>& blocks)
+{
+    auto& a_block = blocks[blockNumber];
+    bool lastLine = blockNumber == blocks.size() - 1;
+
+    // The baseline words that end after the last timed line before this one
+    // and up to its own end
+    int begin{0}, end{0};
+    if (m_timed) {
+        // 0 without a timed line before it
+        auto start = m_timeIndex->blockStart(blockNumber);
+        if (start > 0)
+            begin = int(std::upper_bound(m_ends.begin(), m_ends.end(), start) - m_ends.begin());
+
+        auto lineEnd = BlockTimeIndex::toPosition(a_block.timeStamp);
+        if (lastLine)
+            end = m_words.size();
+        else if (lineEnd != -1)
+            end = int(std::upper_bound(m_ends.begin(), m_ends.end(), lineEnd) - m_ends.begin());
+        end = qMax(begin, end);
+    }
+    else if (blockNumber < m_lineStarts.size()) {
+        begin = m_lineStarts[blockNumber];
+        end = lastLine || blockNumber + 1 == m_lineStarts.size() ? m_words.size() : m_lineStarts[blockNumber + 1];
+    }
+
+    QVector<int> present;
+    for (int j = 0; j < a_block.words.size(); j++)
+        if (!a_block.words[j].text.isEmpty())
+            present.append(j);
+
+    auto& changes = m_blocks[blockNumber];
+    m_count -= changes.size();
+    changes.clear();
+
+    bool unchanged = present.size() == end - begin;
+    for (int j = 0; unchanged && j < present.size(); j++)
+        unchanged = a_block.words[present[j]].text == m_words[begin + j];
+
+    if (!unchanged) {
+        QVector<EditDistance::Operation> operations;
+        if (end - begin > maxAlignedWords || present.size() > maxAlignedWords) {
+            operations.fill(EditDistance::Deletion, end - begin);
+            operations.insert(operations.end(), present.size(), EditDistance::Insertion);
+        }
+        else {
+            // Ids only have to agree within the line
+            QHash<QString, int> ids;
+            auto idOf = [&ids](const QString& text) {
+                auto it = ids.find(text);
+                if (it == ids.end())
+                    it = ids.insert(text, ids.size());
+                return it.value();
+            };
+
+            QVector<int> reference, hypothesis;
+            for (int i = begin; i < end; i++)
+                reference.append(idOf(m_words[i]));
+            for (auto j: qAsConst(present))
+                hypothesis.append(idOf(a_block.words[j].text));
+            operations = EditDistance::align(reference, hypothesis);
+        }
+
+        int i = begin, h = 0;
+        QStringList deleted;
+        auto flush = [&]() {
+            if (deleted.isEmpty())
+                return;
+            if (h < present.size())
+                changes.append(Change{Change::Deleted, present[h], false, deleted.join(' ')});
+            else
+                changes.append(Change{Change::Deleted, present.isEmpty() ? -1 : present.last(), true, deleted.join(' ')});
+            deleted.clear();
+        };
+
+        for (auto operation: qAsConst(operations)) {
+            switch (operation) {
+            case EditDistance::Deletion:
+                deleted.append(m_words[i++]);
+                break;
+            case EditDistance::Hit:
+                flush();
+                i++, h++;
+                break;
+            case EditDistance::Substitution:
+                flush();
+                changes.append(Change{Change::Substituted, present[h++], false, m_words[i++]});
+                break;
+            case EditDistance::Insertion:
+                flush();
+                changes.append(Change{Change::Inserted, present[h++], false, QString()});
+                break;
+            }
+        }
+        flush();
+    }
+
+    m_count += changes.size();
+}
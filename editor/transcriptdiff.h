@@ -0,0 +1,84 @@
+#pragma once
+
+#include "transcriptreader.h"
+#include "blockobserver.h"
+
+class BlockTimeIndex;
+
+// Word level changes of the open transcript against the one that was loaded,
+// which is kept untouched as the baseline. A line is compared with the
+// baseline words that end within its time span, so split, merged and retimed
+// lines find their words without aligning the whole transcript. Only the
+// lines an edit touched are compared again.
+class TranscriptDiff : public BlockObserver
+{
+public:
+    struct Change
+    {
+        enum Kind : char {Inserted, Substituted, Deleted};
+
+        Kind kind;
+        // The word it is on. Deleted words were before it, or after it when
+        // atEnd is set, and -1 is a line that has no words left.
+        int word;
+        bool atEnd;
+        // The baseline words, empty for insertions
+        QString original;
+    };
+
+    // Longer lines are shown as replaced as a whole instead of aligned
+    static const int maxAlignedWords = 4000;
+
+    // The transcript as it was loaded. A baseline saved beside the transcript
+    // by an earlier session takes its place, read on the first rebuild().
+    void setBaseline(const TranscriptData& loaded, const QString& transcriptFileName);
+    // Before the transcript is first overwritten, the baseline is written
+    // beside it. Nothing is written once it is there.
+    bool saveBaseline(QString& errorString);
+    static QString baselineFileName(const QString& transcriptFileName);
+
+    // Compares every line, clear() stops comparing and keeps the baseline.
+    // Line starts are looked up in the time index, which has to be notified
+    // of the same edits ahead of this one; it is rebuilt while invalid.
+    void rebuild(const QVector<block>& blocks, BlockTimeIndex& timeIndex);
+    void clear();
+    bool isActive() const {return m_active;}
+
+    // Lines after the updated ones start later or earlier with them and are
+    // compared again up to the next timed one
+    void blocksInserted(int at, int count) override;
+    void blocksRemoved(int at, int count) override;
+    void update(int first, int last, const QVector<block>& blocks) override;
+
+    // The lines the last rebuild() or update() compared
+    int comparedFirst() const {return m_comparedFirst;}
+    int comparedLast() const {return m_comparedLast;}
+
+    int count() const {return m_count;}
+    const QVector<Change>& changes(int blockNumber) const;
+
+    // The closest changed word after or before the given one
+    bool next(int& blockNumber, int& wordNumber) const;
+    bool previous(int& blockNumber, int& wordNumber) const;
+
+private:
+    void prepare();
+    void compare(int blockNumber, const QVector<block>& blocks);
+
+    TranscriptData m_baseline;
+    QString m_transcriptFileName;
+    bool m_baselineSaved{false}, m_baselinePending{false}, m_prepared{false};
+
+    // Every baseline word with its end time, untimed ones end with their
+    // line. Without any times lines are compared by number instead.
+    QVector<QString> m_words;
+    QVector<qint64> m_ends;
+    QVector<int> m_lineStarts;
+    bool m_timed{false};
+    BlockTimeIndex* m_timeIndex{nullptr};
+
+    QVector<QVector<Change>> m_blocks;
+    int m_count{0};
+    int m_comparedFirst{0}, m_comparedLast{-1};
+    bool m_active{false};
+};
@@ -0,0 +1,369 @@
+#include "transcriptexporter.h"
+#include "blocktimeindex.h"
+#include "transcriptreader.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <functional>
+
+namespace {
+    struct Interval
+    {
+        qint64 start, end;
+        QString text;
+    };
+
+    QStringList wrap(const QStringList& words, int width)
+    {
+        QStringList lines;
+        for (auto& a_word: words) {
+            if (lines.isEmpty() || lines.last().size() + 1 + a_word.size() > width)
+                lines.append(a_word);
+            else
+                lines.last() += " " + a_word;
+        }
+        return lines;
+    }
+
+    // The narrowest wrap that needs no more lines than the widest one, so two
+    // line cues come out about even instead of a full line over a short one
+    QStringList balance(const QStringList& words, int lineCount, int maxLineLength)
+    {
+        auto length = words.join(" ").size();
+        for (int width = (length + lineCount - 1) / lineCount; width < maxLineLength; width++) {
+            auto lines = wrap(words, width);
+            if (lines.size() <= lineCount)
+                return lines;
+        }
+        return wrap(words, maxLineLength);
+    }
+
+    void appendCues(const QVector<block>& blocks, int blockNumber, const BlockTimeIndex& index,
+                    const SubtitleOptions& options, QVector<TranscriptExporter::Cue>& cues)
+    {
+        auto& a_block = blocks[blockNumber];
+        auto maxLineLength = qMax(1, options.maxLineLength);
+        auto maxLines = qMax(1, options.maxLines);
+        auto blockEnd = index.blockEnd(blockNumber);
+
+        // A line without words is cut at its spaces and only timed as a whole
+        QVector<Interval> pieces;
+        if (a_block.words.isEmpty()) {
+            for (auto& text: a_block.text.split(" ", Qt::SkipEmptyParts))
+                pieces.append(Interval{index.blockStart(blockNumber), -1, text});
+        }
+        else {
+            for (int i = 0; i < a_block.words.size(); i++) {
+                auto text = a_block.words[i].text.trimmed();
+                if (!text.isEmpty())
+                    pieces.append(Interval{index.wordStart(blockNumber, i), index.wordEnd(blockNumber, i), text});
+            }
+        }
+
+        TranscriptExporter::Cue cue;
+        QStringList cueWords;
+        int lineCount{0}, lineLength{0};
+        qint64 timedEnd{-1}, lastEnd{-1};
+
+        auto close = [&]() {
+            if (cueWords.isEmpty())
+                return;
+            // Untimed words at the end run on to the end of the line
+            auto end = (lastEnd != -1 || blockEnd == -1) ? timedEnd : blockEnd;
+            if (end != -1) {
+                cue.end = qMax(end, cue.start);
+                cue.lines = balance(cueWords, lineCount, maxLineLength);
+                cues.append(cue);
+            }
+            cueWords.clear();
+        };
+
+        for (auto& piece: qAsConst(pieces)) {
+            auto length = lineLength + 1 + piece.text.size();
+            auto newLine = length > maxLineLength;
+            if (!cueWords.isEmpty()
+                    && ((newLine && lineCount == maxLines)
+                        || (piece.end != -1 && piece.end - cue.start > options.maxDuration)))
+                close();
+
+            if (cueWords.isEmpty()) {
+                cue = {piece.start, -1, a_block.speaker, QStringList()};
+                lineCount = 1;
+                lineLength = piece.text.size();
+                timedEnd = -1;
+            }
+            else if (newLine) {
+                lineCount++;
+                lineLength = piece.text.size();
+            }
+            else
+                lineLength = length;
+
+            cueWords.append(piece.text);
+            lastEnd = piece.end;
+            timedEnd = qMax(timedEnd, piece.end);
+        }
+        close();
+    }
+
+    QString clockTime(qint64 position, char separator)
+    {
+        return QString("%1:%2:%3%4%5")
+                .arg(position / 3600000, 2, 10, QChar('0'))
+                .arg(position / 60000 % 60, 2, 10, QChar('0'))
+                .arg(position / 1000 % 60, 2, 10, QChar('0'))
+                .arg(QChar(separator))
+                .arg(position % 1000, 3, 10, QChar('0'));
+    }
+
+    QString seconds(qint64 position)
+    {
+        return QString::number(position / 1000.0, 'f', 3);
+    }
+
+    QString vttEscaped(QString text)
+    {
+        return text.replace("&", "&amp;").replace("<", "&lt;").replace(">", "&gt;");
+    }
+
+    void writeCues(QTextStream& out, TranscriptExporter::Format format, const QVector<block>& blocks, const SubtitleOptions& options)
+    {
+        BlockTimeIndex index;
+        index.rebuild(blocks);
+
+        if (format == TranscriptExporter::WebVtt)
+            out << "WEBVTT\n\n";
+
+        int number{0};
+        QVector<TranscriptExporter::Cue> cues;
+        for (int i = 0; i < blocks.size(); i++) {
+            cues.clear();
+            appendCues(blocks, i, index, options, cues);
+
+            for (auto& cue: qAsConst(cues)) {
+                if (format == TranscriptExporter::SubRip) {
+                    out << ++number << "\n"
+                        << clockTime(cue.start, ',') << " --> " << clockTime(cue.end, ',') << "\n"
+                        << cue.lines.join("\n") << "\n\n";
+                }
+                else {
+                    out << clockTime(cue.start, '.') << " --> " << clockTime(cue.end, '.') << "\n";
+                    if (!cue.speaker.isEmpty())
+                        out << "<v " << vttEscaped(cue.speaker) << ">";
+                    out << vttEscaped(cue.lines.join("\n")) << "\n\n";
+                }
+            }
+        }
+    }
+
+    void writeCtm(QTextStream& out, const QVector<block>& blocks, QString recording)
+    {
+        BlockTimeIndex index;
+        index.rebuild(blocks);
+        recording.replace(" ", "_");
+        if (recording.isEmpty())
+            recording = "transcript";
+
+        for (int i = 0; i < blocks.size(); i++) {
+            auto& words = blocks[i].words;
+            for (int j = 0; j < words.size(); j++) {
+                // An empty word would leave the line a field short
+                auto end = index.wordEnd(i, j);
+                auto text = words[j].text.trimmed();
+                if (end == -1 || text.isEmpty())
+                    continue;
+                auto start = qMin(index.wordStart(i, j), end);
+
+                out << recording << " 1 " << seconds(start) << " " << seconds(end - start) << " " << text;
+                if (words[j].confidence >= 0)
+                    out << " " << QString::number(words[j].confidence, 'f', 3);
+                out << "\n";
+            }
+        }
+    }
+
+    // Praat wants every tier covered end to end, gaps become empty intervals
+    // and overlaps from out of order timestamps are cut off the later one
+    QVector<Interval> tile(const QVector<Interval>& intervals, qint64 end)
+    {
+        QVector<Interval> tiled;
+        qint64 position{0};
+        for (auto& interval: intervals) {
+            auto start = qMax(interval.start, position);
+            if (interval.end <= start)
+                continue;
+            if (start > position)
+                tiled.append(Interval{position, start, QString()});
+            tiled.append(Interval{start, interval.end, interval.text});
+            position = interval.end;
+        }
+        if (position < end || tiled.isEmpty())
+            tiled.append(Interval{position, end, QString()});
+        return tiled;
+    }
+
+    void writeTextGrid(QTextStream& out, const QVector<block>& blocks)
+    {
+        BlockTimeIndex index;
+        index.rebuild(blocks);
+
+        QVector<Interval> lines, words;
+        qint64 end{0};
+        for (int i = 0; i < blocks.size(); i++) {
+            if (index.hasEnd(i)) {
+                lines.append(Interval{index.blockStart(i), index.blockEnd(i), blocks[i].text});
+                end = qMax(end, index.blockEnd(i));
+            }
+            for (int j = 0; j < index.wordCount(i); j++) {
+                if (index.wordEnd(i, j) == -1)
+                    continue;
+                words.append(Interval{index.wordStart(i, j), index.wordEnd(i, j), blocks[i].words[j].text});
+                end = qMax(end, index.wordEnd(i, j));
+            }
+        }
+
+        out << "File type = \"ooTextFile\"\n"
+            << "Object class = \"TextGrid\"\n\n"
+            << "xmin = 0 \n"
+            << "xmax = " << seconds(end) << " \n"
+            << "tiers? <exists> \n"
+            << "size = 2 \n"
+            << "item []: \n";
+
+        const QVector<QPair<QString, QVector<Interval>>> tiers{{"lines", tile(lines, end)}, {"words", tile(words, end)}};
+        for (int i = 0; i < tiers.size(); i++) {
+            auto& intervals = tiers[i].second;
+            out << "    item [" << i + 1 << "]:\n"
+                << "        class = \"IntervalTier\" \n"
+                << "        name = \"" << tiers[i].first << "\" \n"
+                << "        xmin = 0 \n"
+                << "        xmax = " << seconds(end) << " \n"
+                << "        intervals: size = " << intervals.size() << " \n";
+
+            for (int j = 0; j < intervals.size(); j++) {
+                out << "        intervals [" << j + 1 << "]:\n"
+                    << "            xmin = " << seconds(intervals[j].start) << " \n"
+                    << "            xmax = " << seconds(intervals[j].end) << " \n"
+                    << "            text = \"" << QString(intervals[j].text).replace("\"", "\"\"") << "\" \n";
+            }
+        }
+    }
+}
+
+bool TranscriptExporter::write(QIODevice* device, Format format, const QVector<block>& blocks,
+                               const SubtitleOptions& options, const QString& recording)
+{
+    QTextStream out(device);
+    out.setCodec("UTF-8");
+
+    switch (format) {
+    case SubRip:
+    case WebVtt:
+        writeCues(out, format, blocks, options);
+        break;
+    case Ctm:
+        writeCtm(out, blocks, recording);
+        break;
+    case TextGrid:
+        writeTextGrid(out, blocks);
+        break;
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool TranscriptExporter::exportFile(const QString& fileName, Format format, const QVector<block>& blocks,
+                                    const SubtitleOptions& options, QString* errorString)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || !write(&file, format, blocks, options, recordingName(fileName))
+            || !file.commit()) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QStringList TranscriptExporter::exportFiles(const QStringList& transcriptFileNames, Format format,
+                                            const QString& outputDirectory, const SubtitleOptions& options)
+{
+    // One transcript per worker, each read on a single thread
+    std::function<QString(const QString&)> exportOne = [format, outputDirectory, options](const QString& transcriptFileName) {
+        QFile file(transcriptFileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return QString("%1: %2").arg(transcriptFileName, file.errorString());
+
+        auto transcript = TranscriptReader::read(file, 1);
+        if (transcript.blocks.isEmpty())
+            return QString("%1: no lines to export").arg(transcriptFileName);
+
+        QString error;
+        auto fileName = QDir(outputDirectory).filePath(recordingName(transcriptFileName) + "." + suffix(format));
+        if (!exportFile(fileName, format, transcript.blocks, options, &error))
+            return QString("%1: %2").arg(fileName, error);
+        return QString();
+    };
+
+    auto errors = QtConcurrent::blockingMapped<QStringList>(transcriptFileNames, exportOne);
+    errors.removeAll(QString());
+    return errors;
+}
+
+QVector<TranscriptExporter::Cue> TranscriptExporter::segment(const QVector<block>& blocks, const SubtitleOptions& options)
+{
+    BlockTimeIndex index;
+    index.rebuild(blocks);
+
+    QVector<Cue> cues;
+    for (int i = 0; i < blocks.size(); i++)
+        appendCues(blocks, i, index, options, cues);
+    return cues;
+}
+
+QString TranscriptExporter::suffix(Format format)
+{
+    return formatNames().value(format);
+}
+
+QString TranscriptExporter::nameFilter(Format format)
+{
+    switch (format) {
+    case SubRip:
+        return "SubRip Subtitles (*.srt)";
+    case WebVtt:
+        return "WebVTT Subtitles (*.vtt)";
+    case Ctm:
+        return "NIST CTM (*.ctm)";
+    case TextGrid:
+        return "Praat TextGrid (*.TextGrid)";
+    }
+    return QString();
+}
+
+bool TranscriptExporter::formatOf(const QString& name, Format& format)
+{
+    auto formats = formatNames();
+    auto suffix = QFileInfo(name).suffix();
+    for (int i = 0; i < formats.size(); i++) {
+        if (formats[i].compare(suffix.isEmpty() ? name : suffix, Qt::CaseInsensitive) == 0) {
+            format = Format(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+QString TranscriptExporter::recordingName(const QString& transcriptFileName)
+{
+    auto name = QFileInfo(transcriptFileName).fileName();
+    if (name.endsWith(".gz", Qt::CaseInsensitive))
+        name.chop(3);
+    auto dot = name.lastIndexOf('.');
+    return dot > 0 ? name.left(dot) : name;
+}
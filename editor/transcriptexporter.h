@@ -0,0 +1,51 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QIODevice>
+#include <QStringList>
+
+// How lines are cut into subtitle cues. A cue never spans two lines of the
+// transcript, and is closed before a word would push it past either limit.
+struct SubtitleOptions
+{
+    int maxLineLength{42};
+    int maxLines{2};
+    qint64 maxDuration{7000};
+};
+
+// Writes subtitles and alignments straight from the blocks and their word
+// timestamps, line by line into the device. Starts follow the transcript's
+// convention, the end of the last timed line or word before. Whatever has no
+// time at all, before or after, is left out rather than given a made up one.
+class TranscriptExporter
+{
+public:
+    enum Format {SubRip, WebVtt, Ctm, TextGrid};
+
+    struct Cue
+    {
+        qint64 start, end;
+        QString speaker;
+        QStringList lines;
+    };
+
+    static bool write(QIODevice* device, Format format, const QVector<block>& blocks,
+                      const SubtitleOptions& options = SubtitleOptions(), const QString& recording = QString());
+    static bool exportFile(const QString& fileName, Format format, const QVector<block>& blocks,
+                           const SubtitleOptions& options, QString* errorString = nullptr);
+
+    // Reads every transcript and writes it next to its name in outputDirectory,
+    // one file per core at a time. Returns the errors, empty when all went well.
+    static QStringList exportFiles(const QStringList& transcriptFileNames, Format format,
+                                   const QString& outputDirectory, const SubtitleOptions& options);
+
+    static QVector<Cue> segment(const QVector<block>& blocks, const SubtitleOptions& options);
+
+    static QString suffix(Format format);
+    static QString nameFilter(Format format);
+    static bool formatOf(const QString& name, Format& format);
+    static QStringList formatNames() {return {"srt", "vtt", "ctm", "TextGrid"};}
+    // Transcript name without .gz and .xml, also the CTM recording name
+    static QString recordingName(const QString& transcriptFileName);
+};
@@ -0,0 +1,129 @@
+#include "transcripthistory.h"
+
+void TranscriptHistory::setMemoryLimit(qint64 bytes)
+{
+    m_limit = qMax<qint64>(bytes, 0);
+    trim();
+}
+
+void TranscriptHistory::clear()
+{
+    m_steps.clear();
+    m_done = 0;
+    m_used = 0;
+    m_open.hunks.clear();
+    m_open.bytes = 0;
+    m_typingTimer.invalidate();
+}
+
+void TranscriptHistory::beginStep(const QString& name)
+{
+    if (m_depth++ == 0)
+        m_open = {name, {}, 0, false};
+}
+
+void TranscriptHistory::endStep()
+{
+    if (m_depth == 0 || --m_depth > 0)
+        return;
+
+    if (!m_open.hunks.isEmpty())
+        push(m_open);
+    m_open = Step();
+}
+
+void TranscriptHistory::record(int at, const QVector<block>& before, const QVector<block>& after)
+{
+    Hunk hunk{at, before, after};
+    auto bytes = qint64(sizeof(Hunk)) + cost(before) + cost(after);
+
+    if (m_depth > 0) {
+        m_open.hunks.append(hunk);
+        m_open.bytes += bytes;
+    }
+    else
+        push({"Edit", {hunk}, bytes, false});
+}
+
+void TranscriptHistory::recordTyping(int at, const QVector<block>& before, const QVector<block>& after)
+{
+    if (m_depth > 0) {
+        record(at, before, after);
+        return;
+    }
+
+    bool sameLine = before.size() == 1 && after.size() == 1
+            && m_done == m_steps.size() && !m_steps.isEmpty()
+            && m_steps.last().typing && m_steps.last().hunks.size() == 1
+            && m_steps.last().hunks[0].at == at && m_steps.last().hunks[0].after.size() == 1;
+
+    if (sameLine && m_typingTimer.isValid() && m_typingTimer.elapsed() < typingPause) {
+        auto& step = m_steps.last();
+        auto& hunk = step.hunks[0];
+
+        hunk.after = after;
+        m_used -= step.bytes;
+        step.bytes = qint64(sizeof(Hunk)) + cost(hunk.before) + cost(hunk.after);
+        m_used += step.bytes;
+        trim();
+    }
+    else
+        push({"Typing", {{at, before, after}}, qint64(sizeof(Hunk)) + cost(before) + cost(after), true});
+
+    m_typingTimer.start();
+}
+
+const TranscriptHistory::Step* TranscriptHistory::undo()
+{
+    if (!canUndo())
+        return nullptr;
+
+    m_typingTimer.invalidate();
+    return &m_steps[--m_done];
+}
+
+const TranscriptHistory::Step* TranscriptHistory::redo()
+{
+    if (!canRedo())
+        return nullptr;
+
+    m_typingTimer.invalidate();
+    return &m_steps[m_done++];
+}
+
+qint64 TranscriptHistory::cost(const QVector<block>& blocks)
+{
+    // An upper bound, strings still shared with the model cost nothing extra
+    qint64 bytes{0};
+    for (auto& a_block: blocks) {
+        bytes += sizeof(block) + (a_block.text.size() + a_block.speaker.size()) * qint64(sizeof(QChar));
+        for (auto& a_word: a_block.words)
+            bytes += sizeof(word) + a_word.text.size() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
+
+void TranscriptHistory::push(Step step)
+{
+    // A new action ends what could be redone
+    while (m_steps.size() > m_done)
+        m_used -= m_steps.takeLast().bytes;
+
+    m_used += step.bytes;
+    m_steps.append(step);
+    m_done = m_steps.size();
+    trim();
+}
+
+void TranscriptHistory::trim()
+{
+    // Undone steps go first, the furthest from being redone first
+    while (m_used > m_limit && m_steps.size() > m_done)
+        m_used -= m_steps.takeLast().bytes;
+
+    // The latest action stays undoable whatever it costs
+    while (m_used > m_limit && m_done > 1) {
+        m_used -= m_steps.takeFirst().bytes;
+        m_done--;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QList>
+#include <QElapsedTimer>
+
+// Undo history of a transcript kept as deltas over its blocks instead of
+// copies of the document. A step is one user action made of hunks, each of
+// which replaced a run of blocks; undoing puts the old runs back, so it costs
+// as much as the action did, not as much as the file. Steps past the memory
+// limit are dropped, what could be redone before what could be undone, and
+// the oldest undo steps first.
+class TranscriptHistory
+{
+public:
+    struct Hunk
+    {
+        int at{0};
+        QVector<block> before, after;
+    };
+
+    struct Step
+    {
+        QString name;
+        QVector<Hunk> hunks;
+        qint64 bytes{0};
+        bool typing{false};
+    };
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const {return m_limit;}
+    qint64 memoryUsed() const {return m_used;}
+    void clear();
+
+    // Hunks recorded in between form one step
+    void beginStep(const QString& name);
+    void endStep();
+    void record(int at, const QVector<block>& before, const QVector<block>& after);
+    // Typing in the same line without a pause extends the last step
+    void recordTyping(int at, const QVector<block>& before, const QVector<block>& after);
+
+    bool canUndo() const {return m_done > 0;}
+    bool canRedo() const {return m_done < m_steps.size();}
+    QString undoName() const {return canUndo() ? m_steps[m_done - 1].name : QString();}
+    QString redoName() const {return canRedo() ? m_steps[m_done].name : QString();}
+
+    // The step to revert or to apply again, null when there is none. Undo
+    // replaces after with before, hunks in reverse order.
+    const Step* undo();
+    const Step* redo();
+
+    static qint64 cost(const QVector<block>& blocks);
+
+private:
+    void push(Step step);
+    void trim();
+
+    static const int typingPause = 2000;
+
+    QList<Step> m_steps;
+    int m_done{0};
+    Step m_open;
+    int m_depth{0};
+    qint64 m_limit{64 * 1024 * 1024}, m_used{0};
+    QElapsedTimer m_typingTimer;
+};
@@ -0,0 +1,697 @@
+#include "transcriptimporter.h"
+#include "blocktimeindex.h"
+#include "gzipdevice.h"
+
+#include <QFileInfo>
+#include <QLocale>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+namespace {
+    qint64 toMilliseconds(double seconds)
+    {
+        return qRound64(seconds * 1000);
+    }
+
+    QTime endTime(qint64 position)
+    {
+        return position >= 0 ? BlockTimeIndex::toTime(position) : QTime();
+    }
+
+    void finishLine(block& line, QVector<block>& blocks)
+    {
+        if (line.words.isEmpty())
+            return;
+
+        QStringList text;
+        for (auto& a_word: qAsConst(line.words))
+            text << a_word.text;
+        line.text = text.join(" ");
+        blocks.append(line);
+        line = block();
+    }
+
+    // Lines out of a stream of words, for formats that only have words
+    class LineBuilder
+    {
+    public:
+        explicit LineBuilder(QVector<block>& blocks) : m_blocks(blocks) {}
+
+        void add(const QString& text, qint64 start, qint64 end, double confidence, const QString& speaker)
+        {
+            if (!m_line.words.isEmpty()
+                    && (speaker != m_line.speaker || m_line.words.size() >= TranscriptImporter::maxLineWords
+                        || (start >= 0 && m_end >= 0 && start - m_end >= TranscriptImporter::lineBreakPause)))
+                finish();
+
+            m_line.speaker = speaker;
+            word a_word = {endTime(end), text, QStringList()};
+            if (confidence >= 0 && confidence <= 1)
+                a_word.confidence = confidence;
+            m_line.words.append(a_word);
+            if (end >= 0)
+                m_end = end;
+        }
+
+        // The line ends with its last word, or has no time when that one has none
+        void finish()
+        {
+            if (!m_line.words.isEmpty())
+                m_line.timeStamp = m_line.words.constLast().timeStamp;
+            finishLine(m_line, m_blocks);
+        }
+
+    private:
+        QVector<block>& m_blocks;
+        block m_line;
+        qint64 m_end{-1};
+    };
+
+    class LineReader
+    {
+    public:
+        explicit LineReader(const QByteArray& data)
+            : m_position(data.constData()), m_end(data.constData() + data.size())
+        {
+            if (m_end - m_position >= 3 && !std::memcmp(m_position, "\xEF\xBB\xBF", 3))
+                m_position += 3;
+        }
+
+        bool next(QByteArray& line)
+        {
+            if (m_position >= m_end)
+                return false;
+
+            auto newline = static_cast<const char*>(std::memchr(m_position, '\n', size_t(m_end - m_position)));
+            auto length = (newline ? newline : m_end) - m_position;
+            if (length > 0 && m_position[length - 1] == '\r')
+                length--;
+
+            line = QByteArray::fromRawData(m_position, int(length));
+            m_position = newline ? newline + 1 : m_end;
+            return true;
+        }
+
+    private:
+        const char* m_position;
+        const char* m_end;
+    };
+
+    // [[h:]m:]s[.,]fraction in milliseconds, -1 when it isn't one
+    qint64 parseClock(QByteArray text)
+    {
+        auto parts = text.trimmed().replace(',', '.').split(':');
+        if (parts.size() > 3)
+            return -1;
+
+        bool ok{false};
+        qint64 minutes{0};
+        for (int i = 0; i < parts.size() - 1; i++) {
+            minutes = minutes * 60 + parts[i].toInt(&ok);
+            if (!ok)
+                return -1;
+        }
+        auto seconds = parts.constLast().toDouble(&ok);
+        return ok ? minutes * 60000 + toMilliseconds(seconds) : -1;
+    }
+
+    QString decodeEntities(QString text)
+    {
+        return text.replace("&lt;", "<").replace("&gt;", ">").replace("&quot;", "\"").replace("&amp;", "&");
+    }
+
+    // One SRT or WebVTT cue: an optional identifier, the timing line and the text
+    void addCue(const QVector<QByteArray>& cueLines, QVector<block>& blocks)
+    {
+        int timing = 0;
+        while (timing < cueLines.size() && !cueLines[timing].contains("-->"))
+            timing++;
+        if (timing == cueLines.size())
+            return;     // WEBVTT header, NOTE, STYLE or REGION
+
+        auto& timingLine = cueLines[timing];
+        auto ends = timingLine.mid(timingLine.indexOf("-->") + 3).trimmed();
+        auto space = ends.indexOf(' ');
+        auto cueEnd = parseClock(space == -1 ? ends : ends.left(space));
+
+        QStringList lines;
+        for (int i = timing + 1; i < cueLines.size(); i++)
+            lines << QString::fromUtf8(cueLines[i]);
+        auto text = lines.join(" ").replace("&nbsp;", " ");
+
+        // Voice tags name the speaker, timestamp tags end the word before them
+        QString speaker, current;
+        QStringList words;
+        QVector<qint64> wordEnds;
+        auto flush = [&]() {
+            if (!current.isEmpty()) {
+                words << decodeEntities(current);
+                wordEnds << -1;
+                current.clear();
+            }
+        };
+
+        for (int i = 0; i < text.size(); i++) {
+            auto c = text[i];
+            if (c == '<' && text.indexOf('>', i) != -1) {
+                auto close = text.indexOf('>', i);
+                auto tag = text.mid(i + 1, close - i - 1);
+                i = close;
+
+                if (tag.startsWith("v ") || tag.startsWith("v.")) {
+                    auto nameStart = tag.indexOf(' ');
+                    if (nameStart != -1)
+                        speaker = tag.mid(nameStart + 1).trimmed();
+                }
+                else if (!tag.isEmpty() && tag[0].isDigit()) {
+                    flush();
+                    auto time = parseClock(tag.toLatin1());
+                    if (time >= 0 && !wordEnds.isEmpty() && wordEnds.constLast() == -1)
+                        wordEnds.last() = time;
+                }
+            }
+            else if (c == '{' && text.mid(i + 1, 1) == "\\" && text.indexOf('}', i) != -1)
+                i = text.indexOf('}', i);  // SubStation overrides like {\an8}
+            else if (c.isSpace())
+                flush();
+            else
+                current += c;
+        }
+        flush();
+
+        if (words.isEmpty())
+            return;
+        if (wordEnds.constLast() == -1)
+            wordEnds.last() = cueEnd;
+
+        block line;
+        line.timeStamp = endTime(cueEnd);
+        line.speaker = speaker;
+        for (int i = 0; i < words.size(); i++) {
+            word a_word = {endTime(wordEnds[i]), words[i], QStringList()};
+            line.words.append(a_word);
+        }
+        finishLine(line, blocks);
+    }
+
+    // Pulls values out of JSON text one at a time, nothing is kept but what
+    // the caller asks for
+    class JsonScanner
+    {
+    public:
+        JsonScanner(const char* begin, const char* end) : m_position(begin), m_end(end) {}
+
+        bool failed() const {return m_failed;}
+
+        char peek()
+        {
+            while (m_position < m_end && (*m_position == ' ' || *m_position == '\n' || *m_position == '\r' || *m_position == '\t'))
+                m_position++;
+            return m_position < m_end ? *m_position : '\0';
+        }
+
+        bool expect(char c)
+        {
+            if (peek() == c) {
+                m_position++;
+                return true;
+            }
+            m_failed = true;
+            return false;
+        }
+
+        // Steps to the next member or element after the opening bracket,
+        // false once the closing one is consumed or the text is broken
+        bool next(char close, bool& first)
+        {
+            if (m_failed)
+                return false;
+            if (peek() == close) {
+                m_position++;
+                return false;
+            }
+            if (!first && !expect(','))
+                return false;
+            first = false;
+            return true;
+        }
+
+        // Member names are compared raw, they are plain ASCII in practice
+        QByteArray key()
+        {
+            if (!expect('"'))
+                return QByteArray();
+
+            auto begin = m_position;
+            while (m_position < m_end && *m_position != '"')
+                m_position += (*m_position == '\\') ? 2 : 1;
+            if (m_position >= m_end) {
+                m_failed = true;
+                return QByteArray();
+            }
+
+            auto name = QByteArray::fromRawData(begin, int(m_position - begin));
+            m_position++;
+            expect(':');
+            return name;
+        }
+
+        bool string(QString& out)
+        {
+            if (!expect('"'))
+                return false;
+
+            out.clear();
+            auto run = m_position;
+            while (m_position < m_end) {
+                auto c = *m_position;
+                if (c == '"') {
+                    out += QString::fromUtf8(run, int(m_position - run));
+                    m_position++;
+                    return true;
+                }
+                if (c != '\\') {
+                    m_position++;
+                    continue;
+                }
+
+                out += QString::fromUtf8(run, int(m_position - run));
+                if (m_end - m_position < 2)
+                    break;
+                auto escaped = m_position[1];
+                m_position += 2;
+                switch (escaped) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    // Surrogate pairs come as two escapes and join up in the QString
+                    bool ok{false};
+                    auto code = m_end - m_position >= 4 ? QByteArray::fromRawData(m_position, 4).toUShort(&ok, 16) : 0;
+                    if (!ok) {
+                        m_failed = true;
+                        return false;
+                    }
+                    out += QChar(code);
+                    m_position += 4;
+                    break;
+                }
+                default: out += QChar(escaped); break;
+                }
+                run = m_position;
+            }
+
+            m_failed = true;
+            return false;
+        }
+
+        // Numbers as such, anything else (null mostly) is skipped
+        bool number(double& out)
+        {
+            auto c = peek();
+            if (c != '-' && (c < '0' || c > '9')) {
+                skipValue();
+                return false;
+            }
+
+            auto begin = m_position;
+            while (m_position < m_end && std::strchr("+-.0123456789eE", *m_position))
+                m_position++;
+            bool ok{false};
+            out = QByteArray::fromRawData(begin, int(m_position - begin)).toDouble(&ok);
+            return ok;
+        }
+
+        // Strings, or numbers as written, speakers come as either
+        bool text(QString& out)
+        {
+            auto c = peek();
+            if (c == '"')
+                return string(out);
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                auto begin = m_position;
+                skipValue();
+                out = QString::fromLatin1(begin, int(m_position - begin));
+                return true;
+            }
+            skipValue();
+            return false;
+        }
+
+        void skipValue()
+        {
+            bool first{true};
+            QString ignored;
+
+            switch (peek()) {
+            case '{':
+                m_position++;
+                while (next('}', first)) {
+                    key();
+                    skipValue();
+                }
+                break;
+            case '[':
+                m_position++;
+                while (next(']', first))
+                    skipValue();
+                break;
+            case '"':
+                string(ignored);
+                break;
+            default: {
+                // Numbers, true, false and null
+                auto begin = m_position;
+                while (m_position < m_end && std::strchr("+-.0123456789eEtruefalsn", *m_position))
+                    m_position++;
+                if (m_position == begin)
+                    m_failed = true;
+            }
+            }
+        }
+
+    private:
+        const char* m_position;
+        const char* m_end;
+        bool m_failed{false};
+    };
+
+    struct AsrWord
+    {
+        QString text, speaker;
+        qint64 start{-1}, end{-1};
+        double confidence{-1};
+    };
+
+    AsrWord readWord(JsonScanner& json)
+    {
+        AsrWord asrWord;
+        double number;
+        bool first{true};
+        if (json.peek() != '{') {
+            json.skipValue();
+            return asrWord;
+        }
+
+        json.expect('{');
+        while (json.next('}', first)) {
+            auto key = json.key();
+            if (key == "word")
+                json.text(asrWord.text);
+            else if (key == "text" && asrWord.text.isEmpty())
+                json.text(asrWord.text);
+            else if (key == "start") {
+                if (json.number(number))
+                    asrWord.start = toMilliseconds(number);
+            }
+            else if (key == "end") {
+                if (json.number(number))
+                    asrWord.end = toMilliseconds(number);
+            }
+            else if (key == "confidence" || key == "probability" || key == "score") {
+                if (json.number(number))
+                    asrWord.confidence = number;
+            }
+            else if (key == "speaker")
+                json.text(asrWord.speaker);
+            else
+                json.skipValue();
+        }
+        asrWord.text = asrWord.text.trimmed();
+        return asrWord;
+    }
+
+    void readWords(JsonScanner& json, QVector<AsrWord>& words)
+    {
+        bool first{true};
+        if (json.peek() != '[') {
+            json.skipValue();
+            return;
+        }
+
+        json.expect('[');
+        while (json.next(']', first)) {
+            auto asrWord = readWord(json);
+            if (!asrWord.text.isEmpty())
+                words.append(asrWord);
+        }
+    }
+
+    // A segment is a line, its end time wins over the one of its last word
+    void readSegment(JsonScanner& json, QVector<block>& blocks)
+    {
+        QString speaker, text;
+        qint64 end{-1};
+        QVector<AsrWord> words;
+        double number;
+        bool first{true};
+        if (json.peek() != '{') {
+            json.skipValue();
+            return;
+        }
+
+        json.expect('{');
+        while (json.next('}', first)) {
+            auto key = json.key();
+            if (key == "end") {
+                if (json.number(number))
+                    end = toMilliseconds(number);
+            }
+            else if (key == "speaker")
+                json.text(speaker);
+            else if (key == "text")
+                json.text(text);
+            else if (key == "words")
+                readWords(json, words);
+            else
+                json.skipValue();
+        }
+
+        block line;
+        line.speaker = (speaker.isEmpty() && !words.isEmpty()) ? words.constFirst().speaker : speaker;
+        for (auto& asrWord: qAsConst(words)) {
+            word a_word = {endTime(asrWord.end), asrWord.text, QStringList()};
+            if (asrWord.confidence >= 0 && asrWord.confidence <= 1)
+                a_word.confidence = asrWord.confidence;
+            line.words.append(a_word);
+        }
+
+        // Without words the text is all there is, untimed but for the line
+        if (line.words.isEmpty()) {
+            for (auto& wordText: text.simplified().split(' ', Qt::SkipEmptyParts)) {
+                word a_word = {QTime(), wordText, QStringList()};
+                line.words.append(a_word);
+            }
+        }
+        if (line.words.isEmpty())
+            return;
+
+        if (end < 0) {
+            for (auto& asrWord: qAsConst(words))
+                end = qMax(end, asrWord.end);
+        }
+        if (!line.words.constLast().timeStamp.isValid())
+            line.words.last().timeStamp = endTime(end);
+        line.timeStamp = endTime(end);
+        finishLine(line, blocks);
+    }
+
+    QString languageName(const QString& language)
+    {
+        // ISO codes like "en" become the names the dictionaries go by
+        if (language.size() <= 3) {
+            QLocale locale(language);
+            if (locale.language() != QLocale::C)
+                return QLocale::languageToString(locale.language()).toLower();
+        }
+        return language;
+    }
+}
+
+const QVector<TranscriptImporter::Importer>& TranscriptImporter::importers()
+{
+    static const QVector<Importer> importers{
+        {"NIST CTM", {"ctm"}, &TranscriptImporter::parseCtm},
+        {"Subtitles", {"srt", "vtt"}, &TranscriptImporter::parseSubtitles},
+        {"ASR JSON", {"json"}, &TranscriptImporter::parseAsrJson},
+    };
+    return importers;
+}
+
+const TranscriptImporter::Importer* TranscriptImporter::importerFor(const QString& fileName)
+{
+    auto name = fileName;
+    if (GzipDevice::isCompressedName(name))
+        name.chop(3);
+    auto suffix = QFileInfo(name).suffix().toLower();
+
+    for (auto& importer: importers())
+        if (importer.suffixes.contains(suffix))
+            return &importer;
+    return nullptr;
+}
+
+bool TranscriptImporter::read(QFile& file, const Importer& importer, TranscriptData& transcript)
+{
+    if (GzipDevice::isCompressed(&file)) {
+        GzipDevice gzip(&file);
+        if (!gzip.open(QIODevice::ReadOnly))
+            return false;
+        transcript = importer.parse(gzip.readAll());
+        return true;
+    }
+
+    auto size = file.size();
+    auto map = (size > 0 && size <= std::numeric_limits<int>::max()) ? file.map(0, size) : nullptr;
+    if (!map) {
+        auto data = file.readAll();
+        if (file.error() != QFileDevice::NoError)
+            return false;
+        transcript = importer.parse(data);
+        return true;
+    }
+
+    transcript = importer.parse(QByteArray::fromRawData(reinterpret_cast<const char*>(map), int(size)));
+    file.unmap(map);
+    return true;
+}
+
+bool TranscriptImporter::readFile(const QString& fileName, TranscriptData& transcript, QString& errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorString = file.errorString();
+        return false;
+    }
+
+    auto importer = importerFor(fileName);
+    if (!importer)
+        transcript = TranscriptReader::read(file, 1);
+    else if (!read(file, *importer, transcript)) {
+        errorString = file.errorString();
+        return false;
+    }
+
+    if (transcript.blocks.isEmpty()) {
+        errorString = "no lines";
+        return false;
+    }
+    return true;
+}
+
+TranscriptData TranscriptImporter::parseCtm(const QByteArray& data)
+{
+    TranscriptData transcript;
+    LineBuilder lines(transcript.blocks);
+    LineReader reader(data);
+    QByteArray line, recording, channel;
+    QString speaker;
+
+    // <recording> <channel> <start> <duration> <word> [<confidence>]
+    while (reader.next(line)) {
+        QByteArray fields[6];
+        int count{0};
+        auto c = line.constData();
+        auto end = c + line.size();
+        while (c < end && count < 6) {
+            while (c < end && (*c == ' ' || *c == '\t'))
+                c++;
+            if (c == end)
+                break;
+            auto begin = c;
+            while (c < end && *c != ' ' && *c != '\t')
+                c++;
+            fields[count++] = QByteArray::fromRawData(begin, int(c - begin));
+        }
+        if (count < 5 || fields[0].startsWith(";;"))
+            continue;
+
+        bool startOk{false}, durationOk{false}, confidenceOk{false};
+        auto start = toMilliseconds(fields[2].toDouble(&startOk));
+        auto duration = toMilliseconds(fields[3].toDouble(&durationOk));
+        if (!startOk || !durationOk)
+            continue;
+        auto confidence = count > 5 ? fields[5].toDouble(&confidenceOk) : -1;
+
+        if (fields[0] != recording || fields[1] != channel) {
+            if (fields[0] != recording)
+                lines.finish();
+            recording = QByteArray(fields[0].constData(), fields[0].size());
+            channel = QByteArray(fields[1].constData(), fields[1].size());
+            speaker = QString::fromUtf8(channel);
+        }
+
+        lines.add(QString::fromUtf8(fields[4]), start, start + duration, confidenceOk ? confidence : -1, speaker);
+    }
+    lines.finish();
+    return transcript;
+}
+
+TranscriptData TranscriptImporter::parseSubtitles(const QByteArray& data)
+{
+    TranscriptData transcript;
+    LineReader reader(data);
+    QByteArray line;
+    QVector<QByteArray> cueLines;
+
+    // Cues are separated by blank lines, SRT and WebVTT alike
+    while (reader.next(line)) {
+        if (line.trimmed().isEmpty()) {
+            addCue(cueLines, transcript.blocks);
+            cueLines.clear();
+        }
+        else
+            cueLines.append(line);
+    }
+    addCue(cueLines, transcript.blocks);
+    return transcript;
+}
+
+TranscriptData TranscriptImporter::parseAsrJson(const QByteArray& data)
+{
+    TranscriptData transcript;
+    JsonScanner json(data.constData(), data.constData() + data.size());
+    QVector<AsrWord> words;
+    bool first{true};
+
+    // {"language": ..., "segments": [{"end", "speaker", "text", "words": [...]}]},
+    // a bare array of segments, or only "words" without segments
+    if (json.peek() == '[') {
+        json.expect('[');
+        while (json.next(']', first))
+            readSegment(json, transcript.blocks);
+    }
+    else if (json.expect('{')) {
+        while (json.next('}', first)) {
+            auto key = json.key();
+            if (key == "language" || key == "lang") {
+                if (json.text(transcript.lang))
+                    transcript.lang = languageName(transcript.lang);
+            }
+            else if (key == "segments") {
+                bool firstSegment{true};
+                if (json.expect('['))
+                    while (json.next(']', firstSegment))
+                        readSegment(json, transcript.blocks);
+            }
+            else if (key == "words")
+                readWords(json, words);
+            else
+                json.skipValue();
+        }
+    }
+
+    if (transcript.blocks.isEmpty() && !words.isEmpty()) {
+        LineBuilder lines(transcript.blocks);
+        for (auto& asrWord: qAsConst(words))
+            lines.add(asrWord.text, asrWord.start, asrWord.end, asrWord.confidence, asrWord.speaker);
+        lines.finish();
+    }
+
+    if (json.failed())
+        qInfo() << "[Transcript Imported]" << QString("malformed JSON, kept %1 lines").arg(transcript.blocks.size());
+    return transcript;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "transcriptreader.h"
+
+// Reads what ASR engines and subtitle tools write straight into blocks and
+// words, one pass over the mapped file without building a document first.
+// Only end times are kept, a word or line starts where the last timed one
+// before it ended, so silences go to the word after them. Formats without
+// lines of their own are cut at speaker changes and pauses.
+class TranscriptImporter
+{
+public:
+    using Parser = TranscriptData (*)(const QByteArray& data);
+
+    struct Importer
+    {
+        QString name;
+        QStringList suffixes;
+        Parser parse;
+    };
+
+    static const qint64 lineBreakPause = 1000;
+    static const int maxLineWords = 50;
+
+    // Every format that can be opened besides transcript XML
+    static const QVector<Importer>& importers();
+    // By suffix, .gz aside, nullptr for transcript XML
+    static const Importer* importerFor(const QString& fileName);
+    // False when the file can't be read, gzip compressed files are inflated first
+    static bool read(QFile& file, const Importer& importer, TranscriptData& transcript);
+    // Transcript XML or any import by name, on the calling thread. False with
+    // the reason when it can't be read or has no lines.
+    static bool readFile(const QString& fileName, TranscriptData& transcript, QString& errorString);
+
+    static TranscriptData parseCtm(const QByteArray& data);
+    static TranscriptData parseSubtitles(const QByteArray& data);
+    static TranscriptData parseAsrJson(const QByteArray& data);
+};
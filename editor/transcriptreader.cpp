@@ -0,0 +1,263 @@
+#include "transcriptreader.h"
+#include "gzipdevice.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <cstring>
+#include <limits>
+
+namespace {
+    struct Chunk
+    {
+        QVector<block> blocks;
+        bool ok{false};
+    };
+
+    const char* findTag(const char* from, const char* end, const char* tag)
+    {
+        auto length = std::strlen(tag);
+        while (from && from < end) {
+            from = static_cast<const char*>(std::memchr(from, '<', size_t(end - from)));
+            if (!from || size_t(end - from) < length)
+                return nullptr;
+            if (!std::memcmp(from, tag, length))
+                return from;
+            from++;
+        }
+        return nullptr;
+    }
+
+    // Start of the first <line> element at or after from, end when there is none
+    const char* lineStart(const char* from, const char* end)
+    {
+        while ((from = findTag(from, end, "<line"))) {
+            auto next = from + 5;
+            if (next < end && (*next == '>' || *next == '/' || *next == ' ' || *next == '\t' || *next == '\r' || *next == '\n'))
+                return from;
+            from = next;
+        }
+        return end;
+    }
+
+    const char* transcriptEnd(const char* begin, const char* end)
+    {
+        static const char tag[] = "</transcript";
+        auto length = qint64(sizeof(tag) - 1);
+        for (auto at = end - length; at >= begin; at--)
+            if (*at == '<' && !std::memcmp(at, tag, size_t(length)))
+                return at;
+        return nullptr;
+    }
+
+    // The <transcript> start tag and anything before the first line. Only a
+    // well formed, UTF-8 header without a DTD can be split after.
+    bool readHeader(const char* begin, const char* end, QString& lang)
+    {
+        auto header = QByteArray::fromRawData(begin, int(end - begin));
+        if (header.contains("<!DOCTYPE"))
+            return false;
+
+        QXmlStreamReader reader(header);
+        if (!reader.readNextStartElement() || reader.name() != "transcript")
+            return false;
+
+        auto encoding = reader.documentEncoding().toString();
+        if (!encoding.isEmpty() && encoding.compare("UTF-8", Qt::CaseInsensitive))
+            return false;
+
+        lang = reader.attributes().value("lang").toString();
+
+        // The header stops inside <transcript>, so it ends prematurely at best
+        while (!reader.atEnd())
+            reader.readNext();
+        return reader.error() == QXmlStreamReader::PrematureEndOfDocumentError;
+    }
+
+    // A cut anywhere but between two top level lines leaves unbalanced
+    // elements in both chunks, which makes them fail here
+    Chunk readChunk(const char* begin, const char* end)
+    {
+        Chunk chunk;
+        QXmlStreamReader reader;
+        reader.addData(QByteArray("<chunk>"));
+        reader.addData(QByteArray::fromRawData(begin, int(end - begin)));
+        reader.addData(QByteArray("</chunk>"));
+
+        if (!reader.readNextStartElement())
+            return chunk;
+
+        while (reader.readNextStartElement()) {
+            if (reader.name() == "line")
+                chunk.blocks.append(TranscriptReader::readLine(reader));
+            else
+                reader.skipCurrentElement();
+        }
+
+        chunk.ok = !reader.hasError();
+        return chunk;
+    }
+}
+
+TranscriptData TranscriptReader::read(QFile& file, int threads)
+{
+    if (GzipDevice::isCompressed(&file))
+        return readCompressed(&file);
+
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    TranscriptData transcript;
+    if (threads > 1 && file.size() > parallelThreshold && readParallel(file, threads, transcript))
+        return transcript;
+
+    file.seek(0);
+    return readSequential(&file);
+}
+
+TranscriptData TranscriptReader::readSequential(QIODevice* device)
+{
+    TranscriptData transcript;
+    QXmlStreamReader reader(device);
+
+    if (reader.readNextStartElement()) {
+        if (reader.name() == "transcript") {
+            transcript.lang = reader.attributes().value("lang").toString();
+
+            while(reader.readNextStartElement()) {
+                if(reader.name() == "line")
+                    transcript.blocks.append(readLine(reader));
+                else
+                    reader.skipCurrentElement();
+            }
+        }
+        else
+            reader.raiseError(QObject::tr("Incorrect file"));
+    }
+    return transcript;
+}
+
+TranscriptData TranscriptReader::readCompressed(QIODevice* device)
+{
+    GzipDevice gzip(device);
+    if (!gzip.open(QIODevice::ReadOnly))
+        return TranscriptData();
+    return readSequential(&gzip);
+}
+
+bool TranscriptReader::readParallel(QFile& file, int threads, TranscriptData& transcript)
+{
+    auto size = file.size();
+    if (size <= 0 || size > std::numeric_limits<int>::max())
+        return false;
+
+    auto map = file.map(0, size);
+    if (!map)
+        return false;
+
+    auto begin = reinterpret_cast<const char*>(map);
+    auto end = transcriptEnd(begin, begin + size);
+    auto linesBegin = lineStart(begin, end ? end : begin);
+
+    QString lang;
+    if (!end || !readHeader(begin, linesBegin, lang)) {
+        file.unmap(map);
+        return false;
+    }
+
+    // Even cuts, each moved forward to the next line
+    QVector<const char*> cuts{linesBegin};
+    auto length = end - linesBegin;
+    for (int i = 1; i < threads; i++) {
+        auto cut = lineStart(linesBegin + length * i / threads, end);
+        if (cut > cuts.last())
+            cuts.append(cut);
+    }
+    if (cuts.last() != end || cuts.size() == 1)
+        cuts.append(end);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    QVector<QFuture<Chunk>> futures;
+    for (int i = 0; i + 1 < cuts.size(); i++) {
+        auto chunkBegin = cuts[i], chunkEnd = cuts[i + 1];
+        futures.append(QtConcurrent::run(&pool, [chunkBegin, chunkEnd] {
+            return readChunk(chunkBegin, chunkEnd);
+        }));
+    }
+
+    QVector<Chunk> chunks;
+    int lineCount{0};
+    bool ok{true};
+    for (auto& future: futures) {
+        chunks.append(future.result());
+        lineCount += chunks.last().blocks.size();
+        ok = ok && chunks.last().ok;
+    }
+    file.unmap(map);
+
+    if (!ok)
+        return false;
+
+    transcript.lang = lang;
+    transcript.blocks.clear();
+    transcript.blocks.reserve(lineCount);
+    for (auto& chunk: qAsConst(chunks))
+        transcript.blocks.append(chunk.blocks);
+    return true;
+}
+
+block TranscriptReader::readLine(QXmlStreamReader& reader)
+{
+    auto blockTimeStamp = getTime(reader.attributes().value("timestamp").toString());
+    auto blockText = QString("");
+    auto blockSpeaker = reader.attributes().value("speaker").toString();
+    auto tagString = reader.attributes().value("tags").toString();
+    QStringList tagList;
+    if (tagString != "")
+        tagList = tagString.split(",");
+
+    struct block line = {blockTimeStamp, "", blockSpeaker, tagList, QVector<word>()};
+    line.confidence = getConfidence(reader.attributes());
+    while(reader.readNextStartElement()){
+        if(reader.name() == "word"){
+            auto wordTimeStamp  = getTime(reader.attributes().value("timestamp").toString());
+            auto wordTagString  = reader.attributes().value("tags").toString();
+            auto wordConfidence = getConfidence(reader.attributes());
+            auto wordText       = reader.readElementText();
+            QStringList wordTagList;
+            if (wordTagString != "")
+                wordTagList = wordTagString.split(",");
+
+            word a_word = {wordTimeStamp, wordText, wordTagList};
+            a_word.confidence = wordConfidence;
+
+            blockText += (wordText + " ");
+            line.words.append(a_word);
+        }
+        else
+            reader.skipCurrentElement();
+    }
+    line.text = blockText.trimmed();
+    return line;
+}
+
+QTime TranscriptReader::getTime(const QString& text)
+{
+    if (text.contains(".")) {
+        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s.z");
+        return QTime::fromString(text, "m:s.z");
+    }
+    else {
+        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s");
+        return QTime::fromString(text, "m:s");
+    }
+}
+
+double TranscriptReader::getConfidence(const QXmlStreamAttributes& attributes)
+{
+    bool valid{false};
+    auto confidence = attributes.value("confidence").toDouble(&valid);
+    return (valid && confidence >= 0 && confidence <= 1) ? confidence : -1;
+}
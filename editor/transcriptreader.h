@@ -0,0 +1,38 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QFile>
+#include <QXmlStreamReader>
+
+struct TranscriptData
+{
+    QString lang;
+    QVector<block> blocks;
+};
+
+// Reads transcript XML. Large files are memory mapped and cut at <line>
+// boundaries into one chunk per thread, each chunk parsed on its own and the
+// blocks joined in file order. Whatever the chunks can't be trusted with
+// (declared entities, other encodings, lines nested in other elements, or
+// malformed XML) is read again by the sequential reader, so both paths give
+// the same blocks. gzip files are inflated while they are read, sequentially.
+class TranscriptReader
+{
+public:
+    static const qint64 parallelThreshold = 8 * 1024 * 1024;
+
+    // Chooses the path from the content and size, threads <= 0 for one per core
+    static TranscriptData read(QFile& file, int threads = 0);
+
+    static TranscriptData readSequential(QIODevice* device);
+    static TranscriptData readCompressed(QIODevice* device);
+    // False when the file has to be read sequentially instead
+    static bool readParallel(QFile& file, int threads, TranscriptData& transcript);
+
+    // Reads the <line> element the reader is at, up to its end element
+    static block readLine(QXmlStreamReader& reader);
+
+    static QTime getTime(const QString& text);
+    static double getConfidence(const QXmlStreamAttributes& attributes);
+};
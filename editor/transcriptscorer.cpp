@@ -0,0 +1,327 @@
+#include "transcriptscorer.h"
+#include "editdistance.h"
+#include "blocktimeindex.h"
+#include "tokenizer.h"
+#include "transcriptimporter.h"
+#include "transcriptexporter.h"
+
+#include <QDir>
+#include <QtConcurrent>
+#include <algorithm>
+#include <functional>
+
+namespace {
+    struct Token
+    {
+        int id;
+        QString text, speaker;
+        qint64 time;
+        bool lineEnd;
+    };
+
+    QVector<Token> tokenize(const QVector<block>& blocks, const Tokenizer& tokenizer, QHash<QString, int>& vocabulary)
+    {
+        BlockTimeIndex index;
+        index.rebuild(blocks);
+
+        QVector<Token> tokens;
+        for (int i = 0; i < blocks.size(); i++) {
+            auto& a_block = blocks[i];
+            auto first = tokens.size();
+
+            // Lines without words are only timed as a whole
+            if (a_block.words.isEmpty()) {
+                for (auto& text: Tokenizer::words(a_block.text)) {
+                    auto normalized = tokenizer.normalized(text);
+                    if (!normalized.isEmpty())
+                        tokens.append(Token{0, normalized, a_block.speaker, -1, false});
+                }
+                if (tokens.size() > first)
+                    tokens.last().time = index.blockEnd(i);
+            }
+            else {
+                for (int j = 0; j < a_block.words.size(); j++) {
+                    auto normalized = tokenizer.normalized(a_block.words[j].text);
+                    if (!normalized.isEmpty())
+                        tokens.append(Token{0, normalized, a_block.speaker, index.wordEnd(i, j), false});
+                }
+            }
+
+            if (tokens.size() > first)
+                tokens.last().lineEnd = true;
+        }
+
+        for (auto& token: tokens) {
+            auto id = vocabulary.value(token.text, -1);
+            if (id == -1) {
+                id = vocabulary.size();
+                vocabulary.insert(token.text, id);
+            }
+            token.id = id;
+        }
+        return tokens;
+    }
+
+    // Missing times are interpolated between the known ones and the rest made
+    // monotonic. False when there isn't a single known time.
+    bool fillTimes(QVector<Token>& tokens)
+    {
+        int previous = -1;
+        for (int i = 0; i < tokens.size(); i++) {
+            if (tokens[i].time < 0)
+                continue;
+            for (int k = previous + 1; k < i; k++) {
+                tokens[k].time = previous < 0
+                        ? tokens[i].time
+                        : tokens[previous].time + (tokens[i].time - tokens[previous].time) * (k - previous) / (i - previous);
+            }
+            previous = i;
+        }
+        if (previous < 0)
+            return tokens.isEmpty();
+
+        for (int k = previous + 1; k < tokens.size(); k++)
+            tokens[k].time = tokens[previous].time;
+        for (int i = 1; i < tokens.size(); i++)
+            tokens[i].time = qMax(tokens[i].time, tokens[i - 1].time);
+        return true;
+    }
+
+    // Errors of one alignment go to the speaker of the reference unit they
+    // fall on, insertions to the one before them
+    template <typename Count>
+    void attribute(const QVector<EditDistance::Operation>& operations, const QStringList& referenceSpeakers,
+                   const QStringList& hypothesisSpeakers, QMap<QString, ErrorCounts>& speakers, Count count)
+    {
+        int r{0}, h{0};
+        for (auto operation: operations) {
+            if (operation == EditDistance::Insertion) {
+                auto& speaker = referenceSpeakers.isEmpty() ? hypothesisSpeakers[h] : referenceSpeakers[qMax(r - 1, 0)];
+                count(speakers[speaker], operation);
+                h++;
+            }
+            else {
+                count(speakers[referenceSpeakers[r]], operation);
+                r++;
+                if (operation != EditDistance::Deletion)
+                    h++;
+            }
+        }
+    }
+
+    void scoreChunk(const QVector<Token>& reference, int referenceBegin, int referenceEnd,
+                    const QVector<Token>& hypothesis, int hypothesisBegin, int hypothesisEnd,
+                    QMap<QString, ErrorCounts>& speakers)
+    {
+        QVector<int> referenceWords, hypothesisWords, referenceCharacters, hypothesisCharacters;
+        QStringList referenceSpeakers, hypothesisSpeakers, referenceCharacterSpeakers, hypothesisCharacterSpeakers;
+
+        // Words joined by single spaces for the characters, a space belongs to the word before it
+        auto collect = [](const QVector<Token>& tokens, int begin, int end, QVector<int>& words, QStringList& wordSpeakers,
+                          QVector<int>& characters, QStringList& characterSpeakers) {
+            for (int i = begin; i < end; i++) {
+                words << tokens[i].id;
+                wordSpeakers << tokens[i].speaker;
+                if (i > begin) {
+                    characters << ' ';
+                    characterSpeakers << tokens[i - 1].speaker;
+                }
+                for (auto c: tokens[i].text) {
+                    characters << c.unicode();
+                    characterSpeakers << tokens[i].speaker;
+                }
+            }
+        };
+        collect(reference, referenceBegin, referenceEnd, referenceWords, referenceSpeakers, referenceCharacters, referenceCharacterSpeakers);
+        collect(hypothesis, hypothesisBegin, hypothesisEnd, hypothesisWords, hypothesisSpeakers, hypothesisCharacters, hypothesisCharacterSpeakers);
+
+        attribute(EditDistance::align(referenceWords, hypothesisWords), referenceSpeakers, hypothesisSpeakers, speakers,
+                  [](ErrorCounts& counts, EditDistance::Operation operation) {
+                      switch (operation) {
+                      case EditDistance::Hit: counts.words++; break;
+                      case EditDistance::Substitution: counts.words++; counts.substitutions++; break;
+                      case EditDistance::Deletion: counts.words++; counts.deletions++; break;
+                      case EditDistance::Insertion: counts.insertions++; break;
+                      }
+                  });
+
+        attribute(EditDistance::align(referenceCharacters, hypothesisCharacters), referenceCharacterSpeakers,
+                  hypothesisCharacterSpeakers, speakers,
+                  [](ErrorCounts& counts, EditDistance::Operation operation) {
+                      if (operation != EditDistance::Insertion)
+                          counts.characters++;
+                      if (operation != EditDistance::Hit)
+                          counts.characterErrors++;
+                  });
+    }
+
+    bool isTranscriptName(const QString& fileName)
+    {
+        auto name = fileName;
+        if (name.endsWith(".gz", Qt::CaseInsensitive))
+            name.chop(3);
+        return name.endsWith(".xml", Qt::CaseInsensitive) || TranscriptImporter::importerFor(name);
+    }
+
+    QString percent(double rate)
+    {
+        return QString::number(rate * 100, 'f', 2);
+    }
+}
+
+ErrorCounts& ErrorCounts::operator+=(const ErrorCounts& other)
+{
+    words += other.words;
+    substitutions += other.substitutions;
+    insertions += other.insertions;
+    deletions += other.deletions;
+    characters += other.characters;
+    characterErrors += other.characterErrors;
+    return *this;
+}
+
+ScoreReport TranscriptScorer::score(const QVector<block>& reference, const QVector<block>& hypothesis, const QString& lang)
+{
+    Tokenizer tokenizer(lang.isEmpty() ? "english" : lang);
+    QHash<QString, int> vocabulary;
+    auto referenceTokens = tokenize(reference, tokenizer, vocabulary);
+    auto hypothesisTokens = tokenize(hypothesis, tokenizer, vocabulary);
+
+    // Without times on one side, positions in the file stand in for them
+    if (!fillTimes(referenceTokens) || !fillTimes(hypothesisTokens)) {
+        for (auto sequence: {&referenceTokens, &hypothesisTokens})
+            for (int i = 0; i < sequence->size(); i++)
+                (*sequence)[i].time = qint64(i) * 1000000 / sequence->size();
+    }
+
+    // However the times fall, a stretch of the hypothesis is only aligned up
+    // to the longest reference stretch, scaled by how much longer the
+    // hypothesis is overall
+    auto ratio = referenceTokens.isEmpty() ? 1.0 : double(hypothesisTokens.size()) / referenceTokens.size();
+    auto maxHypothesisWords = int(2 * 2 * chunkWords * qBound(1.0, ratio, double(maxStretchRatio)));
+
+    ScoreReport report;
+    int referenceBegin{0}, hypothesisBegin{0};
+    for (int r = 0; r < referenceTokens.size(); r++) {
+        auto last = r == referenceTokens.size() - 1;
+        auto length = r + 1 - referenceBegin;
+        if (!referenceTokens[r].lineEnd && !last && length < 2 * chunkWords)
+            continue;
+
+        auto time = referenceTokens[r].time;
+        auto h = int(std::upper_bound(hypothesisTokens.begin() + hypothesisBegin, hypothesisTokens.end(), time,
+                                      [](qint64 t, const Token& token) {return t < token.time;})
+                     - hypothesisTokens.begin());
+        if (last)
+            h = hypothesisTokens.size();
+
+        // Clean when the hypothesis ends a word right on the line end, or
+        // has a pause around it
+        auto clean = (h == hypothesisTokens.size() || hypothesisTokens[h].time > time + boundaryTolerance)
+                && (h == 0 || hypothesisTokens[h - 1].time == time || hypothesisTokens[h - 1].time < time - boundaryTolerance);
+
+        if (last || clean || length >= chunkWords) {
+            auto alignedEnd = qMin(h, hypothesisBegin + maxHypothesisWords);
+            scoreChunk(referenceTokens, referenceBegin, r + 1, hypothesisTokens, hypothesisBegin, alignedEnd, report.speakers);
+            // The rest has nothing left to match, it is only inserted
+            if (alignedEnd < h)
+                scoreChunk(referenceTokens, r + 1, r + 1, hypothesisTokens, alignedEnd, h, report.speakers);
+            referenceBegin = r + 1;
+            hypothesisBegin = h;
+        }
+    }
+
+    // Nothing to score against, every hypothesis word is inserted
+    if (referenceTokens.isEmpty() && !hypothesisTokens.isEmpty())
+        scoreChunk(referenceTokens, 0, 0, hypothesisTokens, 0, hypothesisTokens.size(), report.speakers);
+
+    for (auto& counts: qAsConst(report.speakers))
+        report.overall += counts;
+    return report;
+}
+
+ScoreReport TranscriptScorer::scoreFiles(const QString& referenceFileName, const QString& hypothesisFileName)
+{
+    TranscriptData reference, hypothesis;
+    QString error;
+    if (!TranscriptImporter::readFile(referenceFileName, reference, error))
+        error = referenceFileName + ": " + error;
+    else if (!TranscriptImporter::readFile(hypothesisFileName, hypothesis, error))
+        error = hypothesisFileName + ": " + error;
+
+    ScoreReport report;
+    if (error.isEmpty())
+        report = score(reference.blocks, hypothesis.blocks, reference.lang);
+    report.reference = referenceFileName;
+    report.hypothesis = hypothesisFileName;
+    report.error = error;
+    return report;
+}
+
+QVector<ScoreReport> TranscriptScorer::scoreDirectories(const QString& referenceDirectory, const QString& hypothesisDirectory)
+{
+    QHash<QString, QString> hypotheses;
+    QDir hypothesisDir(hypothesisDirectory);
+    for (auto& fileName: hypothesisDir.entryList(QDir::Files, QDir::Name))
+        if (isTranscriptName(fileName))
+            hypotheses.insert(TranscriptExporter::recordingName(fileName), hypothesisDir.filePath(fileName));
+
+    QVector<QPair<QString, QString>> pairs;
+    QDir referenceDir(referenceDirectory);
+    for (auto& fileName: referenceDir.entryList(QDir::Files, QDir::Name))
+        if (isTranscriptName(fileName))
+            pairs.append(qMakePair(referenceDir.filePath(fileName), hypotheses.value(TranscriptExporter::recordingName(fileName))));
+
+    std::function<ScoreReport(const QPair<QString, QString>&)> scorePair = [](const QPair<QString, QString>& pair) {
+        if (!pair.second.isEmpty())
+            return scoreFiles(pair.first, pair.second);
+
+        ScoreReport report;
+        report.reference = pair.first;
+        report.error = pair.first + ": no hypothesis with the same name";
+        return report;
+    };
+    return QtConcurrent::blockingMapped<QVector<ScoreReport>>(pairs, scorePair);
+}
+
+QString TranscriptScorer::table(const ScoreReport& report)
+{
+    auto row = [](const QString& name, const ErrorCounts& counts) {
+        return QString("%1 %2 %3 %4 %5 %6 %7\n")
+                .arg(name.left(20), -20)
+                .arg(counts.words, 8)
+                .arg(percent(counts.wer()), 7)
+                .arg(counts.substitutions, 6)
+                .arg(counts.insertions, 6)
+                .arg(counts.deletions, 6)
+                .arg(percent(counts.cer()), 7);
+    };
+
+    auto text = QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg("Speaker", -20).arg("Words", 8).arg("WER %", 7).arg("Sub", 6).arg("Ins", 6).arg("Del", 6).arg("CER %", 7);
+    for (auto speaker = report.speakers.constBegin(); speaker != report.speakers.constEnd(); ++speaker)
+        text += row(speaker.key().isEmpty() ? "(none)" : speaker.key(), speaker.value());
+    return text + row("Overall", report.overall);
+}
+
+QString TranscriptScorer::csvHeader()
+{
+    return "reference,hypothesis,speaker,words,substitutions,insertions,deletions,wer,characters,character_errors,cer\n";
+}
+
+QString TranscriptScorer::csvRows(const ScoreReport& report)
+{
+    auto quoted = [](QString text) {return "\"" + text.replace("\"", "\"\"") + "\"";};
+    auto row = [&](const QString& speaker, const ErrorCounts& counts) {
+        return QStringList{quoted(report.reference), quoted(report.hypothesis), quoted(speaker),
+                           QString::number(counts.words), QString::number(counts.substitutions),
+                           QString::number(counts.insertions), QString::number(counts.deletions),
+                           QString::number(counts.wer(), 'f', 4), QString::number(counts.characters),
+                           QString::number(counts.characterErrors), QString::number(counts.cer(), 'f', 4)}.join(",") + "\n";
+    };
+
+    QString rows;
+    for (auto speaker = report.speakers.constBegin(); speaker != report.speakers.constEnd(); ++speaker)
+        rows += row(speaker.key(), speaker.value());
+    return rows + row("*", report.overall);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QMap>
+
+struct ErrorCounts
+{
+    qint64 words{0}, substitutions{0}, insertions{0}, deletions{0};
+    qint64 characters{0}, characterErrors{0};
+
+    qint64 wordErrors() const {return substitutions + insertions + deletions;}
+    double wer() const {return words ? double(wordErrors()) / words : 0;}
+    double cer() const {return characters ? double(characterErrors) / characters : 0;}
+
+    ErrorCounts& operator+=(const ErrorCounts& other);
+};
+
+struct ScoreReport
+{
+    QString reference, hypothesis, error;
+    ErrorCounts overall;
+    QMap<QString, ErrorCounts> speakers;   // By the speaker of the reference words
+};
+
+// WER and CER of a hypothesis (the ASR output) against a reference (the
+// edited transcript). Words are compared the way the spell check sees them,
+// normalized by the Tokenizer. Both transcripts are cut into stretches at the
+// reference line ends the hypothesis has a clean break at, by timestamps, and
+// each stretch is aligned on its own by EditDistance, first by words then by
+// characters. Errors go to the speaker of the nearest reference word.
+class TranscriptScorer
+{
+public:
+    // Past this many reference words a stretch is cut at the next line end,
+    // clean or not, and past twice as many at the next word
+    static const int chunkWords = 500;
+    // Hypothesis words ending this close to a line end, but not on it, make the break unclean
+    static const qint64 boundaryTolerance = 200;
+    // A hypothesis stretch is aligned up to twice the longest reference
+    // stretch, times how many more words the hypothesis has, at most this
+    // many times. Words past that are counted as inserted, not aligned.
+    static const int maxStretchRatio = 4;
+
+    static ScoreReport score(const QVector<block>& reference, const QVector<block>& hypothesis,
+                             const QString& lang = "english");
+    static ScoreReport scoreFiles(const QString& referenceFileName, const QString& hypothesisFileName);
+    // Pairs transcripts by name without their suffixes, one pair per core at a time
+    static QVector<ScoreReport> scoreDirectories(const QString& referenceDirectory, const QString& hypothesisDirectory);
+
+    static QString table(const ScoreReport& report);
+    static QString csvHeader();
+    static QString csvRows(const ScoreReport& report);
+};
@@ -0,0 +1,435 @@
+#include "transcriptworkspace.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QSignalBlocker>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+
+TranscriptWorkspace::TranscriptWorkspace(Editor *editor, MediaPlayer *player, QObject *parent)
+    : QObject(parent),
+    m_editor(editor),
+    m_player(player),
+    m_tabBar(new QTabBar)
+{
+    m_tabBar->setTabsClosable(true);
+    m_tabBar->setExpanding(false);
+    m_tabBar->setDocumentMode(true);
+    m_tabBar->setElideMode(Qt::ElideMiddle);
+
+    // Whatever the editor shows already is the first tab
+    Tab first;
+    first.loaded = true;
+    first.transcriptUrl = m_editor->transcriptUrl();
+    first.lastUsed = ++m_useCounter;
+    m_tabs.append(first);
+    m_current = 0;
+    m_tabBar->addTab(QString());
+    updateTitle(0);
+
+    connect(m_tabBar, &QTabBar::currentChanged, this, &TranscriptWorkspace::activate);
+    connect(m_tabBar, &QTabBar::tabCloseRequested, this, &TranscriptWorkspace::closeTab);
+
+    connect(m_editor, &Editor::transcriptChanged, this,
+        [this](const QUrl& transcriptUrl)
+        {
+            if (m_switching)
+                return;
+
+            // Another transcript opened over a restored one still being read
+            auto& tab = m_tabs[m_current];
+            if (!tab.loaded) {
+                tab.loaded = true;
+                tab.reading = false;
+                m_editor->setReadOnly(false);
+            }
+
+            if (tab.transcriptUrl != transcriptUrl) {
+                tab.transcriptUrl = transcriptUrl;
+                tab.footprint = footprint(m_editor->document(), m_editor->blocks());
+
+                auto mediaUrl = findMedia(transcriptUrl);
+                if (mediaUrl.isValid() && mediaUrl != m_player->currentMedia().request().url())
+                    m_player->load(mediaUrl);
+            }
+            updateTitle(m_current);
+        }
+    );
+    connect(m_editor, &Editor::blocksChanged, this, [this]() {if (!m_switching) updateTitle(m_current);});
+    connect(m_player, &QMediaPlayer::currentMediaChanged, this,
+        [this](const QMediaContent& media)
+        {
+            m_tabs[m_current].mediaUrl = media.request().url();
+        }
+    );
+}
+
+void TranscriptWorkspace::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+    enforceBudget();
+}
+
+QVector<Session::Tab> TranscriptWorkspace::sessionTabs(int& current) const
+{
+    QVector<Session::Tab> tabs;
+    current = 0;
+    for (int i = 0; i < m_tabs.size(); i++) {
+        auto& tab = m_tabs[i];
+        Session::Tab saved{tab.transcriptUrl, tab.mediaUrl, tab.cursorPosition, tab.mediaPosition};
+        if (i == m_current) {
+            if (tab.loaded)
+                saved.cursorPosition = m_editor->textCursor().position();
+            saved.mediaPosition = m_player->position();
+            current = tabs.size();
+        }
+        else if (tab.loaded)
+            saved.cursorPosition = tab.state.cursorPosition;
+
+        if (!saved.transcriptUrl.isEmpty() || !saved.mediaUrl.isEmpty())
+            tabs.append(saved);
+    }
+    return tabs;
+}
+
+bool TranscriptWorkspace::restoreTabs(const QVector<Session::Tab>& savedTabs, int current, Session::Tab& currentTab)
+{
+    if (m_tabs.size() != 1 || !m_tabs[0].transcriptUrl.isEmpty() || m_editor->isModified())
+        return false;
+
+    // Transcripts moved or deleted since are left out
+    QVector<Session::Tab> tabs;
+    for (int i = 0; i < savedTabs.size(); i++) {
+        auto& saved = savedTabs[i];
+        if (!saved.transcriptUrl.isEmpty() && !QFileInfo::exists(saved.transcriptUrl.toLocalFile())) {
+            if (i < current)
+                current--;
+            continue;
+        }
+        tabs.append(saved);
+    }
+    if (tabs.isEmpty())
+        return false;
+
+    current = qBound(0, current, tabs.size() - 1);
+    auto editorTab = m_tabs.takeFirst();
+
+    QSignalBlocker blocker(m_tabBar);
+    m_tabBar->removeTab(0);
+    for (int i = 0; i < tabs.size(); i++) {
+        auto& saved = tabs[i];
+        auto tab = i == current ? editorTab : Tab();
+        tab.transcriptUrl = saved.transcriptUrl;
+        tab.mediaUrl = saved.mediaUrl.isValid() ? saved.mediaUrl : findMedia(saved.transcriptUrl);
+        tab.mediaPosition = saved.mediaPosition;
+        tab.cursorPosition = saved.cursorPosition;
+        m_tabs.append(tab);
+        m_tabBar->addTab(QString());
+    }
+
+    m_current = current;
+    currentTab = tabs[current];
+    m_tabBar->setCurrentIndex(current);
+    for (int i = 0; i < m_tabs.size(); i++)
+        updateTitle(i);
+
+    auto& shown = m_tabs[current];
+    if (shown.transcriptUrl.isEmpty())
+        return false;
+
+    // Until the read is done the tab shows an empty document it doesn't keep
+    shown.loaded = false;
+    shown.reading = true;
+    m_editor->setReadOnly(true);
+
+    auto transcriptUrl = shown.transcriptUrl;
+    auto watcher = new QFutureWatcher<LoadedTranscript>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this,
+        [this, watcher, transcriptUrl]()
+        {
+            watcher->deleteLater();
+
+            // The tab may have moved, or been closed or reused meanwhile
+            auto it = std::find_if(m_tabs.begin(), m_tabs.end(),
+                                   [&transcriptUrl](const Tab& tab) {return tab.reading && tab.transcriptUrl == transcriptUrl;});
+            if (it != m_tabs.end()) {
+                it->reading = false;
+                if (it - m_tabs.begin() == m_current) {
+                    m_editor->setReadOnly(false);
+                    show(*it, watcher->result());
+                }
+                else
+                    it->read = QSharedPointer<LoadedTranscript>::create(watcher->result());
+            }
+            emit sessionRestored();
+        }
+    );
+    watcher->setFuture(QtConcurrent::run(&Editor::readTranscript, transcriptUrl.toLocalFile()));
+    return true;
+}
+
+void TranscriptWorkspace::openTranscripts()
+{
+    QFileDialog fileDialog(m_editor);
+    fileDialog.setAcceptMode(QFileDialog::AcceptOpen);
+    fileDialog.setFileMode(QFileDialog::ExistingFiles);
+    fileDialog.setWindowTitle(tr("Open Transcripts"));
+    fileDialog.setDirectory(QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).value(0, QDir::homePath()));
+
+    if (fileDialog.exec() != QDialog::Accepted)
+        return;
+
+    auto fileUrls = fileDialog.selectedUrls();
+    int firstNew = -1;
+
+    for (auto& fileUrl: qAsConst(fileUrls)) {
+        auto open = std::find_if(m_tabs.begin(), m_tabs.end(),
+                                 [&fileUrl](const Tab& tab) {return tab.transcriptUrl == fileUrl;});
+        if (open != m_tabs.end()) {
+            if (firstNew == -1)
+                firstNew = static_cast<int>(open - m_tabs.begin());
+            continue;
+        }
+
+        // An untouched empty tab is reused instead of left behind
+        if (m_tabs[m_current].transcriptUrl.isEmpty() && !m_editor->isModified()) {
+            m_editor->openTranscript(fileUrl);
+            if (firstNew == -1)
+                firstNew = m_current;
+            continue;
+        }
+
+        addTranscript(fileUrl);
+        if (firstNew == -1)
+            firstNew = m_tabs.size() - 1;
+    }
+
+    activate(firstNew);
+    emit message(QString("%1 transcripts open").arg(m_tabs.size()));
+}
+
+void TranscriptWorkspace::addTranscript(const QUrl& transcriptUrl, const QUrl& mediaUrl)
+{
+    Tab tab;
+    tab.transcriptUrl = transcriptUrl;
+    tab.mediaUrl = mediaUrl.isValid() ? mediaUrl : findMedia(transcriptUrl);
+    m_tabs.append(tab);
+
+    QSignalBlocker blocker(m_tabBar);
+    m_tabBar->addTab(QString());
+    updateTitle(m_tabs.size() - 1);
+}
+
+void TranscriptWorkspace::activate(int index)
+{
+    if (index < 0 || index >= m_tabs.size() || index == m_current)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    m_switching = true;
+
+    // A tab still being read only showed an empty document, it isn't kept
+    auto& previous = m_tabs[m_current];
+    auto state = m_editor->takeState();
+    QTextDocument *placeholder = nullptr;
+    if (previous.loaded) {
+        previous.state = std::move(state);
+        previous.footprint = footprint(previous.state.document, previous.state.blocks);
+    }
+    else
+        placeholder = state.document;
+    previous.mediaPosition = m_player->position();
+    updateTitle(m_current);
+
+    m_current = index;
+    auto& tab = m_tabs[index];
+    tab.lastUsed = ++m_useCounter;
+    bool restored = tab.loaded;
+
+    if (tab.loaded) {
+        m_editor->restoreState(std::move(tab.state));
+        tab.state = TranscriptState();
+    }
+    else {
+        m_editor->restoreState(m_editor->createState());
+        // One still being read stays empty until the read is done
+        if (!tab.reading) {
+            if (tab.read)
+                show(tab, *tab.read);
+            else if (tab.transcriptUrl.isValid())
+                show(tab, Editor::readTranscript(tab.transcriptUrl.toLocalFile()));
+            else
+                tab.loaded = true;
+            tab.read.reset();
+        }
+    }
+    m_editor->setReadOnly(tab.reading);
+    delete placeholder;
+
+    if (tab.mediaUrl.isValid() && tab.mediaUrl != m_player->currentMedia().request().url())
+        m_player->load(tab.mediaUrl, tab.mediaPosition);
+
+    m_switching = false;
+    updateTitle(index);
+
+    if (m_tabBar->currentIndex() != index) {
+        QSignalBlocker blocker(m_tabBar);
+        m_tabBar->setCurrentIndex(index);
+    }
+
+    qInfo() << "[Tab Switched]"
+            << QString("%1 %2 in %3 ms").arg(m_tabBar->tabText(index), restored ? "restored" : "loaded", QString::number(timer.elapsed()));
+
+    enforceBudget();
+}
+
+void TranscriptWorkspace::closeTab(int index)
+{
+    if (index < 0 || index >= m_tabs.size())
+        return;
+
+    bool modified = (index == m_current) ? m_editor->isModified() : m_tabs[index].state.modified;
+    if (modified && QMessageBox::question(m_editor, tr("Close Transcript"),
+                                          tr("%1 has unsaved changes. Close it anyway?").arg(m_tabBar->tabText(index)))
+            != QMessageBox::Yes)
+        return;
+
+    if (m_tabs.size() == 1) {
+        // A restored transcript still being read is dropped with it
+        auto& tab = m_tabs[0];
+        tab.loaded = true;
+        tab.reading = false;
+        m_editor->setReadOnly(false);
+        m_editor->transcriptClose();
+        return;
+    }
+
+    if (index == m_current)
+        activate(index + 1 < m_tabs.size() ? index + 1 : index - 1);
+
+    unload(m_tabs[index]);
+    m_tabs.remove(index);
+    if (m_current > index)
+        m_current--;
+
+    QSignalBlocker blocker(m_tabBar);
+    m_tabBar->removeTab(index);
+    m_tabBar->setCurrentIndex(m_current);
+
+    enforceBudget();
+}
+
+void TranscriptWorkspace::show(Tab& tab, const LoadedTranscript& loaded)
+{
+    tab.loaded = true;
+    m_editor->openTranscript(tab.transcriptUrl, loaded);
+    tab.footprint = footprint(m_editor->document(), m_editor->blocks());
+
+    QTextCursor cursor(m_editor->document());
+    cursor.setPosition(qBound(0, tab.cursorPosition, m_editor->document()->characterCount() - 1));
+    m_editor->setTextCursor(cursor);
+    m_editor->centerCursor();
+}
+
+void TranscriptWorkspace::unload(Tab& tab)
+{
+    if (!tab.loaded)
+        return;
+
+    tab.cursorPosition = tab.state.cursorPosition;
+
+    // The highlighter is a child of the document and goes with it
+    delete tab.state.document;
+    tab.state = TranscriptState();
+    tab.footprint = 0;
+    tab.loaded = false;
+}
+
+void TranscriptWorkspace::enforceBudget()
+{
+    // The shown tab counts as it was when stored or read, edits since are
+    // counted once it is stored again
+    qint64 total{0};
+    for (auto& tab: qAsConst(m_tabs))
+        if (tab.loaded)
+            total += tab.footprint;
+
+    while (total > m_memoryBudget) {
+        int victim = -1;
+        for (int i = 0; i < m_tabs.size(); i++) {
+            auto& tab = m_tabs[i];
+
+            // Unsaved and untitled documents couldn't be parsed again
+            if (i == m_current || !tab.loaded || tab.state.modified || tab.transcriptUrl.isEmpty())
+                continue;
+            if (victim == -1 || tab.lastUsed < m_tabs[victim].lastUsed)
+                victim = i;
+        }
+
+        if (victim == -1)
+            break;
+
+        auto bytes = m_tabs[victim].footprint;
+        total -= bytes;
+        unload(m_tabs[victim]);
+
+        qInfo() << "[Tab Evicted]"
+                << QString("%1, %2 KiB freed, %3 KiB still open").arg(m_tabBar->tabText(victim), QString::number(bytes / 1024), QString::number(total / 1024));
+    }
+
+    QStringList langs{m_editor->transcriptLang()};
+    for (auto& tab: qAsConst(m_tabs))
+        if (tab.loaded)
+            langs << tab.state.transcriptLang;
+    DictionaryCache::trim(langs);
+}
+
+void TranscriptWorkspace::updateTitle(int index)
+{
+    auto& tab = m_tabs[index];
+    bool modified = (index == m_current) ? m_editor->isModified() : tab.state.modified;
+
+    auto title = tab.transcriptUrl.isEmpty() ? tr("Untitled") : tab.transcriptUrl.fileName();
+    if (modified)
+        title += "*";
+
+    if (m_tabBar->tabText(index) != title) {
+        m_tabBar->setTabText(index, title);
+        m_tabBar->setTabToolTip(index, tab.transcriptUrl.toLocalFile());
+    }
+}
+
+qint64 TranscriptWorkspace::footprint(const QTextDocument *document, const QVector<block>& blocks)
+{
+    // Rough estimate: the text lives in the document, its layout and the
+    // highlighter formats, the block data adds its own copy
+    qint64 bytes = qint64(document->characterCount()) * qint64(sizeof(QChar)) * 3;
+
+    for (auto& a_block: blocks) {
+        bytes += sizeof(block) + (a_block.text.size() + a_block.speaker.size()) * qint64(sizeof(QChar));
+        for (auto& a_word: a_block.words)
+            bytes += sizeof(word) + a_word.text.size() * qint64(sizeof(QChar));
+    }
+
+    return bytes;
+}
+
+QUrl TranscriptWorkspace::findMedia(const QUrl& transcriptUrl)
+{
+    QFileInfo transcriptInfo(transcriptUrl.toLocalFile());
+    if (!transcriptInfo.exists())
+        return {};
+
+    for (auto suffix: {"wav", "mp3", "flac", "ogg", "m4a", "mp4", "mkv", "webm", "avi"}) {
+        QFileInfo mediaInfo(transcriptInfo.dir(), transcriptInfo.completeBaseName() + "." + suffix);
+        if (mediaInfo.exists())
+            return QUrl::fromLocalFile(mediaInfo.absoluteFilePath());
+    }
+    return {};
+}
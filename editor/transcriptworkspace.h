@@ -0,0 +1,79 @@
+#pragma once
+
+#include "editor.h"
+#include "mediaplayer/mediaplayer.h"
+#include "session.h"
+
+#include <QTabBar>
+#include <QSharedPointer>
+
+// Keeps several transcript and media pairs open as tabs around the one Editor
+// and MediaPlayer. Tabs are parsed the first time they are shown, inactive
+// ones keep their document so switching back is a swap. When the open
+// documents grow past the memory budget the least recently used saved ones
+// are dropped and parsed again on their next visit.
+class TranscriptWorkspace : public QObject
+{
+    Q_OBJECT
+
+public:
+    TranscriptWorkspace(Editor *editor, MediaPlayer *player, QObject *parent = nullptr);
+
+    QTabBar* tabBar() const {return m_tabBar;}
+    int count() const {return m_tabs.size();}
+    qint64 memoryBudget() const {return m_memoryBudget;}
+    void setMemoryBudget(qint64 bytes);
+
+    // Every tab with a transcript or media, and which of them is current
+    QVector<Session::Tab> sessionTabs(int& current) const;
+    // Puts saved tabs in place of the untouched one the tool starts with and
+    // hands back the current one. Its transcript is read on a worker thread,
+    // the others when first shown. True while that read runs, sessionRestored()
+    // follows once it is done.
+    bool restoreTabs(const QVector<Session::Tab>& savedTabs, int current, Session::Tab& currentTab);
+
+public slots:
+    void openTranscripts();
+    void addTranscript(const QUrl& transcriptUrl, const QUrl& mediaUrl = QUrl());
+    void activate(int index);
+    void closeTab(int index);
+
+signals:
+    void message(const QString& text, int timeout = 5000);
+    void sessionRestored();
+
+private:
+    struct Tab
+    {
+        QUrl transcriptUrl, mediaUrl;
+        qint64 mediaPosition{0};
+        // Where the cursor goes once an unloaded tab is read again
+        int cursorPosition{0};
+        bool loaded{false};
+        // A restored transcript still read on a worker thread, or read while
+        // its tab wasn't shown
+        bool reading{false};
+        QSharedPointer<LoadedTranscript> read;
+        TranscriptState state;
+        // Estimated when the tab is read and each time its state is stored
+        qint64 footprint{0};
+        quint64 lastUsed{0};
+    };
+
+    void show(Tab& tab, const LoadedTranscript& loaded);
+    void unload(Tab& tab);
+    void enforceBudget();
+    void updateTitle(int index);
+
+    static qint64 footprint(const QTextDocument *document, const QVector<block>& blocks);
+    static QUrl findMedia(const QUrl& transcriptUrl);
+
+    Editor *m_editor = nullptr;
+    MediaPlayer *m_player = nullptr;
+    QTabBar *m_tabBar = nullptr;
+    QVector<Tab> m_tabs;
+    int m_current{-1};
+    bool m_switching{false};
+    quint64 m_useCounter{0};
+    qint64 m_memoryBudget{128 * 1024 * 1024};
+};
@@ -0,0 +1,230 @@
+#include "transcriptwriter.h"
+
+#include <QLocale>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QXmlStreamWriter>
+
+namespace {
+    // What QXmlStreamWriter escapes, attributes also escape whitespace.
+    // Characters it can't write at all are dropped the same way.
+    void appendEscaped(QByteArray& out, const QString& text, bool attribute)
+    {
+        bool plain{true};
+        for (auto c: text) {
+            auto u = c.unicode();
+            if (u < 0x20 || u >= 0xFFFE || u == '<' || u == '>' || u == '&' || u == '"') {
+                plain = false;
+                break;
+            }
+        }
+        if (plain) {
+            out += text.toUtf8();
+            return;
+        }
+
+        QString escaped;
+        escaped.reserve(text.size());
+        for (auto c: text) {
+            switch (c.unicode()) {
+            case '<': escaped += QLatin1String("&lt;"); break;
+            case '>': escaped += QLatin1String("&gt;"); break;
+            case '&': escaped += QLatin1String("&amp;"); break;
+            case '"': escaped += QLatin1String("&quot;"); break;
+            case '\t':
+                if (attribute)
+                    escaped += QLatin1String("&#9;");
+                else
+                    escaped += c;
+                break;
+            case '\n':
+                if (attribute)
+                    escaped += QLatin1String("&#10;");
+                else
+                    escaped += c;
+                break;
+            case '\r':
+                if (attribute)
+                    escaped += QLatin1String("&#13;");
+                else
+                    escaped += c;
+                break;
+            default:
+                if (c.unicode() > 0x1f && c.unicode() < 0xFFFE)
+                    escaped += c;
+                break;
+            }
+        }
+        out += escaped.toUtf8();
+    }
+
+    // QTime::toString("hh:mm:ss.zzz") without parsing the format every time
+    void appendTime(QByteArray& out, const QTime& time)
+    {
+        if (!time.isValid())
+            return;
+
+        auto msecs = time.msecsSinceStartOfDay();
+        char text[12];
+        auto put = [&text](int at, int value, int digits) {
+            for (int i = digits - 1; i >= 0; i--, value /= 10)
+                text[at + i] = char('0' + value % 10);
+        };
+        put(0, msecs / 3600000, 2);
+        text[2] = ':';
+        put(3, msecs / 60000 % 60, 2);
+        text[5] = ':';
+        put(6, msecs / 1000 % 60, 2);
+        text[8] = '.';
+        put(9, msecs % 1000, 3);
+        out.append(text, 12);
+    }
+
+    void appendAttributes(QByteArray& out, const QStringList& tagList, double confidence)
+    {
+        if (!tagList.isEmpty()) {
+            out += " tags=\"";
+            appendEscaped(out, tagList.join(","), true);
+            out += '"';
+        }
+        if (confidence >= 0) {
+            out += " confidence=\"";
+            out += QString::number(confidence, 'g', QLocale::FloatingPointShortest).toUtf8();
+            out += '"';
+        }
+    }
+
+    QByteArray formatLines(const QVector<block>& blocks, int first, int last)
+    {
+        QByteArray out;
+        for (int i = first; i < last; i++) {
+            auto& a_block = blocks[i];
+            if (a_block.text == "")
+                continue;
+
+            out += "\n    <line timestamp=\"";
+            appendTime(out, a_block.timeStamp);
+            out += "\" speaker=\"";
+            appendEscaped(out, a_block.speaker, true);
+            out += '"';
+            appendAttributes(out, a_block.tagList, a_block.confidence);
+
+            if (a_block.words.isEmpty()) {
+                out += "/>";
+                continue;
+            }
+            out += '>';
+
+            for (auto& a_word: a_block.words) {
+                out += "\n        <word timestamp=\"";
+                appendTime(out, a_word.timeStamp);
+                out += '"';
+                appendAttributes(out, a_word.tagList, a_word.confidence);
+                out += '>';
+                appendEscaped(out, a_word.text, false);
+                out += "</word>";
+            }
+            out += "\n    </line>";
+        }
+        return out;
+    }
+}
+
+QByteArray TranscriptWriter::toXml(const QString& lang, const QVector<block>& blocks, int threads)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    if (blocks.size() < parallelThreshold)
+        threads = 1;
+
+    QVector<QByteArray> chunks;
+    if (threads == 1)
+        chunks.append(formatLines(blocks, 0, blocks.size()));
+    else {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+
+        QVector<QFuture<QByteArray>> futures;
+        for (int i = 0; i < threads; i++) {
+            int first = int(qint64(blocks.size()) * i / threads);
+            int last = int(qint64(blocks.size()) * (i + 1) / threads);
+            futures.append(QtConcurrent::run(&pool, [&blocks, first, last] {
+                return formatLines(blocks, first, last);
+            }));
+        }
+        for (auto& future: futures)
+            chunks.append(future.result());
+    }
+
+    QByteArray xml("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<transcript");
+    if (lang != "") {
+        xml += " lang=\"";
+        appendEscaped(xml, lang, true);
+        xml += '"';
+    }
+
+    int size{0};
+    for (auto& chunk: qAsConst(chunks))
+        size += chunk.size();
+
+    // Without any line the writer closes <transcript/> right away
+    if (size == 0)
+        return xml + "/>";
+
+    xml.reserve(xml.size() + size + 16);
+    xml += '>';
+    for (auto& chunk: qAsConst(chunks))
+        xml += chunk;
+    xml += "\n</transcript>";
+    return xml;
+}
+
+bool TranscriptWriter::write(QIODevice* device, const QString& lang, const QVector<block>& blocks, int threads)
+{
+    auto xml = toXml(lang, blocks, threads);
+    return device->write(xml) == xml.size();
+}
+
+void TranscriptWriter::writeReference(QIODevice* device, const QString& lang, const QVector<block>& blocks)
+{
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement("transcript");
+
+    if (lang != "")
+        writer.writeAttribute("lang", lang);
+
+    for (auto& a_block: blocks) {
+        if (a_block.text != "") {
+            auto timeStamp = a_block.timeStamp;
+            QString timeStampString = timeStamp.toString("hh:mm:ss.zzz");
+            auto speaker = a_block.speaker;
+
+            writer.writeStartElement("line");
+            writer.writeAttribute("timestamp", timeStampString);
+            writer.writeAttribute("speaker", speaker);
+
+            if (!a_block.tagList.isEmpty())
+                writer.writeAttribute("tags", a_block.tagList.join(","));
+            if (a_block.confidence >= 0)
+                writer.writeAttribute("confidence", QString::number(a_block.confidence, 'g', QLocale::FloatingPointShortest));
+
+            for (auto& a_word: a_block.words) {
+                writer.writeStartElement("word");
+                writer.writeAttribute("timestamp", a_word.timeStamp.toString("hh:mm:ss.zzz"));
+
+                if (!a_word.tagList.isEmpty())
+                    writer.writeAttribute("tags", a_word.tagList.join(","));
+                if (a_word.confidence >= 0)
+                    writer.writeAttribute("confidence", QString::number(a_word.confidence, 'g', QLocale::FloatingPointShortest));
+
+                writer.writeCharacters(a_word.text);
+                writer.writeEndElement();
+            }
+            writer.writeEndElement();
+        }
+    }
+    writer.writeEndElement();
+}
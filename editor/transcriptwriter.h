@@ -0,0 +1,22 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QIODevice>
+
+// Writes transcript XML byte for byte the way an auto-formatting
+// QXmlStreamWriter does, without going through one. Runs of lines are
+// formatted into separate buffers on a thread pool and joined in order, the
+// file then gets a single write.
+class TranscriptWriter
+{
+public:
+    // Fewer lines are formatted on the calling thread
+    static const int parallelThreshold = 2000;
+
+    static QByteArray toXml(const QString& lang, const QVector<block>& blocks, int threads = 0);
+    static bool write(QIODevice* device, const QString& lang, const QVector<block>& blocks, int threads = 0);
+
+    // The QXmlStreamWriter the output has to match
+    static void writeReference(QIODevice* device, const QString& lang, const QVector<block>& blocks);
+};
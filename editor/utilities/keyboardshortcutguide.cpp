@@ -48,6 +48,9 @@ void KeyboardShortcutGuide::fillDialog() {
     QStringList zoomIn({"Increase Font Size", QKeySequence(Qt::CTRL+Qt::Key_Equal).toString()});
     QStringList zoomOut({"Decrease Font Size", QKeySequence(Qt::CTRL+Qt::Key_Minus).toString()});
     QStringList saveTranscript({"Save Transcript", QKeySequence(Qt::CTRL+Qt::Key_S).toString()});
+    QStringList openInTabs({"Open Transcripts in Tabs", QKeySequence(Qt::CTRL+Qt::SHIFT+Qt::Key_O).toString()});
+    QStringList nextTab({"Next Transcript", QKeySequence(Qt::CTRL+Qt::Key_PageDown).toString()});
+    QStringList previousTab({"Previous Transcript", QKeySequence(Qt::CTRL+Qt::Key_PageUp).toString()});
     QStringList splitLine({"Split Line", QKeySequence(Qt::CTRL+Qt::Key_Semicolon).toString()});
     QStringList jumpToHighlightedLine({"Jump to Highlighted Line", QKeySequence(Qt::CTRL+Qt::Key_J).toString()});
     QStringList mergeUp({"Merge Up", QKeySequence(Qt::CTRL+Qt::Key_Up).toString()});
@@ -56,6 +59,8 @@ void KeyboardShortcutGuide::fillDialog() {
     QStringList changeSpeaker({"Change Speaker", QKeySequence(Qt::CTRL+Qt::Key_R).toString()});
     QStringList propagateTime({"Propagate Time", QKeySequence(Qt::CTRL+Qt::Key_T).toString()});
     QStringList editTags({"Edit Tags", QKeySequence(Qt::CTRL+Qt::Key_Apostrophe).toString()});
+    QStringList nextLowConfidence({"Next Low Confidence Word", QKeySequence(Qt::Key_F8).toString()});
+    QStringList previousLowConfidence({"Previous Low Confidence Word", QKeySequence(Qt::SHIFT+Qt::Key_F8).toString()});
 
     editing->addChild(new QTreeWidgetItem(undo));
     editing->addChild(new QTreeWidgetItem(redo));
@@ -66,6 +71,9 @@ void KeyboardShortcutGuide::fillDialog() {
     editing->addChild(new QTreeWidgetItem(zoomIn));
     editing->addChild(new QTreeWidgetItem(zoomOut));
     editing->addChild(new QTreeWidgetItem(saveTranscript));
+    editing->addChild(new QTreeWidgetItem(openInTabs));
+    editing->addChild(new QTreeWidgetItem(nextTab));
+    editing->addChild(new QTreeWidgetItem(previousTab));
     editing->addChild(new QTreeWidgetItem(splitLine));
     editing->addChild(new QTreeWidgetItem(jumpToHighlightedLine));
     editing->addChild(new QTreeWidgetItem(mergeUp));
@@ -74,6 +82,8 @@ void KeyboardShortcutGuide::fillDialog() {
     editing->addChild(new QTreeWidgetItem(changeSpeaker));
     editing->addChild(new QTreeWidgetItem(propagateTime));
     editing->addChild(new QTreeWidgetItem(editTags));
+    editing->addChild(new QTreeWidgetItem(nextLowConfidence));
+    editing->addChild(new QTreeWidgetItem(previousLowConfidence));
 
     auto insertTimeStamp = new QTreeWidgetItem({"Insert Player timestamp in active editor", QKeySequence(Qt::CTRL + Qt::Key_I).toString()});
 
@@ -96,10 +106,12 @@ void KeyboardShortcutGuide::fillDialog() {
     QStringList playPause({"Play / Pause", QKeySequence(Qt::CTRL+Qt::Key_Space).toString()});
     QStringList seekForward({"Seek Forward", QKeySequence(Qt::CTRL+Qt::Key_Period).toString()});
     QStringList seekBackward({"Seek Backward", QKeySequence(Qt::CTRL+Qt::Key_Comma).toString()});
+    QStringList loopLine({"Loop Current Line", QKeySequence(Qt::CTRL+Qt::Key_L).toString()});
 
     mediaPlayer->addChild(new QTreeWidgetItem(playPause));
     mediaPlayer->addChild(new QTreeWidgetItem(seekForward));
     mediaPlayer->addChild(new QTreeWidgetItem(seekBackward));
+    mediaPlayer->addChild(new QTreeWidgetItem(loopLine));
 
     m_shortcutView->insertTopLevelItem(0, app);
     m_shortcutView->insertTopLevelItem(1, insertTimeStamp);
@@ -0,0 +1,207 @@
+#include "oovstatisticsdialog.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QSaveFile>
+#include <QSet>
+
+namespace {
+    enum Column {WordColumn, CountColumn, SpeakersColumn, FirstColumn, LastColumn};
+
+    // Statistics change on every keystroke, the table follows a moment later
+    const int refreshDelay = 300;
+
+    QString csvField(QString field)
+    {
+        if (!field.contains(',') && !field.contains('"') && !field.contains('\n'))
+            return field;
+        return "\"" + field.replace("\"", "\"\"") + "\"";
+    }
+}
+
+OovStatisticsDialog::OovStatisticsDialog(QWidget* parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Out-of-Vocabulary Words");
+    resize(640, 720);
+
+    m_speaker = new QComboBox(this);
+    m_useTimeRange = new QCheckBox("Between", this);
+    m_from = new QTimeEdit(this);
+    m_to = new QTimeEdit(QTime(23, 59, 59, 999), this);
+    for (auto timeEdit: {m_from, m_to}) {
+        timeEdit->setDisplayFormat("hh:mm:ss");
+        timeEdit->setEnabled(false);
+    }
+
+    auto filters = new QHBoxLayout;
+    filters->addWidget(m_speaker, 1);
+    filters->addWidget(m_useTimeRange);
+    filters->addWidget(m_from);
+    filters->addWidget(new QLabel("and", this));
+    filters->addWidget(m_to);
+
+    m_table = new QTableWidget(0, 5, this);
+    m_table->setHorizontalHeaderLabels({"Word", "Count", "Speakers", "First", "Last"});
+    m_table->horizontalHeader()->setSectionResizeMode(SpeakersColumn, QHeaderView::Stretch);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_table->setSortingEnabled(true);
+    m_table->sortByColumn(CountColumn, Qt::DescendingOrder);
+
+    m_summary = new QLabel(this);
+
+    auto acceptButton = new QPushButton("Mark Selected As Correct", this);
+    auto exportButton = new QPushButton("Export...", this);
+    auto closeButton = new QPushButton("Close", this);
+
+    auto buttons = new QHBoxLayout;
+    buttons->addWidget(m_summary, 1);
+    buttons->addWidget(acceptButton);
+    buttons->addWidget(exportButton);
+    buttons->addWidget(closeButton);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addLayout(filters);
+    layout->addWidget(m_table);
+    layout->addLayout(buttons);
+    setLayout(layout);
+
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(refreshDelay);
+
+    connect(&m_refreshTimer, &QTimer::timeout, this, &OovStatisticsDialog::refresh);
+    connect(m_speaker, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &OovStatisticsDialog::refresh);
+    connect(m_useTimeRange, &QCheckBox::toggled, this,
+        [this](bool checked)
+        {
+            m_from->setEnabled(checked);
+            m_to->setEnabled(checked);
+            refresh();
+        }
+    );
+    connect(m_from, &QTimeEdit::timeChanged, this, [this]() {m_refreshTimer.start();});
+    connect(m_to, &QTimeEdit::timeChanged, this, [this]() {m_refreshTimer.start();});
+    connect(m_table, &QTableWidget::cellDoubleClicked, this,
+            [this](int row) {emit findWord(m_table->item(row, WordColumn)->text());});
+    connect(acceptButton, &QPushButton::clicked, this,
+        [this]()
+        {
+            auto words = selectedWords();
+            if (words.isEmpty())
+                emit message("No words selected");
+            else
+                emit acceptWords(words);
+        }
+    );
+    connect(exportButton, &QPushButton::clicked, this, &OovStatisticsDialog::exportCsv);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+}
+
+void OovStatisticsDialog::setStatistics(const OovStatistics& statistics)
+{
+    m_statistics = statistics;
+    m_refreshTimer.start();
+}
+
+void OovStatisticsDialog::refresh()
+{
+    m_refreshTimer.stop();
+
+    auto currentSpeaker = m_speaker->currentIndex() > 0 ? m_speaker->currentText() : QString();
+    auto speakers = m_statistics.speakers();
+    if (!currentSpeaker.isEmpty() && !speakers.contains(currentSpeaker))
+        speakers.append(currentSpeaker);
+
+    m_speaker->blockSignals(true);
+    m_speaker->clear();
+    m_speaker->addItem("All Speakers");
+    m_speaker->addItems(speakers);
+    m_speaker->setCurrentIndex(currentSpeaker.isEmpty() ? 0 : m_speaker->findText(currentSpeaker));
+    m_speaker->blockSignals(false);
+
+    qint64 from{-1}, to{-1};
+    if (m_useTimeRange->isChecked()) {
+        from = m_from->time().msecsSinceStartOfDay();
+        to = m_to->time().msecsSinceStartOfDay();
+    }
+    auto entries = m_statistics.report(currentSpeaker, from, to);
+
+    auto selected = selectedWords();
+    QSet<QString> keepSelected(selected.begin(), selected.end());
+
+    // Filling a sorted table moves rows under our feet
+    m_table->setSortingEnabled(false);
+    m_table->clearSelection();
+    m_table->setRowCount(entries.size());
+
+    for (int row = 0; row < entries.size(); row++) {
+        auto& entry = entries[row];
+
+        QStringList speakerCounts;
+        for (auto it = entry.speakers.constBegin(); it != entry.speakers.constEnd(); ++it)
+            speakerCounts << QString("%1 (%2)").arg(it.key().isEmpty() ? QString("-") : it.key(), QString::number(it.value()));
+
+        auto countItem = new QTableWidgetItem;
+        countItem->setData(Qt::DisplayRole, entry.count);
+
+        m_table->setItem(row, WordColumn, new QTableWidgetItem(entry.word));
+        m_table->setItem(row, CountColumn, countItem);
+        m_table->setItem(row, SpeakersColumn, new QTableWidgetItem(speakerCounts.join(", ")));
+        m_table->setItem(row, FirstColumn, new QTableWidgetItem(entry.first.toString("hh:mm:ss.zzz")));
+        m_table->setItem(row, LastColumn, new QTableWidgetItem(entry.last.toString("hh:mm:ss.zzz")));
+
+        if (keepSelected.contains(entry.word))
+            for (int column = WordColumn; column <= LastColumn; column++)
+                m_table->item(row, column)->setSelected(true);
+    }
+
+    m_table->setSortingEnabled(true);
+
+    int occurrences{0};
+    for (auto& entry: qAsConst(entries))
+        occurrences += entry.count;
+    m_summary->setText(QString("%1 words, %2 occurrences").arg(QString::number(entries.size()), QString::number(occurrences)));
+}
+
+void OovStatisticsDialog::exportCsv()
+{
+    auto fileName = QFileDialog::getSaveFileName(this, "Export Out-of-Vocabulary Words", "oov_words.csv", "CSV (*.csv)");
+    if (fileName.isEmpty())
+        return;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        emit message(file.errorString());
+        return;
+    }
+
+    // Rows in the order and with the filters currently shown
+    file.write("word,count,speakers,first,last\n");
+    for (int row = 0; row < m_table->rowCount(); row++) {
+        QStringList fields;
+        for (int column = WordColumn; column <= LastColumn; column++)
+            fields << csvField(m_table->item(row, column)->text());
+        file.write(fields.join(",").toUtf8() + "\n");
+    }
+
+    if (!file.commit()) {
+        emit message(file.errorString());
+        return;
+    }
+    emit message("Exported " + QString::number(m_table->rowCount()) + " words to " + fileName);
+}
+
+QStringList OovStatisticsDialog::selectedWords() const
+{
+    QStringList words;
+    for (auto& range: m_table->selectedRanges())
+        for (int row = range.topRow(); row <= range.bottomRow(); row++)
+            words << m_table->item(row, WordColumn)->text();
+    return words;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "editor/oovstatistics.h"
+
+#include <QDialog>
+#include <QTableWidget>
+#include <QComboBox>
+#include <QTimeEdit>
+#include <QCheckBox>
+#include <QLabel>
+#include <QTimer>
+
+// Out-of-vocabulary words of the open transcript by frequency, speaker and
+// time. Frequent names can be accepted in bulk instead of one underline at a
+// time, and the table can be exported as CSV for the rest of the team.
+class OovStatisticsDialog: public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit OovStatisticsDialog(QWidget* parent = nullptr);
+
+public slots:
+    void setStatistics(const OovStatistics& statistics);
+
+signals:
+    void acceptWords(const QStringList& words);
+    void findWord(const QString& word);
+    void message(const QString& text, int timeout = 5000);
+
+private slots:
+    void refresh();
+    void exportCsv();
+
+private:
+    QStringList selectedWords() const;
+
+    OovStatistics m_statistics;
+    QTableWidget* m_table;
+    QComboBox* m_speaker;
+    QCheckBox* m_useTimeRange;
+    QTimeEdit *m_from, *m_to;
+    QLabel* m_summary;
+    QTimer m_refreshTimer;
+};
@@ -0,0 +1,115 @@
+#include "wordindex.h"
+
+#include <algorithm>
+
+void WordIndex::rebuild(const QVector<block>& blocks, const Tokenizer& tokenizer)
+{
+    clear();
+    m_tokenizer = tokenizer;
+    m_built = true;
+    blocksInserted(0, blocks.size());
+    update(0, blocks.size() - 1, blocks);
+}
+
+void WordIndex::clear()
+{
+    m_blocks.clear();
+    m_occurrences.clear();
+    m_rows.clear();
+    m_rowsDirty = true;
+    m_built = false;
+}
+
+void WordIndex::blocksInserted(int at, int count)
+{
+    if (!m_built || at < 0 || at > m_blocks.size() || count <= 0)
+        return;
+
+    m_blocks.insert(at, count, BlockWords());
+    for (int i = at; i < at + count; i++)
+        m_blocks[i].id = m_nextId++;
+    m_rowsDirty = true;
+}
+
+void WordIndex::blocksRemoved(int at, int count)
+{
+    if (!m_built || at < 0 || count <= 0 || at + count > m_blocks.size())
+        return;
+
+    for (int i = at; i < at + count; i++)
+        remove(m_blocks[i]);
+    m_blocks.remove(at, count);
+    m_rowsDirty = true;
+}
+
+void WordIndex::update(int first, int last, const QVector<block>& blocks)
+{
+    if (!m_built)
+        return;
+    if (m_blocks.size() != blocks.size()) {
+        rebuild(blocks, m_tokenizer);
+        return;
+    }
+
+    for (int i = qMax(first, 0); i <= last && i < blocks.size(); i++) {
+        auto& blockWords = m_blocks[i];
+        remove(blockWords);
+
+        blockWords.words.clear();
+        for (auto& a_word: blocks[i].words)
+            blockWords.words.append(m_tokenizer.normalized(a_word.text));
+
+        add(blockWords);
+    }
+}
+
+QVector<QPair<int, int>> WordIndex::positions(const QString& word) const
+{
+    QVector<QPair<int, int>> positions;
+    auto it = m_occurrences.constFind(word);
+    if (it == m_occurrences.constEnd())
+        return positions;
+
+    for (auto id: it.value()) {
+        int row = rowOf(id);
+        if (row == -1)
+            continue;
+        auto& words = m_blocks[row].words;
+        for (int j = 0; j < words.size(); j++)
+            if (words[j] == word)
+                positions.append({row, j});
+    }
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+void WordIndex::add(const BlockWords& blockWords)
+{
+    for (auto& a_word: blockWords.words)
+        m_occurrences[a_word].insert(blockWords.id);
+}
+
+void WordIndex::remove(const BlockWords& blockWords)
+{
+    for (auto& a_word: blockWords.words) {
+        auto it = m_occurrences.find(a_word);
+        if (it == m_occurrences.end())
+            continue;
+        it.value().remove(blockWords.id);
+        if (it.value().isEmpty())
+            m_occurrences.erase(it);
+    }
+}
+
+int WordIndex::rowOf(quint64 id) const
+{
+    // Only lines added or removed invalidate the rows, typing doesn't
+    if (m_rowsDirty) {
+        m_rows.clear();
+        m_rows.reserve(m_blocks.size());
+        for (int i = 0; i < m_blocks.size(); i++)
+            m_rows.insert(m_blocks[i].id, i);
+        m_rowsDirty = false;
+    }
+    return m_rows.value(id, -1);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "blockobserver.h"
+#include "tokenizer.h"
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QPair>
+
+// Where every word of the transcript occurs, by its normalized form. Like the
+// confidence queue, blocks keep a stable key so inserting or removing lines
+// doesn't renumber the index, and an edit only re-reads the blocks it touched.
+class WordIndex : public BlockObserver
+{
+public:
+    void rebuild(const QVector<block>& blocks, const Tokenizer& tokenizer);
+    void clear();
+    bool isBuilt() const {return m_built;}
+
+    void blocksInserted(int at, int count) override;
+    void blocksRemoved(int at, int count) override;
+    void update(int first, int last, const QVector<block>& blocks) override;
+
+    // Block and word numbers, in document order
+    QVector<QPair<int, int>> positions(const QString& word) const;
+
+private:
+    struct BlockWords
+    {
+        quint64 id{0};
+        QStringList words;
+    };
+
+    void add(const BlockWords& blockWords);
+    void remove(const BlockWords& blockWords);
+    int rowOf(quint64 id) const;
+
+    QVector<BlockWords> m_blocks;
+    QHash<QString, QSet<quint64>> m_occurrences;
+    quint64 m_nextId{0};
+    Tokenizer m_tokenizer;
+    bool m_built{false};
+    mutable QHash<quint64, int> m_rows;
+    mutable bool m_rowsDirty{true};
+};
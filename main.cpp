@@ -1,6 +1,7 @@
 #include "tool.h"
 
 #include <QApplication>
+#include <QDebug>
 
 void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
@@ -51,10 +52,15 @@ void customMessageHandler(QtMsgType type, const QMessageLogContext &context, con
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     qInstallMessageHandler(customMessageHandler);
     QApplication a(argc, argv);
 
     Tool w;
+    w.setStartupTimer(startupTimer);
+    qInfo() << "[Startup]" << QString("window built after %1 ms").arg(QString::number(startupTimer.elapsed()));
     w.show();
 
     return a.exec();
@@ -1,8 +1,21 @@
 #include "mediaplayer.h"
+#include "seekscheduler.h"
 
 MediaPlayer::MediaPlayer(QWidget *parent)
     : QMediaPlayer(parent)
 {
+    m_seekScheduler = new SeekScheduler(this);
+
+    // Seeking only works once the backend knows the media
+    connect(this, &QMediaPlayer::mediaStatusChanged, this,
+        [this](QMediaPlayer::MediaStatus status)
+        {
+            if (status == QMediaPlayer::LoadedMedia && m_positionAfterLoad > 0)
+                seekTo(m_positionAfterLoad);
+            if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::InvalidMedia)
+                m_positionAfterLoad = 0;
+        }
+    );
 }
 
 QTime MediaPlayer::elapsedTime()
@@ -19,8 +32,12 @@ void MediaPlayer::setPositionToTime(const QTime& time)
 {
     if (time.isNull())
         return;
-    qint64 position = 3600000*time.hour() + 60000*time.minute() + 1000*time.second() + time.msec();
-    setPosition(position);
+    seekTo(positionFromTime(time));
+}
+
+qint64 MediaPlayer::positionFromTime(const QTime& time)
+{
+    return 3600000LL * time.hour() + 60000LL * time.minute() + 1000LL * time.second() + time.msec();
 }
 
 QString MediaPlayer::getMediaFileName()
@@ -28,6 +45,11 @@ QString MediaPlayer::getMediaFileName()
     return m_mediaFileName;
 }
 
+QString MediaPlayer::seekStatistics() const
+{
+    return m_seekScheduler->statistics();
+}
+
 QString MediaPlayer::getPositionInfo()
 {
     QString format = "mm:ss";
@@ -46,22 +68,29 @@ void MediaPlayer::open()
         fileDialog.setMimeTypeFilters(supportedMimeTypes);
     fileDialog.setDirectory(QStandardPaths::standardLocations(QStandardPaths::MoviesLocation).value(0, QDir::homePath()));
     if (fileDialog.exec() == QDialog::Accepted) {
-        QUrl *fileUrl = new QUrl(fileDialog.selectedUrls().constFirst());
-        m_mediaFileName = fileUrl->fileName();
-        setMedia(*fileUrl);
-        emit message("Opened file " + fileUrl->fileName());
+        auto fileUrl = fileDialog.selectedUrls().constFirst();
+        load(fileUrl);
+        emit message("Opened file " + fileUrl.fileName());
         play();
     }
 }
 
+void MediaPlayer::load(const QUrl& fileUrl, qint64 position)
+{
+    m_mediaFileName = fileUrl.fileName();
+    m_positionAfterLoad = position;
+    setMedia(fileUrl);
+}
+
 void MediaPlayer::seek(int seconds)
 {
-    if (elapsedTime().addSecs(seconds) > durationTime())
-        setPosition(duration());
-    else if (elapsedTime().addSecs(seconds).isNull())
-        setPosition(0);
-    else
-        setPositionToTime(elapsedTime().addSecs(seconds));
+    // Relative to where a pending seek is heading, so repeated steps add up
+    seekTo(m_seekScheduler->target() + 1000LL * seconds);
+}
+
+void MediaPlayer::seekTo(qint64 position)
+{
+    m_seekScheduler->request(position);
 }
 
 QTime MediaPlayer::getTimeFromPosition(const qint64& position)
@@ -6,6 +6,8 @@
 #include <QStandardPaths>
 #include <QTime>
 
+class SeekScheduler;
+
 class MediaPlayer : public QMediaPlayer
 {
     Q_OBJECT
@@ -16,10 +18,14 @@ public:
     void setPositionToTime(const QTime& time);
     QString getMediaFileName();
     QString getPositionInfo();
+    QString seekStatistics() const;
+    static qint64 positionFromTime(const QTime& time);
 
 public slots:
     void open();
+    void load(const QUrl& fileUrl, qint64 position = 0);
     void seek(int seconds);
+    void seekTo(qint64 position);
     void togglePlayback();
 
 signals:
@@ -28,4 +34,6 @@ signals:
 private:
     static QTime getTimeFromPosition(const qint64& position);
     QString m_mediaFileName;
+    SeekScheduler *m_seekScheduler = nullptr;
+    qint64 m_positionAfterLoad{0};
 };
@@ -0,0 +1,160 @@
+#include "peakpyramid.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+namespace {
+    const quint32 cacheMagic = 0x5045414b; // "PEAK"
+    const quint16 cacheVersion = 1;
+    const qint64 hashChunkSize = 1 << 20;
+}
+
+PeakPyramid::PeakPyramid(int sampleRate, const QVector<WaveformPeak>& basePeaks)
+    : m_sampleRate(sampleRate)
+{
+    m_levels.append(basePeaks);
+    buildLevels();
+}
+
+qint64 PeakPyramid::duration() const
+{
+    if (isEmpty() || !m_sampleRate)
+        return 0;
+    return m_levels.first().size() * samplesPerPeak(0) * 1000 / m_sampleRate;
+}
+
+WaveformPeak PeakPyramid::peakInRange(qint64 startPosition, qint64 endPosition) const
+{
+    WaveformPeak peak;
+    if (isEmpty() || endPosition <= startPosition)
+        return peak;
+
+    qint64 startSample = startPosition * m_sampleRate / 1000;
+    qint64 endSample = endPosition * m_sampleRate / 1000;
+    qint64 span = qMax<qint64>(1, endSample - startSample);
+
+    // Coarsest level that still has at least one peak inside the range
+    int levelNumber = 0;
+    while (levelNumber + 1 < m_levels.size() && samplesPerPeak(levelNumber + 1) <= span)
+        levelNumber++;
+
+    auto& peaks = m_levels[levelNumber];
+    auto peakSpan = samplesPerPeak(levelNumber);
+    qint64 first = startSample / peakSpan;
+    qint64 last = qMax(first + 1, (endSample + peakSpan - 1) / peakSpan);
+    last = qMin<qint64>(last, peaks.size());
+
+    if (first >= last)
+        return peak;
+
+    peak = peaks[first];
+    for (qint64 i = first + 1; i < last; i++) {
+        peak.min = qMin(peak.min, peaks[i].min);
+        peak.max = qMax(peak.max, peaks[i].max);
+    }
+    return peak;
+}
+
+void PeakPyramid::buildLevels()
+{
+    while (m_levels.last().size() > 1) {
+        auto& previous = m_levels.last();
+        QVector<WaveformPeak> next((previous.size() + 1) / 2);
+
+        for (int i = 0; i < next.size(); i++) {
+            auto left = previous[2 * i];
+            auto right = (2 * i + 1 < previous.size()) ? previous[2 * i + 1] : left;
+            next[i] = {qMin(left.min, right.min), qMax(left.max, right.max)};
+        }
+        m_levels.append(next);
+    }
+}
+
+bool PeakPyramid::save(const QString& cacheFileName, const QByteArray& mediaHash) const
+{
+    if (isEmpty())
+        return false;
+
+    QDir().mkpath(QFileInfo(cacheFileName).absolutePath());
+    QSaveFile file(cacheFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&file);
+    out << cacheMagic << cacheVersion << mediaHash << qint32(m_sampleRate);
+
+    // Only the base level is stored, the coarser levels are cheap to rebuild
+    auto& basePeaks = m_levels.first();
+    out << quint64(basePeaks.size());
+    for (auto& peak: basePeaks)
+        out << peak.min << peak.max;
+
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+QSharedPointer<PeakPyramid> PeakPyramid::load(const QString& cacheFileName, const QByteArray& mediaHash)
+{
+    QFile file(cacheFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    QDataStream in(&file);
+    quint32 magic;
+    quint16 version;
+    QByteArray hash;
+    qint32 sampleRate;
+    quint64 peakCount;
+
+    in >> magic >> version >> hash >> sampleRate >> peakCount;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion
+            || hash != mediaHash || sampleRate <= 0
+            || peakCount * sizeof(WaveformPeak) > quint64(file.size()))
+        return {};
+
+    QVector<WaveformPeak> basePeaks(static_cast<int>(peakCount));
+    for (auto& peak: basePeaks)
+        in >> peak.min >> peak.max;
+
+    if (in.status() != QDataStream::Ok)
+        return {};
+
+    return QSharedPointer<PeakPyramid>::create(sampleRate, basePeaks);
+}
+
+QStringList PeakPyramid::cacheFileNames(const QString& mediaFileName, const QByteArray& mediaHash)
+{
+    // Prefer a file next to the media, fall back to the user cache when the
+    // media directory is read only
+    QFileInfo mediaInfo(mediaFileName);
+    auto cacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    return {
+        mediaInfo.absolutePath() + "/." + mediaInfo.fileName() + ".peaks",
+        cacheDirectory + "/waveforms/" + QString::fromLatin1(mediaHash.toHex()) + ".peaks"
+    };
+}
+
+QByteArray PeakPyramid::mediaHash(const QString& mediaFileName)
+{
+    QFile file(mediaFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    // Hashing multi-gigabyte recordings in full would cost as much as decoding
+    // them, so the key covers the size and the first and last megabyte
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    auto size = file.size();
+    hash.addData(QByteArray::number(size));
+    hash.addData(file.read(hashChunkSize));
+    if (size > 2 * hashChunkSize) {
+        file.seek(size - hashChunkSize);
+        hash.addData(file.read(hashChunkSize));
+    }
+
+    return hash.result();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include <QMetaType>
+#include <QSharedPointer>
+
+struct WaveformPeak
+{
+    qint16 min{0};
+    qint16 max{0};
+};
+
+// Multi-resolution min/max summary of a decoded audio track. Level 0 holds one
+// peak per baseSamplesPerPeak frames and every following level halves the
+// resolution, so any zoom can be drawn by touching about one peak per pixel.
+class PeakPyramid
+{
+public:
+    static constexpr int baseSamplesPerPeak = 256;
+
+    PeakPyramid() = default;
+    PeakPyramid(int sampleRate, const QVector<WaveformPeak>& basePeaks);
+
+    bool isEmpty() const {return m_levels.isEmpty() || m_levels.first().isEmpty();}
+    int sampleRate() const {return m_sampleRate;}
+    qint64 duration() const;
+    int levelCount() const {return m_levels.size();}
+    qint64 samplesPerPeak(int level) const {return qint64(baseSamplesPerPeak) << level;}
+    const QVector<WaveformPeak>& level(int level) const {return m_levels[level];}
+
+    WaveformPeak peakInRange(qint64 startPosition, qint64 endPosition) const;
+
+    bool save(const QString& cacheFileName, const QByteArray& mediaHash) const;
+    static QSharedPointer<PeakPyramid> load(const QString& cacheFileName, const QByteArray& mediaHash);
+
+    static QStringList cacheFileNames(const QString& mediaFileName, const QByteArray& mediaHash);
+    static QByteArray mediaHash(const QString& mediaFileName);
+
+private:
+    void buildLevels();
+
+    int m_sampleRate{0};
+    QVector<QVector<WaveformPeak>> m_levels;
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<const PeakPyramid>)
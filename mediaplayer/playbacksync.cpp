@@ -0,0 +1,112 @@
+#include "playbacksync.h"
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <QElapsedTimer>
+#include <QtMath>
+
+PlaybackSync::PlaybackSync(MediaPlayer *player, QObject *parent)
+    : QObject(parent),
+    m_player(player)
+{
+    qreal refreshRate = 60;
+    if (auto screen = QGuiApplication::primaryScreen())
+        refreshRate = qMax<qreal>(1, screen->refreshRate());
+
+    m_frameTimer.setSingleShot(true);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    m_frameTimer.setInterval(qCeil(1000 / refreshRate));
+
+    // One periodic report per frame, so the highlight moves every frame. The
+    // frame timer then only folds the extra reports seeks and state changes
+    // add on top, a shorter interval would just have them thrown away.
+    setNotifyInterval(m_frameTimer.interval());
+
+    connect(&m_frameTimer, &QTimer::timeout, this, &PlaybackSync::flush);
+    connect(m_player, &QMediaPlayer::positionChanged, this, &PlaybackSync::schedule);
+    connect(m_player, &QMediaPlayer::durationChanged, this, &PlaybackSync::durationChanged);
+}
+
+void PlaybackSync::bind(QSlider *slider, QLabel *label)
+{
+    m_slider = slider;
+    m_label = label;
+}
+
+void PlaybackSync::setNotifyInterval(int milliseconds)
+{
+    m_player->setNotifyInterval(milliseconds);
+}
+
+QString PlaybackSync::statistics() const
+{
+    return QString("Position updates: %1 handled, %2 coalesced, average %3 us, max %4 us, notify interval %5 ms")
+            .arg(QString::number(m_updateCount),
+                 QString::number(m_skippedCount),
+                 QString::number(averageCost() / 1000),
+                 QString::number(m_maxCost / 1000),
+                 QString::number(notifyInterval()));
+}
+
+void PlaybackSync::resetStatistics()
+{
+    m_updateCount = 0;
+    m_skippedCount = 0;
+    m_totalCost = 0;
+    m_maxCost = 0;
+}
+
+void PlaybackSync::schedule(qint64 position)
+{
+    if (m_pendingPosition != -1)
+        m_skippedCount++;
+
+    m_pendingPosition = position;
+    if (!m_frameTimer.isActive())
+        m_frameTimer.start();
+}
+
+void PlaybackSync::durationChanged(qint64 duration)
+{
+    m_duration = duration;
+    m_lastLabelSecond = -1;
+    m_lastSliderPixel = -1;
+
+    if (m_slider)
+        m_slider->setRange(0, static_cast<int>(duration));
+    if (m_label)
+        m_label->setText(m_player->getPositionInfo());
+}
+
+void PlaybackSync::flush()
+{
+    if (m_pendingPosition == -1)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto position = m_pendingPosition;
+    m_pendingPosition = -1;
+
+    if (m_slider && !m_slider->isSliderDown()) {
+        int pixel = m_duration > 0 ? static_cast<int>(position * m_slider->width() / m_duration) : 0;
+        if (pixel != m_lastSliderPixel) {
+            m_lastSliderPixel = pixel;
+            m_slider->setValue(static_cast<int>(position));
+        }
+    }
+
+    // The label only shows whole seconds
+    if (m_label && position / 1000 != m_lastLabelSecond) {
+        m_lastLabelSecond = position / 1000;
+        m_label->setText(m_player->getPositionInfo());
+    }
+
+    emit positionUpdated(position);
+
+    auto cost = timer.nsecsElapsed();
+    m_updateCount++;
+    m_totalCost += cost;
+    m_maxCost = qMax(m_maxCost, cost);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "mediaplayer.h"
+
+#include <QObject>
+#include <QTimer>
+#include <QSlider>
+#include <QLabel>
+
+// Sits between the player's position notifications and the widgets that follow
+// playback. Notifications are coalesced to at most one update per display
+// frame, and the slider and label are only touched when what they show would
+// actually change.
+class PlaybackSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaybackSync(MediaPlayer *player, QObject *parent = nullptr);
+
+    void bind(QSlider *slider, QLabel *label);
+    void setNotifyInterval(int milliseconds);
+    int notifyInterval() const {return m_player->notifyInterval();}
+
+    // Handling cost of the coalesced updates, in nanoseconds
+    quint64 updateCount() const {return m_updateCount;}
+    quint64 skippedCount() const {return m_skippedCount;}
+    qint64 averageCost() const {return m_updateCount ? m_totalCost / qint64(m_updateCount) : 0;}
+    qint64 maxCost() const {return m_maxCost;}
+    QString statistics() const;
+    void resetStatistics();
+
+signals:
+    void positionUpdated(qint64 position);
+
+private slots:
+    void schedule(qint64 position);
+    void durationChanged(qint64 duration);
+    void flush();
+
+private:
+    MediaPlayer *m_player = nullptr;
+    QSlider *m_slider = nullptr;
+    QLabel *m_label = nullptr;
+    QTimer m_frameTimer;
+
+    qint64 m_pendingPosition{-1}, m_duration{0};
+    qint64 m_lastLabelSecond{-1};
+    int m_lastSliderPixel{-1};
+
+    quint64 m_updateCount{0}, m_skippedCount{0};
+    qint64 m_totalCost{0}, m_maxCost{0};
+};
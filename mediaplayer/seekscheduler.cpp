@@ -0,0 +1,117 @@
+#include "seekscheduler.h"
+
+namespace {
+    // A position report this close to the target counts as the seek landing
+    const qint64 landingTolerance = 250;
+    const int landingTimeout = 300;
+}
+
+SeekScheduler::SeekScheduler(QMediaPlayer *player)
+    : QObject(player),
+    m_player(player)
+{
+    m_landingTimer.setSingleShot(true);
+    m_landingTimer.setInterval(landingTimeout);
+
+    connect(&m_landingTimer, &QTimer::timeout, this,
+            [this]()
+            {
+                m_timedOut++;
+                landed();
+            });
+    connect(m_player, &QMediaPlayer::positionChanged, this, &SeekScheduler::positionChanged);
+}
+
+void SeekScheduler::request(qint64 position)
+{
+    auto duration = m_player->duration();
+    position = (duration > 0) ? qBound<qint64>(0, position, duration) : qMax<qint64>(0, position);
+    m_requested++;
+
+    if (m_inFlight == -1) {
+        issue(position);
+        return;
+    }
+
+    if (m_pending != -1)
+        m_merged++;
+    m_pending = position;
+}
+
+qint64 SeekScheduler::target() const
+{
+    if (m_pending != -1)
+        return m_pending;
+    if (m_inFlight != -1)
+        return m_inFlight;
+    return m_player->position();
+}
+
+QString SeekScheduler::statistics() const
+{
+    auto landedCount = m_issued - m_timedOut;
+    auto averageLatency = landedCount ? m_totalLatency / qint64(landedCount) : 0;
+
+    return QString("Seeks: %1 requested, %2 issued, %3 merged, %4 timed out, average latency %5 ms, max %6 ms")
+            .arg(QString::number(m_requested),
+                 QString::number(m_issued),
+                 QString::number(m_merged),
+                 QString::number(m_timedOut),
+                 QString::number(averageLatency),
+                 QString::number(m_maxLatency));
+}
+
+void SeekScheduler::positionChanged(qint64 position)
+{
+    if (m_inFlight == -1 || qAbs(position - m_inFlight) > landingTolerance)
+        return;
+
+    // Playback can pass close to the target before the seek takes effect. A
+    // report only lands it when it is nearer the target than to where
+    // playback would be without the seek, unless the two can't be told apart.
+    auto unseeked = unseekedPosition();
+    if (qAbs(m_inFlight - unseeked) > landingTolerance && qAbs(position - unseeked) <= qAbs(position - m_inFlight))
+        return;
+
+    landed();
+}
+
+void SeekScheduler::landed()
+{
+    if (m_inFlight == -1)
+        return;
+
+    if (m_landingTimer.isActive()) {
+        m_landingTimer.stop();
+        auto latency = m_latencyTimer.elapsed();
+        m_totalLatency += latency;
+        m_maxLatency = qMax(m_maxLatency, latency);
+    }
+
+    m_inFlight = -1;
+
+    if (m_pending != -1) {
+        auto next = m_pending;
+        m_pending = -1;
+        issue(next);
+    }
+}
+
+void SeekScheduler::issue(qint64 position)
+{
+    m_seekFrom = m_player->position();
+    m_inFlight = position;
+    m_issued++;
+    m_latencyTimer.start();
+    m_landingTimer.start();
+    m_player->setPosition(position);
+}
+
+qint64 SeekScheduler::unseekedPosition() const
+{
+    if (m_player->state() != QMediaPlayer::PlayingState)
+        return m_seekFrom;
+
+    auto rate = m_player->playbackRate() > 0 ? m_player->playbackRate() : 1.0;
+    return m_seekFrom + static_cast<qint64>(m_latencyTimer.elapsed() * rate);
+}
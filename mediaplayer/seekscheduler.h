@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMediaPlayer>
+
+// Keeps at most one seek in flight. Requests arriving while the backend is
+// still busy replace each other, so a burst of key repeats costs one extra
+// seek to the latest target instead of a queue of stale ones.
+class SeekScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SeekScheduler(QMediaPlayer *player);
+
+    void request(qint64 position);
+    qint64 target() const;
+    QString statistics() const;
+
+private slots:
+    void positionChanged(qint64 position);
+    void landed();
+
+private:
+    void issue(qint64 position);
+    qint64 unseekedPosition() const;
+
+    QMediaPlayer *m_player = nullptr;
+    QTimer m_landingTimer;
+    QElapsedTimer m_latencyTimer;
+
+    qint64 m_inFlight{-1}, m_pending{-1}, m_seekFrom{0};
+    quint64 m_requested{0}, m_issued{0}, m_merged{0}, m_timedOut{0};
+    qint64 m_totalLatency{0}, m_maxLatency{0};
+};
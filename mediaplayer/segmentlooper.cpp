@@ -0,0 +1,82 @@
+#include "segmentlooper.h"
+
+SegmentLooper::SegmentLooper(MediaPlayer *player)
+    : QObject(player),
+    m_player(player)
+{
+    connect(m_player, &QMediaPlayer::positionChanged, this, &SegmentLooper::positionChanged);
+}
+
+void SegmentLooper::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+
+    m_enabled = enabled;
+
+    if (m_enabled) {
+        m_rateBeforeLoop = m_player->playbackRate();
+        m_player->setPlaybackRate(m_rate);
+        if (hasSegment())
+            restart();
+        else
+            emit message("Loop enabled, move to a line with a timestamp to start looping");
+    }
+    else
+        m_player->setPlaybackRate(m_rateBeforeLoop);
+}
+
+void SegmentLooper::setSegment(qint64 start, qint64 end)
+{
+    if (start == m_start && end == m_end)
+        return;
+
+    m_start = start;
+    m_end = end;
+
+    if (m_enabled && hasSegment())
+        restart();
+}
+
+void SegmentLooper::clearSegment()
+{
+    m_start = 0;
+    m_end = 0;
+}
+
+void SegmentLooper::setPreRoll(qint64 preRoll)
+{
+    m_preRoll = qMax<qint64>(0, preRoll);
+}
+
+void SegmentLooper::setRate(qreal rate)
+{
+    m_rate = rate;
+    if (m_enabled)
+        m_player->setPlaybackRate(m_rate);
+}
+
+void SegmentLooper::positionChanged(qint64 position)
+{
+    if (!m_enabled || !hasSegment())
+        return;
+
+    // Reports from before the restart seek landed are still past the end
+    if (m_restarting) {
+        if (position < m_end)
+            m_restarting = false;
+        return;
+    }
+
+    if (position >= m_end)
+        restart();
+}
+
+void SegmentLooper::restart()
+{
+    m_restarting = true;
+    m_player->seekTo(qMax<qint64>(0, m_start - m_preRoll));
+
+    if (m_player->state() != QMediaPlayer::PlayingState)
+        m_player->play();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "mediaplayer.h"
+
+#include <QObject>
+
+// Replays one segment of the media over and over, optionally starting a
+// little early and at a slower rate. Used to loop the line under the cursor.
+class SegmentLooper : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentLooper(MediaPlayer *player);
+
+    bool isEnabled() const {return m_enabled;}
+    qint64 preRoll() const {return m_preRoll;}
+    qreal rate() const {return m_rate;}
+
+public slots:
+    void setEnabled(bool enabled);
+    void setSegment(qint64 start, qint64 end);
+    void clearSegment();
+    void setPreRoll(qint64 preRoll);
+    void setRate(qreal rate);
+
+signals:
+    void message(const QString& text, int timeout = 5000);
+
+private slots:
+    void positionChanged(qint64 position);
+
+private:
+    bool hasSegment() const {return m_end > m_start;}
+    void restart();
+
+    MediaPlayer *m_player = nullptr;
+    bool m_enabled{false}, m_restarting{false};
+    qint64 m_start{0}, m_end{0}, m_preRoll{0};
+    qreal m_rate{1.0}, m_rateBeforeLoop{1.0};
+};
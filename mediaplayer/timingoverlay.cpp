@@ -0,0 +1,213 @@
+#include "timingoverlay.h"
+
+#include <algorithm>
+#include <limits>
+
+QVector<TimelineMarker> TimingOverlay::markersFromBlocks(const QVector<block>& blocks)
+{
+    return markersFromBlocks(blocks, 0, blocks.size() - 1);
+}
+
+QVector<TimelineMarker> TimingOverlay::markersFromBlocks(const QVector<block>& blocks, int first, int last)
+{
+    QVector<TimelineMarker> markers;
+    const QTime start(0, 0);
+
+    for (int i = qMax(first, 0); i <= last && i < blocks.size(); i++) {
+        auto& a_block = blocks[i];
+        for (int j = 0; j < a_block.words.size(); j++)
+            if (a_block.words[j].timeStamp.isValid())
+                markers.append({start.msecsTo(a_block.words[j].timeStamp), i, j});
+
+        if (a_block.timeStamp.isValid())
+            markers.append({start.msecsTo(a_block.timeStamp), i, -1});
+    }
+
+    return markers;
+}
+
+void TimingOverlay::setMarkers(const QVector<TimelineMarker>& markers)
+{
+    clear();
+    for (auto& a_marker: markers)
+        add(a_marker);
+}
+
+void TimingOverlay::clear()
+{
+    m_blockMarkers.clear();
+    m_wordMarkers.clear();
+    m_blocks.clear();
+    m_rowsDirty = true;
+}
+
+void TimingOverlay::insertBlocks(int at, int count)
+{
+    if (at < 0 || count <= 0)
+        return;
+
+    // Lines past the last one with markers aren't kept, nothing to shift
+    if (at >= m_blocks.size())
+        return;
+
+    m_blocks.insert(at, count, BlockMarkers());
+    for (int i = at; i < at + count; i++)
+        m_blocks[i].id = m_nextId++;
+    m_rowsDirty = true;
+}
+
+void TimingOverlay::removeBlocks(int at, int count, QVector<TimelineMarker>& removed)
+{
+    if (at < 0 || count <= 0 || at >= m_blocks.size())
+        return;
+
+    count = qMin(count, m_blocks.size() - at);
+    for (int i = at; i < at + count; i++)
+        removeMarkers(i, removed);
+    m_blocks.remove(at, count);
+    m_rowsDirty = true;
+}
+
+void TimingOverlay::replaceBlocks(int first, int last, const QVector<TimelineMarker>& markers, QVector<TimelineMarker>& removed)
+{
+    for (int i = qMax(first, 0); i <= last && i < m_blocks.size(); i++)
+        removeMarkers(i, removed);
+
+    for (auto& a_marker: markers)
+        add(a_marker);
+}
+
+void TimingOverlay::add(const TimelineMarker& marker)
+{
+    if (marker.blockNumber < 0)
+        return;
+
+    ensureBlocks(marker.blockNumber + 1);
+    auto& blockMarkers = m_blocks[marker.blockNumber];
+    blockMarkers.markers.append(markers(marker.wordNumber < 0).insert({marker.position, {blockMarkers.id, marker.wordNumber}}));
+}
+
+void TimingOverlay::removeMarkers(int blockNumber, QVector<TimelineMarker>& removed)
+{
+    auto& blockMarkers = m_blocks[blockNumber];
+    for (auto it: qAsConst(blockMarkers.markers)) {
+        removed.append({it->first, blockNumber, it->second.wordNumber});
+        markers(it->second.wordNumber < 0).erase(it);
+    }
+    blockMarkers.markers.clear();
+}
+
+void TimingOverlay::ensureBlocks(int count)
+{
+    if (count <= m_blocks.size())
+        return;
+
+    // Appended lines keep the order of their keys, the rows stay as they are
+    int old = m_blocks.size();
+    m_blocks.resize(count);
+    for (int i = old; i < count; i++) {
+        m_blocks[i].id = m_nextId++;
+        if (!m_rowsDirty)
+            m_rows.insert(m_blocks[i].id, i);
+    }
+}
+
+int TimingOverlay::rowOf(quint64 id) const
+{
+    // Only lines inserted or removed invalidate the rows
+    if (m_rowsDirty) {
+        m_rows.clear();
+        m_rows.reserve(m_blocks.size());
+        for (int i = 0; i < m_blocks.size(); i++)
+            m_rows.insert(m_blocks[i].id, i);
+        m_rowsDirty = false;
+    }
+    return m_rows.value(id, -1);
+}
+
+void TimingOverlay::paint(QPainter& painter, const QRect& rect, qint64 viewStart, double msPerPixel, int height) const
+{
+    if (msPerPixel <= 0)
+        return;
+
+    painter.setPen(QPen(QColor(250, 200, 60, 170), 1));
+    paintMarkers(painter, m_wordMarkers, rect, viewStart, msPerPixel, height / 2, height);
+
+    painter.setPen(QPen(QColor(120, 230, 120), 2));
+    paintMarkers(painter, m_blockMarkers, rect, viewStart, msPerPixel, 0, height);
+}
+
+void TimingOverlay::paintMarkers(QPainter& painter, const Markers& markers,
+                                 const QRect& rect, qint64 viewStart, double msPerPixel, int top, int bottom)
+{
+    auto positionAt = [&](int x) {return viewStart + static_cast<qint64>(x * msPerPixel);};
+
+    auto it = markers.lower_bound(positionAt(rect.left() - 2));
+    auto endPosition = positionAt(rect.right() + 2);
+
+    while (it != markers.end() && it->first <= endPosition) {
+        int x = static_cast<int>((it->first - viewStart) / msPerPixel);
+        painter.drawLine(x, top, x, bottom);
+
+        // Skip every other marker that would land on the same pixel column
+        it = markers.lower_bound(qMax(positionAt(x + 1), it->first + 1));
+    }
+}
+
+bool TimingOverlay::markerAt(qint64 position, qint64 tolerance, bool& isBlockMarker, MarkerHandle& marker)
+{
+    // Block markers win over word markers under the cursor
+    marker = nearestMarker(m_blockMarkers, position, tolerance);
+    isBlockMarker = (marker != m_blockMarkers.end());
+    if (isBlockMarker)
+        return true;
+
+    marker = nearestMarker(m_wordMarkers, position, tolerance);
+    return marker != m_wordMarkers.end();
+}
+
+TimingOverlay::MarkerHandle TimingOverlay::nearestMarker(Markers& markers, qint64 position, qint64 tolerance)
+{
+    auto nearest = markers.end();
+    qint64 nearestDistance = tolerance + 1;
+
+    for (auto it = markers.lower_bound(position - tolerance); it != markers.end() && it->first <= position + tolerance; ++it) {
+        auto distance = qAbs(it->first - position);
+        if (distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = it;
+        }
+    }
+
+    return nearest;
+}
+
+TimelineMarker TimingOverlay::marker(MarkerHandle marker) const
+{
+    return {marker->first, rowOf(marker->second.blockId), marker->second.wordNumber};
+}
+
+void TimingOverlay::moveMarker(bool isBlockMarker, MarkerHandle& marker, qint64 position)
+{
+    auto& sorted = markers(isBlockMarker);
+
+    // Neighbours bound the move, a marker doesn't pass another one
+    auto lower = marker != sorted.begin() ? std::prev(marker)->first : 0;
+    auto next = std::next(marker);
+    auto upper = next != sorted.end() ? next->first : std::numeric_limits<qint64>::max();
+    position = qBound(lower, position, upper);
+    if (marker->first == position)
+        return;
+
+    auto row = rowOf(marker->second.blockId);
+    if (row == -1)
+        return;
+
+    // Taken out and put back at its new position, its line follows the handle
+    auto& handles = m_blocks[row].markers;
+    auto entry = marker->second;
+    auto moved = sorted.insert({position, entry});
+    std::replace(handles.begin(), handles.end(), marker, moved);
+    sorted.erase(marker);
+    marker = moved;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "editor/blockandword.h"
+
+#include <QVector>
+#include <QHash>
+#include <QPainter>
+#include <map>
+
+struct TimelineMarker
+{
+    qint64 position;
+    int blockNumber;
+    int wordNumber; // -1 for the end of the block itself
+};
+
+// Block and word end-times drawn on top of the waveform. Markers are kept in
+// two position ordered maps so painting and hit testing only visit the
+// visible range, and at most one marker per pixel column is drawn. Each line
+// also lists its own markers under a stable key, so an edit only touches the
+// markers of the lines it changed and inserting lines renumbers nothing.
+class TimingOverlay
+{
+    struct Entry
+    {
+        quint64 blockId;
+        int wordNumber;
+    };
+    using Markers = std::multimap<qint64, Entry>;
+
+public:
+    // Stays valid until the markers of its line are replaced or removed
+    using MarkerHandle = Markers::iterator;
+
+    static QVector<TimelineMarker> markersFromBlocks(const QVector<block>& blocks);
+    // Only the lines first to last, numbered as in blocks
+    static QVector<TimelineMarker> markersFromBlocks(const QVector<block>& blocks, int first, int last);
+
+    void setMarkers(const QVector<TimelineMarker>& markers);
+    void clear();
+
+    // Replacing the markers of some lines only touches theirs. The markers
+    // that went away are appended to removed.
+    void insertBlocks(int at, int count);
+    void removeBlocks(int at, int count, QVector<TimelineMarker>& removed);
+    void replaceBlocks(int first, int last, const QVector<TimelineMarker>& markers, QVector<TimelineMarker>& removed);
+
+    void paint(QPainter& painter, const QRect& rect, qint64 viewStart, double msPerPixel, int height) const;
+
+    bool markerAt(qint64 position, qint64 tolerance, bool& isBlockMarker, MarkerHandle& marker);
+    TimelineMarker marker(MarkerHandle marker) const;
+    void moveMarker(bool isBlockMarker, MarkerHandle& marker, qint64 position);
+
+private:
+    struct BlockMarkers
+    {
+        quint64 id{0};
+        QVector<MarkerHandle> markers;
+    };
+
+    Markers& markers(bool isBlockMarker) {return isBlockMarker ? m_blockMarkers : m_wordMarkers;}
+
+    void add(const TimelineMarker& marker);
+    void removeMarkers(int blockNumber, QVector<TimelineMarker>& removed);
+    void ensureBlocks(int count);
+    int rowOf(quint64 id) const;
+
+    static void paintMarkers(QPainter& painter, const Markers& markers,
+                             const QRect& rect, qint64 viewStart, double msPerPixel, int top, int bottom);
+    static MarkerHandle nearestMarker(Markers& markers, qint64 position, qint64 tolerance);
+
+    Markers m_blockMarkers, m_wordMarkers;
+    QVector<BlockMarkers> m_blocks;
+    quint64 m_nextId{0};
+    mutable QHash<quint64, int> m_rows;
+    mutable bool m_rowsDirty{true};
+};
@@ -0,0 +1,211 @@
+#include "waveformgenerator.h"
+
+#include <QAudioBuffer>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+    // Converts any of the common PCM layouts handed out by the decoder backends
+    // to interleaved 16 bit samples
+    QVector<qint16> samplesFromBuffer(const QAudioBuffer& buffer)
+    {
+        auto format = buffer.format();
+        int count = buffer.sampleCount();
+        QVector<qint16> samples(count);
+
+        if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 16) {
+            auto data = buffer.constData<qint16>();
+            std::copy(data, data + count, samples.begin());
+        }
+        else if (format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32) {
+            auto data = buffer.constData<float>();
+            for (int i = 0; i < count; i++)
+                samples[i] = static_cast<qint16>(qBound(-1.0f, data[i], 1.0f) * 32767);
+        }
+        else if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 32) {
+            auto data = buffer.constData<qint32>();
+            for (int i = 0; i < count; i++)
+                samples[i] = static_cast<qint16>(data[i] >> 16);
+        }
+        else if (format.sampleType() == QAudioFormat::UnSignedInt && format.sampleSize() == 16) {
+            auto data = buffer.constData<quint16>();
+            for (int i = 0; i < count; i++)
+                samples[i] = static_cast<qint16>(int(data[i]) - 32768);
+        }
+        else if (format.sampleType() == QAudioFormat::UnSignedInt && format.sampleSize() == 8) {
+            auto data = buffer.constData<quint8>();
+            for (int i = 0; i < count; i++)
+                samples[i] = static_cast<qint16>((int(data[i]) - 128) << 8);
+        }
+        else
+            return {};
+
+        return samples;
+    }
+}
+
+void PeakDecoder::start(const QString& mediaFileName, quint64 requestId)
+{
+    if (m_audioDecoder && m_audioDecoder->state() == QAudioDecoder::DecodingState)
+        m_audioDecoder->stop();
+
+    m_mediaFileName = mediaFileName;
+    m_requestId = requestId;
+    m_sampleRate = 0;
+    m_lastProgress = -1;
+    m_peaks.clear();
+    m_currentPeak = WaveformPeak();
+    m_samplesInPeak = 0;
+
+    m_mediaHash = PeakPyramid::mediaHash(mediaFileName);
+    if (m_mediaHash.isEmpty()) {
+        emit failed(requestId, "Couldn't read media for waveform");
+        return;
+    }
+
+    for (auto& cacheFileName: PeakPyramid::cacheFileNames(mediaFileName, m_mediaHash)) {
+        auto pyramid = PeakPyramid::load(cacheFileName, m_mediaHash);
+        if (pyramid) {
+            qInfo() << "[Waveform Cache Hit]" << cacheFileName;
+            emit finished(requestId, pyramid);
+            return;
+        }
+    }
+
+    if (!m_audioDecoder) {
+        m_audioDecoder = new QAudioDecoder(this);
+        connect(m_audioDecoder, &QAudioDecoder::bufferReady, this, &PeakDecoder::readBuffer);
+        connect(m_audioDecoder, &QAudioDecoder::finished, this, &PeakDecoder::decodingFinished);
+        connect(m_audioDecoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+                this, &PeakDecoder::decodingError);
+    }
+
+    m_audioDecoder->setSourceFilename(mediaFileName);
+    m_audioDecoder->start();
+}
+
+void PeakDecoder::readBuffer()
+{
+    auto buffer = m_audioDecoder->read();
+    if (!buffer.isValid())
+        return;
+
+    if (!m_sampleRate)
+        m_sampleRate = buffer.format().sampleRate();
+
+    auto samples = samplesFromBuffer(buffer);
+    int channels = qMax(1, buffer.format().channelCount());
+
+    // Channels are folded together, the overview only shows the envelope
+    for (int frame = 0; frame + channels <= samples.size(); frame += channels) {
+        qint16 min = samples[frame], max = samples[frame];
+        for (int channel = 1; channel < channels; channel++) {
+            min = qMin(min, samples[frame + channel]);
+            max = qMax(max, samples[frame + channel]);
+        }
+        addFrame(min, max);
+    }
+
+    auto duration = m_audioDecoder->duration();
+    if (duration > 0) {
+        int percent = static_cast<int>(100 * m_audioDecoder->position() / duration);
+        if (percent != m_lastProgress) {
+            m_lastProgress = percent;
+            emit progress(m_requestId, percent);
+        }
+    }
+}
+
+void PeakDecoder::addFrame(qint16 min, qint16 max)
+{
+    if (!m_samplesInPeak)
+        m_currentPeak = {min, max};
+    else {
+        m_currentPeak.min = qMin(m_currentPeak.min, min);
+        m_currentPeak.max = qMax(m_currentPeak.max, max);
+    }
+
+    if (++m_samplesInPeak == PeakPyramid::baseSamplesPerPeak)
+        flushPeak();
+}
+
+void PeakDecoder::flushPeak()
+{
+    if (!m_samplesInPeak)
+        return;
+
+    m_peaks.append(m_currentPeak);
+    m_samplesInPeak = 0;
+}
+
+void PeakDecoder::decodingFinished()
+{
+    flushPeak();
+
+    if (m_peaks.isEmpty() || !m_sampleRate) {
+        emit failed(m_requestId, "No audio found for waveform");
+        return;
+    }
+
+    auto pyramid = QSharedPointer<PeakPyramid>::create(m_sampleRate, m_peaks);
+    m_peaks.clear();
+
+    for (auto& cacheFileName: PeakPyramid::cacheFileNames(m_mediaFileName, m_mediaHash)) {
+        if (pyramid->save(cacheFileName, m_mediaHash)) {
+            qInfo() << "[Waveform Cached]" << cacheFileName;
+            break;
+        }
+    }
+
+    emit finished(m_requestId, pyramid);
+}
+
+void PeakDecoder::decodingError()
+{
+    emit failed(m_requestId, m_audioDecoder->errorString());
+}
+
+
+
+WaveformGenerator::WaveformGenerator(QObject *parent)
+    : QObject(parent),
+    m_decoder(new PeakDecoder)
+{
+    qRegisterMetaType<QSharedPointer<const PeakPyramid>>();
+
+    m_decoder->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_decoder, &QObject::deleteLater);
+    connect(this, &WaveformGenerator::startDecoding, m_decoder, &PeakDecoder::start);
+
+    connect(m_decoder, &PeakDecoder::progress, this,
+            [this](quint64 requestId, int percent)
+            {
+                if (requestId == m_requestId)
+                    emit progress(percent);
+            });
+    connect(m_decoder, &PeakDecoder::finished, this,
+            [this](quint64 requestId, QSharedPointer<const PeakPyramid> pyramid)
+            {
+                if (requestId == m_requestId)
+                    emit pyramidReady(pyramid);
+            });
+    connect(m_decoder, &PeakDecoder::failed, this,
+            [this](quint64 requestId, const QString& errorString)
+            {
+                if (requestId == m_requestId)
+                    emit message("Waveform: " + errorString);
+            });
+
+    m_thread.start(QThread::LowPriority);
+}
+
+WaveformGenerator::~WaveformGenerator()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void WaveformGenerator::generate(const QString& mediaFileName)
+{
+    emit startDecoding(mediaFileName, ++m_requestId);
+}
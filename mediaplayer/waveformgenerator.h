@@ -0,0 +1,65 @@
+#pragma once
+
+#include "peakpyramid.h"
+
+#include <QObject>
+#include <QThread>
+#include <QAudioDecoder>
+
+class PeakDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PeakDecoder(QObject *parent = nullptr) : QObject(parent) {}
+
+public slots:
+    void start(const QString& mediaFileName, quint64 requestId);
+
+signals:
+    void progress(quint64 requestId, int percent);
+    void finished(quint64 requestId, QSharedPointer<const PeakPyramid> pyramid);
+    void failed(quint64 requestId, const QString& errorString);
+
+private slots:
+    void readBuffer();
+    void decodingFinished();
+    void decodingError();
+
+private:
+    void addFrame(qint16 min, qint16 max);
+    void flushPeak();
+
+    QAudioDecoder* m_audioDecoder = nullptr;
+    QString m_mediaFileName;
+    QByteArray m_mediaHash;
+    quint64 m_requestId{0};
+    int m_sampleRate{0}, m_lastProgress{-1};
+    QVector<WaveformPeak> m_peaks;
+    WaveformPeak m_currentPeak;
+    qint64 m_samplesInPeak{0};
+};
+
+// Owns the decoding thread. Requests are serialised, a newer request
+// supersedes the one in flight so only the latest media ends up displayed.
+class WaveformGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformGenerator(QObject *parent = nullptr);
+    ~WaveformGenerator() override;
+
+    void generate(const QString& mediaFileName);
+
+signals:
+    void startDecoding(const QString& mediaFileName, quint64 requestId);
+    void pyramidReady(QSharedPointer<const PeakPyramid> pyramid);
+    void progress(int percent);
+    void message(const QString& text, int timeout = 5000);
+
+private:
+    QThread m_thread;
+    PeakDecoder* m_decoder = nullptr;
+    quint64 m_requestId{0};
+};
@@ -0,0 +1,317 @@
+#include "waveformwidget.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QtMath>
+#include <algorithm>
+#include <tuple>
+
+WaveformWidget::WaveformWidget(QWidget *parent)
+    : QWidget(parent),
+    m_generator(new WaveformGenerator(this))
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMouseTracking(true);
+
+    connect(m_generator, &WaveformGenerator::pyramidReady, this, &WaveformWidget::setPyramid);
+    connect(m_generator, &WaveformGenerator::message, this, &WaveformWidget::message);
+    connect(m_generator, &WaveformGenerator::progress, this,
+            [this](int percent)
+            {
+                m_progress = percent;
+                update();
+            });
+}
+
+QSize WaveformWidget::sizeHint() const
+{
+    return QSize(400, 80);
+}
+
+void WaveformWidget::loadMedia(const QString& mediaFileName)
+{
+    m_pyramid.clear();
+    m_progress = 0;
+    m_msPerPixel = 0;
+    m_viewStart = 0;
+    update();
+
+    if (!mediaFileName.isEmpty())
+        m_generator->generate(mediaFileName);
+}
+
+void WaveformWidget::setPyramid(QSharedPointer<const PeakPyramid> pyramid)
+{
+    m_pyramid = pyramid;
+    m_progress = -1;
+    update();
+}
+
+void WaveformWidget::setDuration(qint64 duration)
+{
+    m_duration = duration;
+    setViewStart(m_viewStart);
+    update();
+}
+
+void WaveformWidget::setPosition(qint64 position)
+{
+    auto oldX = positionToX(m_position);
+    m_position = position;
+
+    // Page the view along with playback when zoomed in
+    if (m_msPerPixel > 0 && (position < m_viewStart || position >= m_viewStart + viewDuration())) {
+        setViewStart(position - viewDuration() / 10);
+        update();
+        return;
+    }
+
+    auto newX = positionToX(m_position);
+    if (newX != oldX) {
+        updateAroundX(oldX);
+        updateAroundX(newX);
+    }
+}
+
+void WaveformWidget::zoom(double factor, int anchorX)
+{
+    auto fitMsPerPixel = double(qMax<qint64>(1, totalDuration())) / qMax(1, width());
+    auto anchorPosition = xToPosition(anchorX);
+    auto currentMsPerPixel = m_msPerPixel > 0 ? m_msPerPixel : fitMsPerPixel;
+    auto newMsPerPixel = qBound(1.0, currentMsPerPixel / factor, fitMsPerPixel);
+
+    m_msPerPixel = (newMsPerPixel >= fitMsPerPixel) ? 0 : newMsPerPixel;
+    setViewStart(anchorPosition - static_cast<qint64>(anchorX * newMsPerPixel));
+    update();
+}
+
+void WaveformWidget::setMarkers(const QVector<TimelineMarker>& markers)
+{
+    // The dragged marker is held by its handle, the markers can't change under it
+    if (m_draggingMarker) {
+        m_markersStale = true;
+        return;
+    }
+
+    m_overlay.setMarkers(markers);
+    update();
+}
+
+void WaveformWidget::insertMarkerBlocks(int at, int count)
+{
+    if (m_draggingMarker) {
+        m_markersStale = true;
+        return;
+    }
+
+    // Nothing moves on screen
+    m_overlay.insertBlocks(at, count);
+}
+
+void WaveformWidget::removeMarkerBlocks(int at, int count)
+{
+    if (m_draggingMarker) {
+        m_markersStale = true;
+        return;
+    }
+
+    QVector<TimelineMarker> removed;
+    m_overlay.removeBlocks(at, count, removed);
+    updateMarkers(removed, {});
+}
+
+void WaveformWidget::replaceMarkers(int first, int last, const QVector<TimelineMarker>& markers)
+{
+    if (m_draggingMarker) {
+        m_markersStale = true;
+        return;
+    }
+
+    QVector<TimelineMarker> removed;
+    m_overlay.replaceBlocks(first, last, markers, removed);
+    updateMarkers(removed, markers);
+}
+
+void WaveformWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    auto rect = event->rect();
+    painter.fillRect(rect, QColor(30, 30, 30));
+
+    int middle = height() / 2;
+
+    if (m_pyramid && !m_pyramid->isEmpty()) {
+        painter.setPen(QColor(90, 170, 250));
+
+        // Only the exposed columns are drawn, each column reads about one peak
+        for (int x = rect.left(); x <= rect.right(); x++) {
+            auto peak = m_pyramid->peakInRange(xToPosition(x), xToPosition(x + 1));
+            int top = middle - peak.max * middle / 32768;
+            int bottom = middle - peak.min * middle / 32768;
+            painter.drawLine(x, top, x, bottom);
+        }
+    }
+    else if (m_progress >= 0) {
+        painter.setPen(Qt::lightGray);
+        painter.drawText(this->rect(), Qt::AlignCenter, QString("Generating waveform %1%").arg(m_progress));
+    }
+
+    m_overlay.paint(painter, rect, m_viewStart, msPerPixel(), height());
+
+    painter.setPen(Qt::red);
+    auto playheadX = positionToX(m_position);
+    if (playheadX >= rect.left() - 1 && playheadX <= rect.right() + 1)
+        painter.drawLine(playheadX, 0, playheadX, height());
+}
+
+void WaveformWidget::wheelEvent(QWheelEvent *event)
+{
+    auto steps = event->angleDelta().y() / 120.0;
+    if (steps == 0.0)
+        return;
+
+    if (event->modifiers() == Qt::ControlModifier)
+        zoom(qPow(1.25, steps), event->position().toPoint().x());
+    else if (m_msPerPixel > 0) {
+        setViewStart(m_viewStart - static_cast<qint64>(steps * viewDuration() / 10));
+        update();
+    }
+    event->accept();
+}
+
+void WaveformWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
+    auto position = xToPosition(event->pos().x());
+    auto tolerance = static_cast<qint64>(3 * msPerPixel());
+
+    if (m_overlay.markerAt(position, tolerance, m_dragBlockMarker, m_dragMarker))
+        m_draggingMarker = true;
+    else
+        emit seekRequested(qBound<qint64>(0, position, totalDuration()));
+}
+
+void WaveformWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    auto position = xToPosition(event->pos().x());
+
+    if (!m_draggingMarker) {
+        bool isBlockMarker;
+        TimingOverlay::MarkerHandle marker;
+        auto overMarker = m_overlay.markerAt(position, static_cast<qint64>(3 * msPerPixel()), isBlockMarker, marker);
+        setCursor(overMarker ? Qt::SizeHorCursor : Qt::ArrowCursor);
+        return;
+    }
+
+    // Only the columns around the old and the new marker position are repainted
+    auto oldX = positionToX(m_overlay.marker(m_dragMarker).position);
+    m_overlay.moveMarker(m_dragBlockMarker, m_dragMarker, qBound<qint64>(0, position, totalDuration()));
+    auto newX = positionToX(m_overlay.marker(m_dragMarker).position);
+
+    if (newX != oldX) {
+        updateAroundX(oldX);
+        updateAroundX(newX);
+    }
+}
+
+void WaveformWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (!m_draggingMarker || event->button() != Qt::LeftButton) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+
+    m_draggingMarker = false;
+    auto marker = m_overlay.marker(m_dragMarker);
+    if (m_markersStale) {
+        m_markersStale = false;
+        emit markersRequested();
+    }
+    emit markerMoved(marker.blockNumber, marker.wordNumber, marker.position);
+}
+
+void WaveformWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    setViewStart(m_viewStart);
+}
+
+qint64 WaveformWidget::xToPosition(int x) const
+{
+    return m_viewStart + static_cast<qint64>(x * msPerPixel());
+}
+
+int WaveformWidget::positionToX(qint64 position) const
+{
+    auto duration = viewDuration();
+    if (duration <= 0)
+        return 0;
+    return static_cast<int>((position - m_viewStart) * double(width()) / duration);
+}
+
+qint64 WaveformWidget::totalDuration() const
+{
+    if (m_duration > 0)
+        return m_duration;
+    return m_pyramid ? m_pyramid->duration() : 0;
+}
+
+qint64 WaveformWidget::viewDuration() const
+{
+    if (m_msPerPixel > 0)
+        return static_cast<qint64>(m_msPerPixel * width());
+    return totalDuration();
+}
+
+double WaveformWidget::msPerPixel() const
+{
+    return double(viewDuration()) / qMax(1, width());
+}
+
+void WaveformWidget::setViewStart(qint64 viewStart)
+{
+    if (m_msPerPixel <= 0) {
+        m_viewStart = 0;
+        return;
+    }
+
+    m_viewStart = qBound<qint64>(0, viewStart, qMax<qint64>(0, totalDuration() - viewDuration()));
+}
+
+void WaveformWidget::updateAroundX(int x)
+{
+    update(x - 2, 0, 5, height());
+}
+
+void WaveformWidget::updateMarkers(QVector<TimelineMarker> removed, QVector<TimelineMarker> added)
+{
+    auto less = [](const TimelineMarker& a, const TimelineMarker& b) {
+        return std::tie(a.position, a.blockNumber, a.wordNumber) < std::tie(b.position, b.blockNumber, b.wordNumber);
+    };
+    std::sort(removed.begin(), removed.end(), less);
+    std::sort(added.begin(), added.end(), less);
+
+    // Typing within a line gives back the markers it had, nothing to repaint
+    auto same = [&less](const TimelineMarker& a, const TimelineMarker& b) {return !less(a, b) && !less(b, a);};
+    if (std::equal(removed.begin(), removed.end(), added.begin(), added.end(), same))
+        return;
+
+    if (removed.size() + added.size() > width() / 5) {
+        update();
+        return;
+    }
+    for (auto markers: {&removed, &added}) {
+        for (auto& a_marker: qAsConst(*markers)) {
+            auto x = positionToX(a_marker.position);
+            if (x >= -2 && x <= width() + 2)
+                updateAroundX(x);
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "waveformgenerator.h"
+#include "timingoverlay.h"
+
+#include <QWidget>
+
+class WaveformWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformWidget(QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+    QSharedPointer<const PeakPyramid> pyramid() const {return m_pyramid;}
+
+public slots:
+    void loadMedia(const QString& mediaFileName);
+    void setPyramid(QSharedPointer<const PeakPyramid> pyramid);
+    void setDuration(qint64 duration);
+    void setPosition(qint64 position);
+    void zoom(double factor, int anchorX);
+    void setMarkers(const QVector<TimelineMarker>& markers);
+    // Markers of the lines an edit touched, only their columns are repainted
+    void insertMarkerBlocks(int at, int count);
+    void removeMarkerBlocks(int at, int count);
+    void replaceMarkers(int first, int last, const QVector<TimelineMarker>& markers);
+
+signals:
+    void seekRequested(qint64 position);
+    void markerMoved(int blockNumber, int wordNumber, qint64 position);
+    // Markers changed while one was dragged, they are asked for once it is dropped
+    void markersRequested();
+    void message(const QString& text, int timeout = 5000);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    qint64 xToPosition(int x) const;
+    int positionToX(qint64 position) const;
+    qint64 totalDuration() const;
+    qint64 viewDuration() const;
+    double msPerPixel() const;
+    void setViewStart(qint64 viewStart);
+    void updateAroundX(int x);
+    void updateMarkers(QVector<TimelineMarker> removed, QVector<TimelineMarker> added);
+
+    WaveformGenerator* m_generator = nullptr;
+    QSharedPointer<const PeakPyramid> m_pyramid;
+    qint64 m_duration{0}, m_position{0}, m_viewStart{0};
+    double m_msPerPixel{0};
+    int m_progress{-1};
+
+    TimingOverlay m_overlay;
+    bool m_draggingMarker{false}, m_dragBlockMarker{false}, m_markersStale{false};
+    TimingOverlay::MarkerHandle m_dragMarker;
+};
@@ -0,0 +1,74 @@
+#include "session.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+namespace {
+    const QString sessionFileName("session.json");
+}
+
+Session Session::load()
+{
+    Session session;
+
+    QFile sessionFile(sessionFileName);
+    if (!sessionFile.open(QFile::ReadOnly))
+        return session;
+
+    auto saved = QJsonDocument::fromJson(sessionFile.readAll()).object();
+    auto readTab = [](const QJsonObject& savedTab) {
+        Tab tab;
+        tab.transcriptUrl = QUrl(savedTab.value("transcript").toString());
+        tab.mediaUrl = QUrl(savedTab.value("media").toString());
+        tab.cursorPosition = savedTab.value("cursor").toInt();
+        tab.mediaPosition = qint64(savedTab.value("mediaPosition").toDouble());
+        return tab;
+    };
+
+    // Sessions saved before tabs were kept hold a single one at the top level
+    if (saved.contains("tabs")) {
+        for (auto savedTab: saved.value("tabs").toArray())
+            session.tabs.append(readTab(savedTab.toObject()));
+        session.currentTab = saved.value("currentTab").toInt();
+    }
+    else if (saved.contains("transcript") || saved.contains("media"))
+        session.tabs.append(readTab(saved));
+
+    session.fontFamily = saved.value("fontFamily").toString();
+    session.fontSize = saved.value("fontSize").toInt();
+    session.transliteration = saved.value("transliteration").toString();
+    return session;
+}
+
+bool Session::save() const
+{
+    QJsonArray savedTabs;
+    for (auto& tab: tabs) {
+        savedTabs.append(QJsonObject{
+            {"transcript", tab.transcriptUrl.toString()},
+            {"media", tab.mediaUrl.toString()},
+            {"cursor", tab.cursorPosition},
+            {"mediaPosition", double(tab.mediaPosition)}
+        });
+    }
+
+    QJsonObject saved{
+        {"tabs", savedTabs},
+        {"currentTab", currentTab},
+        {"fontFamily", fontFamily},
+        {"fontSize", fontSize},
+        {"transliteration", transliteration}
+    };
+
+    QSaveFile sessionFile(sessionFileName);
+    if (!sessionFile.open(QFile::WriteOnly)) {
+        qWarning() << "[Session]" << QString("couldn't save %1").arg(sessionFileName);
+        return false;
+    }
+    sessionFile.write(QJsonDocument(saved).toJson());
+    return sessionFile.commit();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QUrl>
+#include <QVector>
+
+// What was open when the tool last closed, restored on the next start. Kept
+// in session.json in the working directory like the other state files.
+struct Session
+{
+    // A transcript tab and the media it plays
+    struct Tab
+    {
+        QUrl transcriptUrl, mediaUrl;
+        int cursorPosition{0};
+        qint64 mediaPosition{0};
+    };
+
+    QVector<Tab> tabs;
+    int currentTab{0};
+    QString fontFamily;
+    int fontSize{0};
+    QString transliteration;    // Language of the transliteration menu, empty for none
+
+    static Session load();
+    bool save() const;
+};
@@ -0,0 +1,186 @@
+#include "editor/transcriptreader.h"
+#include "editor/transcriptwriter.h"
+
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QtTest>
+
+// The chunked reader against the sequential one and TranscriptWriter against
+// the QXmlStreamWriter it imitates, on fixed transcripts, for every thread
+// count up to 16 so that the cuts land all over the file.
+
+namespace {
+    const QStringList vocabulary{
+        "the", "meeting", "will", "start", "at", "nine",
+        QString::fromUtf8("नमस्ते"), QString::fromUtf8("भारत"),
+        "R&D", "<unk>", "\"quoted\"", "a > b", "it's", "tab\there"
+    };
+
+    QVector<block> makeBlocks(int lineCount)
+    {
+        QTime time(0, 0);
+        QVector<block> blocks;
+        blocks.reserve(lineCount);
+
+        for (int i = 0; i < lineCount; i++) {
+            auto wordCount = 1 + i % 7;
+            auto lineStart = time;
+            time = time.addMSecs(300 * wordCount);
+
+            block line = {time, "", QString("Speaker_%1").arg(i % 3), QStringList(), QVector<word>()};
+            if (i % 5 == 0)
+                line.tagList = QStringList{"music", "R&D"};
+            if (i % 2)
+                line.confidence = (i % 1000) / 1000.0;
+
+            QStringList text;
+            for (int j = 0; j < wordCount; j++) {
+                word a_word = {lineStart.addMSecs(300 * (j + 1)), vocabulary[(i + j) % vocabulary.size()], QStringList()};
+                if ((i + j) % 11 == 0)
+                    a_word.tagList = QStringList{"foreign"};
+                if ((i + j) % 3)
+                    a_word.confidence = ((i + j) % 100) / 100.0;
+                text << a_word.text;
+                line.words.append(a_word);
+            }
+            line.text = text.join(" ");
+            blocks.append(line);
+        }
+        return blocks;
+    }
+
+    QByteArray reference(const QVector<block>& blocks)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        TranscriptWriter::writeReference(&buffer, "english", blocks);
+        return buffer.data();
+    }
+
+    // operator== leaves out tags and confidences
+    bool identical(const TranscriptData& a, const TranscriptData& b)
+    {
+        if (a.lang != b.lang || a.blocks.size() != b.blocks.size())
+            return false;
+
+        for (int i = 0; i < a.blocks.size(); i++) {
+            auto& x = a.blocks[i];
+            auto& y = b.blocks[i];
+            if (!(x == y) || x.tagList != y.tagList || x.confidence != y.confidence)
+                return false;
+            for (int j = 0; j < x.words.size(); j++)
+                if (x.words[j].tagList != y.words[j].tagList || x.words[j].confidence != y.words[j].confidence)
+                    return false;
+        }
+        return true;
+    }
+}
+
+Q_DECLARE_METATYPE(block)
+
+class TranscriptIoTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readParallel_data();
+    void readParallel();
+    void toXml_data();
+    void toXml();
+};
+
+void TranscriptIoTest::readParallel_data()
+{
+    QTest::addColumn<QByteArray>("xml");
+    QTest::addColumn<bool>("splittable");
+
+    QTest::newRow("empty file") << QByteArray() << false;
+    QTest::newRow("no lines") << QByteArray("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                            "<transcript lang=\"english\">\n</transcript>\n") << true;
+
+    // Attributes long enough to hold the middle of the file, so the even
+    // cuts land inside the start tags of the second line
+    auto padding = QByteArray(2000, 'x');
+    QTest::newRow("cut inside a tag") << QByteArray(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<transcript lang=\"english\">\n"
+        "    <line timestamp=\"0:0:1.000\" speaker=\"A\">\n"
+        "        <word timestamp=\"0:0:1.000\">one</word>\n"
+        "    </line>\n"
+        "    <line timestamp=\"0:0:2.000\" speaker=\"B\" tags=\"" + padding + "\">\n"
+        "        <word timestamp=\"0:0:2.000\" tags=\"" + padding + "\">two</word>\n"
+        "    </line>\n"
+        "    <line timestamp=\"0:0:3.000\" speaker=\"C\">\n"
+        "        <word timestamp=\"0:0:3.000\">three</word>\n"
+        "    </line>\n"
+        "</transcript>\n") << true;
+
+    QTest::newRow("escaped entities") << QByteArray(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<transcript lang=\"english\">\n"
+        "    <line timestamp=\"0:0:1.000\" speaker=\"&quot;A&quot; &amp; B\" tags=\"R&amp;D\">\n"
+        "        <word timestamp=\"0:0:1.000\">&lt;line&gt;</word>\n"
+        "        <word timestamp=\"0:0:1.500\">&amp;amp;</word>\n"
+        "        <word timestamp=\"0:0:2.000\">&#x928;&#2350;</word>\n"
+        "    </line>\n"
+        "    <line timestamp=\"0:0:3.000\" speaker=\"&apos;C&apos;\">\n"
+        "        <word timestamp=\"0:0:3.000\">a&#9;&gt;&#10;b</word>\n"
+        "    </line>\n"
+        "</transcript>\n") << true;
+
+    QTest::newRow("generated") << reference(makeBlocks(300)) << true;
+}
+
+void TranscriptIoTest::readParallel()
+{
+    QFETCH(QByteArray, xml);
+    QFETCH(bool, splittable);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(xml), qint64(xml.size()));
+    QVERIFY(file.flush());
+
+    file.seek(0);
+    auto expected = TranscriptReader::readSequential(&file);
+
+    for (int threads = 1; threads <= 16; threads++) {
+        TranscriptData transcript;
+        auto ok = TranscriptReader::readParallel(file, threads, transcript);
+        QCOMPARE(ok, splittable);
+        if (ok)
+            QVERIFY2(identical(transcript, expected), qPrintable(QString("%1 threads").arg(threads)));
+    }
+}
+
+void TranscriptIoTest::toXml_data()
+{
+    QTest::addColumn<QVector<block>>("blocks");
+
+    QTest::newRow("no lines") << QVector<block>();
+
+    QVector<block> escaped{
+        {QTime(0, 0, 1), "", "\"A\" & B", QStringList{"R&D", "a<b"}, QVector<word>()},
+        {QTime(0, 0, 2), "", "tab\tnew\nline\r", QStringList(), QVector<word>()}
+    };
+    escaped[0].words = {{QTime(0, 0, 1), "<line>", QStringList{"x>y"}}, {QTime(), "&amp;", QStringList()}};
+    escaped[1].words = {{QTime(0, 0, 2), "a\t>\nb", QStringList()}, {QTime(0, 0, 2), QString(QChar(0x1)), QStringList()}};
+    QTest::newRow("escaped entities") << escaped;
+
+    QTest::newRow("formatted on the calling thread") << makeBlocks(TranscriptWriter::parallelThreshold - 1);
+    QTest::newRow("formatted on the thread pool") << makeBlocks(TranscriptWriter::parallelThreshold * 2 + 7);
+}
+
+void TranscriptIoTest::toXml()
+{
+    QFETCH(QVector<block>, blocks);
+
+    auto expected = reference(blocks);
+    for (int threads = 1; threads <= 16; threads++)
+        QVERIFY2(TranscriptWriter::toXml("english", blocks, threads) == expected,
+                 qPrintable(QString("%1 threads").arg(threads)));
+}
+
+QTEST_GUILESS_MAIN(TranscriptIoTest)
+
+#include "transcriptiotest.moc"
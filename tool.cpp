@@ -3,11 +3,20 @@
 #include "editor/utilities/keyboardshortcutguide.h"
 
 #include <QFontDialog>
+#include <QInputDialog>
+#include <QFileInfo>
+#include <QTimer>
 
 Tool::Tool(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::Tool)
 {
+    // Only what the first paint needs is set up here, the rest waits for
+    // initialiseDeferred() once the window is on screen
+    if (!m_startupTimer.isValid())
+        m_startupTimer.start();
+    m_session = Session::load();
+
     ui->setupUi(this);
 
     player = new MediaPlayer(this);
@@ -50,26 +59,96 @@ Tool::Tool(QWidget *parent)
     connect(player, QOverload<QMediaPlayer::Error>::of(&QMediaPlayer::error), this, &Tool::handleMediaPlayerError);
 
     // Connect components dependent on Player's position change to player
-    connect(player, &QMediaPlayer::positionChanged, this,
+    playbackSync = new PlaybackSync(player, this);
+    playbackSync->bind(ui->slider_position, ui->label_position);
+
+    connect(playbackSync, &PlaybackSync::positionUpdated, this,
+        [&](qint64 position)
+        {
+            ui->m_editor->highlightTranscript(QTime(0, 0).addMSecs(int(position)));
+        }
+    );
+    connect(ui->player_syncStatistics, &QAction::triggered, this,
         [&]()
         {
-            ui->slider_position->setValue(player->position());
-            ui->label_position->setText(player->getPositionInfo());
-            ui->m_editor->highlightTranscript(player->elapsedTime());
+            statusBar()->showMessage(playbackSync->statistics() + " | " + player->seekStatistics());
+            qInfo() << "[Playback Sync]" << playbackSync->statistics();
+            qInfo() << "[Seek Scheduler]" << player->seekStatistics();
+        }
+    );
+
+    // Connect waveform overview to player
+    connect(player, &QMediaPlayer::currentMediaChanged, ui->m_waveform,
+        [&](const QMediaContent& media)
+        {
+            ui->m_waveform->loadMedia(media.request().url().toLocalFile());
+        }
+    );
+    connect(playbackSync, &PlaybackSync::positionUpdated, ui->m_waveform, &WaveformWidget::setPosition);
+    connect(player, &QMediaPlayer::durationChanged, ui->m_waveform, &WaveformWidget::setDuration);
+    connect(ui->m_waveform, &WaveformWidget::seekRequested, player, &MediaPlayer::seekTo);
+    connect(ui->m_waveform, &WaveformWidget::message, this->statusBar(), &QStatusBar::showMessage);
+
+    // Connect timing overlay on the waveform to the transcript, an edit only
+    // replaces the markers of the lines it touched
+    auto resetMarkers = [&]()
+    {
+        ui->m_waveform->setMarkers(TimingOverlay::markersFromBlocks(ui->m_editor->blocks()));
+    };
+    connect(ui->m_editor, &Editor::blocksReset, ui->m_waveform, resetMarkers);
+    connect(ui->m_waveform, &WaveformWidget::markersRequested, ui->m_waveform, resetMarkers);
+    connect(ui->m_editor, &Editor::blocksInserted, ui->m_waveform, &WaveformWidget::insertMarkerBlocks);
+    connect(ui->m_editor, &Editor::blocksRemoved, ui->m_waveform, &WaveformWidget::removeMarkerBlocks);
+    connect(ui->m_editor, &Editor::blocksUpdated, ui->m_waveform,
+        [&](int first, int last)
+        {
+            ui->m_waveform->replaceMarkers(first, last, TimingOverlay::markersFromBlocks(ui->m_editor->blocks(), first, last));
+        }
+    );
+    connect(ui->m_waveform, &WaveformWidget::markerMoved, ui->m_editor,
+        [&](int blockNumber, int wordNumber, qint64 position)
+        {
+            ui->m_editor->retime(blockNumber, wordNumber, QTime(0, 0).addMSecs(position));
         }
     );
 
-    connect(player, &QMediaPlayer::durationChanged, this,
+    // Connect segment loop to player and the line under the cursor
+    segmentLooper = new SegmentLooper(player);
+
+    connect(segmentLooper, &SegmentLooper::message, this->statusBar(), &QStatusBar::showMessage);
+    connect(player, &QMediaPlayer::playbackRateChanged, ui->m_playerControls,
+        [&](qreal rate)
+        {
+            ui->m_playerControls->setPlaybackRate(rate);
+        }
+    );
+    connect(ui->player_loopLine, &QAction::toggled, this,
+        [&](bool checked)
+        {
+            if (checked)
+                loopBlock(ui->m_editor->textCursor().blockNumber());
+            segmentLooper->setEnabled(checked);
+        }
+    );
+    connect(ui->m_editor, &Editor::currentBlockChanged, this, &Tool::loopBlock);
+    connect(ui->m_editor, &Editor::blocksChanged, this,
         [&]()
         {
-            ui->slider_position->setRange(0, player->duration());
-            ui->label_position->setText(player->getPositionInfo());
+            if (segmentLooper->isEnabled())
+                loopBlock(ui->m_editor->textCursor().blockNumber());
         }
     );
 
     // Connect edit menu actions
-    connect(ui->edit_undo, &QAction::triggered, ui->m_editor, &Editor::undo);
-    connect(ui->edit_redo, &QAction::triggered, ui->m_editor, &Editor::redo);
+    connect(ui->edit_undo, &QAction::triggered, ui->m_editor, &Editor::undoChange);
+    connect(ui->edit_redo, &QAction::triggered, ui->m_editor, &Editor::redoChange);
+    connect(ui->edit_undoLimit, &QAction::triggered, this, [this]() {
+        bool ok{false};
+        auto megabytes = QInputDialog::getInt(this, "Undo Memory Limit", "Megabytes of undo history per transcript:",
+                                              int(ui->m_editor->history().memoryLimit() / (1024 * 1024)), 1, 4096, 1, &ok);
+        if (ok)
+            ui->m_editor->setUndoMemoryLimit(qint64(megabytes) * 1024 * 1024);
+    });
     connect(ui->edit_cut, &QAction::triggered, ui->m_editor, &Editor::cut);
     connect(ui->edit_copy, &QAction::triggered, ui->m_editor, &Editor::copy);
     connect(ui->edit_paste, &QAction::triggered, ui->m_editor, &Editor::paste);
@@ -89,6 +168,26 @@ Tool::Tool(QWidget *parent)
     connect(ui->editor_save, &QAction::triggered, ui->m_editor, &Editor::transcriptSave);
     connect(ui->editor_saveAs, &QAction::triggered, ui->m_editor, &Editor::transcriptSaveAs);
     connect(ui->editor_close, &QAction::triggered, ui->m_editor, &Editor::transcriptClose);
+    connect(ui->editor_export, &QAction::triggered, ui->m_editor, &Editor::exportTranscript);
+    connect(ui->editor_exportTranscripts, &QAction::triggered, ui->m_editor, &Editor::exportTranscripts);
+    connect(ui->editor_subtitleOptions, &QAction::triggered, this, [this]() {
+        auto options = ui->m_editor->subtitleOptions();
+        bool ok{false};
+        options.maxLineLength = QInputDialog::getInt(this, "Subtitle Segmentation", "Maximum characters per line:",
+                                                     options.maxLineLength, 10, 200, 1, &ok);
+        if (!ok)
+            return;
+        options.maxLines = QInputDialog::getInt(this, "Subtitle Segmentation", "Maximum lines per subtitle:",
+                                                options.maxLines, 1, 5, 1, &ok);
+        if (!ok)
+            return;
+        auto seconds = QInputDialog::getDouble(this, "Subtitle Segmentation", "Maximum seconds per subtitle:",
+                                               options.maxDuration / 1000.0, 0.5, 60, 1, &ok);
+        if (!ok)
+            return;
+        options.maxDuration = qRound64(seconds * 1000);
+        ui->m_editor->setSubtitleOptions(options);
+    });
     connect(ui->editor_jumpToLine, &QAction::triggered, ui->m_editor, &Editor::jumpToHighlightedLine);
     connect(ui->editor_splitLine, &QAction::triggered, ui->m_editor, [&]() {ui->m_editor->splitLine(player->elapsedTime());});
     connect(ui->editor_mergeUp, &QAction::triggered, ui->m_editor, &Editor::mergeUp);
@@ -98,46 +197,50 @@ Tool::Tool(QWidget *parent)
     connect(ui->editor_changeSpeaker, &QAction::triggered, ui->m_editor, &Editor::createChangeSpeakerDialog);
     connect(ui->editor_propagateTime, &QAction::triggered, ui->m_editor, &Editor::createTimePropagationDialog);
     connect(ui->editor_editTags, &QAction::triggered, ui->m_editor, &Editor::createTagSelectionDialog);
+    connect(ui->editor_oovStatistics, &QAction::triggered, ui->m_editor, &Editor::createOovStatisticsDialog);
+    connect(ui->editor_scoreHypothesis, &QAction::triggered, ui->m_editor, &Editor::scoreAgainstHypothesis);
+    connect(ui->editor_nextLowConfidence, &QAction::triggered, ui->m_editor, &Editor::nextLowConfidenceWord);
+    connect(ui->editor_previousLowConfidence, &QAction::triggered, ui->m_editor, &Editor::previousLowConfidenceWord);
+    connect(ui->editor_shadeConfidence, &QAction::triggered, ui->m_editor, &Editor::useConfidenceShading);
+    connect(ui->editor_showChanges, &QAction::triggered, ui->m_editor, &Editor::showChanges);
+    connect(ui->editor_nextChange, &QAction::triggered, ui->m_editor, &Editor::nextChange);
+    connect(ui->editor_previousChange, &QAction::triggered, ui->m_editor, &Editor::previousChange);
+    connect(ui->editor_confidenceThreshold, &QAction::triggered, this, [this]() {
+        bool ok{false};
+        auto threshold = QInputDialog::getDouble(this, "Confidence Threshold", "Words below this confidence are queued for review:",
+                                                 ui->m_editor->confidenceThreshold(), 0, 1, 2, &ok);
+        if (ok)
+            ui->m_editor->setConfidenceThreshold(threshold);
+    });
+    connect(ui->editor_alignWords, &QAction::triggered, ui->m_editor, [&]() {ui->m_editor->alignMissingTimeStamps(ui->m_waveform->pyramid());});
     connect(ui->editor_autoSave, &QAction::triggered, ui->m_editor, [this](){ui->m_editor->useAutoSave(ui->editor_autoSave->isChecked());});
     connect(ui->m_editor, &Editor::message, this->statusBar(), &QStatusBar::showMessage);
-    connect(ui->m_editor, &Editor::jumpToPlayer, player, &MediaPlayer::setPositionToTime);
+    connect(ui->m_editor, &Editor::jumpToPlayer, player, &MediaPlayer::seekTo);
     connect(ui->m_editor, &Editor::refreshTagList, ui->m_tagListDisplay, &TagListDisplayWidget::refreshTags);
 
-    auto useTransliterationMenu = new QMenu("Use Transliteration", ui->menuEditor);
-    auto group = new QActionGroup(this);
-    auto langs = m_transliterationLang.keys();
-
-    auto none = new QAction("None");
-    none->setActionGroup(group);
-    none->setCheckable(true);
-    none->setChecked(true);
-    none->setActionGroup(group);
-    useTransliterationMenu->addAction(none);
-
-    for(int i = 0; i < langs.size(); i++) {
-        auto action = new QAction(langs[i]);
-        action->setCheckable(true);
-        action->setActionGroup(group);
-        useTransliterationMenu->addAction(action);
-    }
-    group->setExclusive(true);
-    ui->menuEditor->addMenu(useTransliterationMenu);
-
-    connect(group, &QActionGroup::triggered, this, &Tool::transliterationSelected);
+    // Connect transcript tabs, they share the editor and the player
+    workspace = new TranscriptWorkspace(ui->m_editor, player, this);
+    ui->verticalLayout->insertWidget(0, workspace->tabBar());
 
+    connect(ui->editor_openInTabs, &QAction::triggered, workspace, &TranscriptWorkspace::openTranscripts);
+    connect(ui->editor_nextTab, &QAction::triggered, workspace, [&]() {workspace->activate((workspace->tabBar()->currentIndex() + 1) % workspace->count());});
+    connect(ui->editor_previousTab, &QAction::triggered, workspace, [&]() {workspace->activate((workspace->tabBar()->currentIndex() + workspace->count() - 1) % workspace->count());});
+    connect(workspace, &TranscriptWorkspace::message, this->statusBar(), &QStatusBar::showMessage);
 
     // Connect keyboard shortcuts guide to help action
     connect(ui->help_keyboardShortcuts, &QAction::triggered, this, &Tool::createKeyboardShortcutGuide);
 
     // Connect position slider change to player position
-    connect(ui->slider_position, &QSlider::sliderMoved, player, &MediaPlayer::setPosition);
+    connect(ui->slider_position, &QSlider::sliderMoved, player, &MediaPlayer::seekTo);
 
-    font = QFont( "Monospace", 10 );
+    font = QFont(m_session.fontFamily.isEmpty() ? "Monospace" : m_session.fontFamily,
+                 m_session.fontSize > 0 ? m_session.fontSize : 10);
     setFontForElements();
 }
 
 Tool::~Tool()
 {
+    CorrectedWordStore::compactAll();
     delete player;
     delete ui;
 }
@@ -220,6 +323,172 @@ void Tool::setTransliterationLangCodes()
         m_transliterationLang.insert(languages[i], langCodes[i]);
 }
 
+void Tool::createLoopMenus()
+{
+    auto preRollMenu = new QMenu("Loop Pre-roll", ui->menuMedia_Player);
+    auto preRollGroup = new QActionGroup(this);
+    for (auto preRoll: {0, 500, 1000, 2000}) {
+        auto action = preRollMenu->addAction(QString("%1 s").arg(preRoll / 1000.0));
+        action->setCheckable(true);
+        action->setChecked(preRoll == 0);
+        action->setActionGroup(preRollGroup);
+        connect(action, &QAction::triggered, segmentLooper, [this, preRoll]() {segmentLooper->setPreRoll(preRoll);});
+    }
+
+    auto rateMenu = new QMenu("Loop Rate", ui->menuMedia_Player);
+    auto rateGroup = new QActionGroup(this);
+    for (auto rate: {1.0, 0.75, 0.5}) {
+        auto action = rateMenu->addAction(QString("%1x").arg(rate));
+        action->setCheckable(true);
+        action->setChecked(rate == 1.0);
+        action->setActionGroup(rateGroup);
+        connect(action, &QAction::triggered, segmentLooper, [this, rate]() {segmentLooper->setRate(rate);});
+    }
+
+    ui->menuMedia_Player->insertMenu(ui->player_syncStatistics, preRollMenu);
+    ui->menuMedia_Player->insertMenu(ui->player_syncStatistics, rateMenu);
+    ui->menuMedia_Player->insertSeparator(ui->player_syncStatistics);
+}
+
+void Tool::createTransliterationMenu()
+{
+    auto useTransliterationMenu = new QMenu("Use Transliteration", ui->menuEditor);
+    m_transliterationGroup = new QActionGroup(this);
+    auto langs = m_transliterationLang.keys();
+
+    auto none = new QAction("None");
+    none->setCheckable(true);
+    none->setChecked(true);
+    none->setActionGroup(m_transliterationGroup);
+    useTransliterationMenu->addAction(none);
+
+    for(int i = 0; i < langs.size(); i++) {
+        auto action = new QAction(langs[i]);
+        action->setCheckable(true);
+        action->setActionGroup(m_transliterationGroup);
+        useTransliterationMenu->addAction(action);
+    }
+    m_transliterationGroup->setExclusive(true);
+    ui->menuEditor->addMenu(useTransliterationMenu);
+
+    connect(m_transliterationGroup, &QActionGroup::triggered, this, &Tool::transliterationSelected);
+}
+
+void Tool::createLexiconSync()
+{
+    // Share accepted words with the team lexicon
+    lexiconSync = new LexiconSync(this);
+
+    connect(ui->m_editor, &Editor::wordMarkedCorrect, lexiconSync, &LexiconSync::queueWord);
+    connect(DictionaryCache::instance(), &DictionaryCache::dictionaryLoaded, lexiconSync, &LexiconSync::pull);
+    connect(ui->editor_syncLexicon, &QAction::triggered, lexiconSync, &LexiconSync::syncAll);
+    connect(ui->editor_lexiconServer, &QAction::triggered, this, [this]() {
+        bool ok;
+        auto url = QInputDialog::getText(this, "Lexicon Server", "Server URL, empty to work offline:",
+                                         QLineEdit::Normal, lexiconSync->serverUrl().toString(), &ok);
+        if (ok)
+            lexiconSync->setServerUrl(QUrl::fromUserInput(url.trimmed()));
+    });
+    connect(lexiconSync, &LexiconSync::message, this->statusBar(), &QStatusBar::showMessage);
+}
+
+void Tool::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+    if (m_painted)
+        return;
+
+    m_painted = true;
+    qInfo() << "[Startup]" << QString("first paint after %1 ms").arg(QString::number(m_startupTimer.elapsed()));
+
+    // Queued behind the rest of the first frame
+    QTimer::singleShot(0, this, &Tool::initialiseDeferred);
+}
+
+void Tool::initialiseDeferred()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Warm the dictionaries of recently used languages
+    DictionaryCache::preloadRecent();
+
+    createLoopMenus();
+    createTransliterationMenu();
+    createLexiconSync();
+
+    auto logInteractive = [this, timer]() {
+        qInfo() << "[Startup]"
+                << QString("interactive after %1 ms, %2 ms of it deferred")
+                   .arg(QString::number(m_startupTimer.elapsed()), QString::number(timer.elapsed()));
+    };
+
+    // Counted up to the restored transcript being shown
+    if (restoreSession())
+        connect(workspace, &TranscriptWorkspace::sessionRestored, this, logInteractive);
+    else
+        logInteractive();
+}
+
+bool Tool::restoreSession()
+{
+    // Every saved tab comes back, the current one is read on a worker thread
+    Session::Tab tab;
+    auto reading = workspace->restoreTabs(m_session.tabs, m_session.currentTab, tab);
+
+    auto mediaUrl = tab.mediaUrl;
+    if (mediaUrl.isLocalFile() && QFileInfo::exists(mediaUrl.toLocalFile()))
+        player->load(mediaUrl, tab.mediaPosition);
+
+    if (!reading)
+        ui->m_editor->loadDictionary();
+
+    if (!m_session.transliteration.isEmpty()) {
+        for (auto action: m_transliterationGroup->actions()) {
+            if (action->text() == m_session.transliteration) {
+                action->trigger();
+                break;
+            }
+        }
+    }
+
+    return reading;
+}
+
+void Tool::saveSession()
+{
+    // Closed before the last session was restored, keep that one
+    if (!m_transliterationGroup)
+        return;
+
+    m_session.tabs = workspace->sessionTabs(m_session.currentTab);
+    m_session.fontFamily = font.family();
+    m_session.fontSize = font.pointSize();
+
+    auto checked = m_transliterationGroup->checkedAction();
+    m_session.transliteration = (checked && checked->text() != "None") ? checked->text() : QString();
+
+    m_session.save();
+}
+
+void Tool::closeEvent(QCloseEvent *event)
+{
+    saveSession();
+    QMainWindow::closeEvent(event);
+}
+
+void Tool::loopBlock(int blockNumber)
+{
+    qint64 start, end;
+    if (ui->m_editor->blockSpan(blockNumber, start, end))
+        segmentLooper->setSegment(start, end);
+    else {
+        segmentLooper->clearSegment();
+        if (segmentLooper->isEnabled())
+            statusBar()->showMessage("Line has no timestamp to loop", 2000);
+    }
+}
+
 void Tool::transliterationSelected(QAction* action)
 {
     if (action->text() == "None") {
@@ -2,7 +2,15 @@
 
 #include <QMainWindow>
 #include "mediaplayer/mediaplayer.h"
+#include "mediaplayer/playbacksync.h"
+#include "mediaplayer/segmentlooper.h"
 #include "editor/texteditor.h"
+#include "editor/transcriptworkspace.h"
+#include "editor/lexiconsync.h"
+#include "session.h"
+
+#include <QElapsedTimer>
+#include <QActionGroup>
 
 
 QT_BEGIN_NAMESPACE
@@ -17,8 +25,13 @@ public:
     explicit Tool(QWidget *parent = nullptr);
     ~Tool() final;
 
+    // Running since the process started, for the startup times in the log
+    void setStartupTimer(const QElapsedTimer& timer) {m_startupTimer = timer;}
+
 protected:
     void keyPressEvent(QKeyEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void closeEvent(QCloseEvent *event) override;
 
 private slots:
     void handleMediaPlayerError();
@@ -26,13 +39,28 @@ private slots:
     void changeFont();
     void changeFontSize(int change);
     void transliterationSelected(QAction* action);
+    void loopBlock(int blockNumber);
+    void initialiseDeferred();
 
 private:
     void setFontForElements();
     void setTransliterationLangCodes();
+    void createLoopMenus();
+    void createTransliterationMenu();
+    void createLexiconSync();
+    bool restoreSession();
+    void saveSession();
 
     MediaPlayer *player = nullptr;
+    PlaybackSync *playbackSync = nullptr;
+    SegmentLooper *segmentLooper = nullptr;
+    TranscriptWorkspace *workspace = nullptr;
+    LexiconSync *lexiconSync = nullptr;
     Ui::Tool *ui;
     QFont font;
     QMap<QString, QString> m_transliterationLang;
+    QActionGroup *m_transliterationGroup = nullptr;
+    Session m_session;
+    QElapsedTimer m_startupTimer;
+    bool m_painted{false};
 };
@@ -0,0 +1,172 @@
+#include "editor/transcriptimporter.h"
+#include "editor/transcriptexporter.h"
+#include "editor/blocktimeindex.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <limits>
+
+// Throughput of every importer on a synthetic multi-hour recording. The CTM,
+// SRT and WebVTT samples come from the exporters, the ASR JSON one is laid out
+// the way Whisper style engines write it and is also timed through
+// QJsonDocument for comparison. Every import is checked for the word count,
+// and CTM and JSON for every word's end time.
+
+namespace {
+    const QStringList vocabulary{
+        "the", "meeting", "will", "start", "at", "nine", "and", "we", "discuss", "budget",
+        QString::fromUtf8("नमस्ते"), QString::fromUtf8("भारत"), QString::fromUtf8("सरकार"), "R&D"
+    };
+
+    QVector<block> makeBlocks(int hours)
+    {
+        QRandomGenerator random(42);
+        qint64 position{0};
+        QVector<block> blocks;
+
+        while (position < hours * 3600000LL) {
+            block line;
+            line.speaker = QString("Speaker_%1").arg(random.bounded(4));
+            QStringList text;
+            for (int j = 4 + random.bounded(12); j > 0; j--) {
+                position += 150 + random.bounded(400);
+                word a_word = {BlockTimeIndex::toTime(position), vocabulary[random.bounded(vocabulary.size())], QStringList()};
+                a_word.confidence = random.bounded(1000) / 1000.0;
+                text << a_word.text;
+                line.words.append(a_word);
+            }
+            line.timeStamp = line.words.constLast().timeStamp;
+            line.text = text.join(" ");
+            blocks.append(line);
+
+            // Pauses between lines, a line starts where the last one ended
+            position += random.bounded(1500);
+        }
+        return blocks;
+    }
+
+    QByteArray asrJson(const QVector<block>& blocks)
+    {
+        QJsonArray segments;
+        qint64 start{0};
+        for (auto& line: blocks) {
+            QJsonArray words;
+            for (auto& a_word: line.words) {
+                auto end = BlockTimeIndex::toPosition(a_word.timeStamp);
+                words.append(QJsonObject{{"word", " " + a_word.text}, {"start", start / 1000.0},
+                                         {"end", end / 1000.0}, {"probability", a_word.confidence}});
+                start = end;
+            }
+            segments.append(QJsonObject{{"speaker", line.speaker}, {"text", line.text},
+                                        {"end", BlockTimeIndex::toPosition(line.timeStamp) / 1000.0}, {"words", words}});
+        }
+        return QJsonDocument(QJsonObject{{"language", "en"}, {"segments", segments}}).toJson(QJsonDocument::Compact);
+    }
+
+    QByteArray exported(TranscriptExporter::Format format, const QVector<block>& blocks)
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        TranscriptExporter::write(&buffer, format, blocks, SubtitleOptions(), "sample");
+        return data;
+    }
+
+    int wordCount(const QVector<block>& blocks)
+    {
+        int count{0};
+        for (auto& line: blocks)
+            count += line.words.size();
+        return count;
+    }
+
+    bool sameEndTimes(const QVector<block>& imported, const QVector<block>& blocks)
+    {
+        QVector<QTime> expected, actual;
+        for (auto& line: blocks)
+            for (auto& a_word: line.words)
+                expected << a_word.timeStamp;
+        for (auto& line: imported)
+            for (auto& a_word: line.words)
+                actual << a_word.timeStamp;
+        return actual == expected;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Importer throughput on a synthetic multi-hour recording");
+    parser.addHelpOption();
+    QCommandLineOption hoursOption("hours", "Length of the recording.", "hours", "8");
+    QCommandLineOption runsOption("runs", "Runs per measurement, the fastest is reported.", "count", "3");
+    parser.addOptions({hoursOption, runsOption});
+    parser.process(a);
+
+    auto runs = qMax(parser.value(runsOption).toInt(), 1);
+    auto blocks = makeBlocks(qMax(parser.value(hoursOption).toInt(), 1));
+    auto words = wordCount(blocks);
+    QTextStream out(stdout);
+    out << QString("%1 hours, %2 lines, %3 words\n").arg(parser.value(hoursOption)).arg(blocks.size()).arg(words);
+
+    struct Sample
+    {
+        QString name;
+        QByteArray data;
+        TranscriptImporter::Parser parse;
+        bool exactTimes;
+    };
+    const QVector<Sample> samples{
+        {"CTM", exported(TranscriptExporter::Ctm, blocks), &TranscriptImporter::parseCtm, true},
+        {"SRT", exported(TranscriptExporter::SubRip, blocks), &TranscriptImporter::parseSubtitles, false},
+        {"WebVTT", exported(TranscriptExporter::WebVtt, blocks), &TranscriptImporter::parseSubtitles, false},
+        {"ASR JSON", asrJson(blocks), &TranscriptImporter::parseAsrJson, true},
+    };
+
+    QElapsedTimer timer;
+    bool ok{true};
+    for (auto& sample: samples) {
+        qint64 best{std::numeric_limits<qint64>::max()};
+        TranscriptData transcript;
+        for (int run = 0; run < runs; run++) {
+            timer.start();
+            transcript = sample.parse(sample.data);
+            best = qMin(best, timer.nsecsElapsed());
+        }
+
+        auto imported = wordCount(transcript.blocks);
+        auto valid = imported == words && (!sample.exactTimes || sameEndTimes(transcript.blocks, blocks));
+        ok = ok && valid;
+        out << QString("%1 %2 MB in %3 ms, %4 MB/s, %5 Mwords/s, %6 lines%7\n")
+               .arg(sample.name, -9)
+               .arg(sample.data.size() / (1024.0 * 1024.0), 6, 'f', 1)
+               .arg(best / 1e6, 0, 'f', 1)
+               .arg(sample.data.size() / (1024.0 * 1024.0) / (qMax<qint64>(best, 1) / 1e9), 0, 'f', 0)
+               .arg(imported / (qMax<qint64>(best, 1) / 1e9) / 1e6, 0, 'f', 2)
+               .arg(transcript.blocks.size())
+               .arg(valid ? "" : QString(", %1 of %2 words, MISMATCH").arg(imported).arg(words));
+    }
+
+    // What the same JSON costs only to become a document, before any blocks
+    auto& json = samples.constLast().data;
+    qint64 best{std::numeric_limits<qint64>::max()};
+    for (int run = 0; run < runs; run++) {
+        timer.start();
+        auto document = QJsonDocument::fromJson(json);
+        best = qMin(best, timer.nsecsElapsed());
+        if (document.isNull())
+            ok = false;
+    }
+    out << QString("%1 %2 ms, document only\n").arg("QJsonDoc", -9).arg(best / 1e6, 0, 'f', 1);
+
+    return ok ? 0 : 1;
+}
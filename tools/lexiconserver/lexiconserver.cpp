@@ -0,0 +1,201 @@
+#include "lexiconserver.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+namespace {
+    const int maxRequestSize = 4 * 1024 * 1024;
+
+    QByteArray reasonPhrase(int status)
+    {
+        switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        default: return "Internal Server Error";
+        }
+    }
+}
+
+LexiconServer::LexiconServer(const QString& storeFileName, QObject *parent)
+    : QObject(parent), m_storeFileName(storeFileName)
+{
+    load();
+
+    connect(&m_server, &QTcpServer::newConnection, this, [this] {
+        while (auto socket = m_server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] {readRequest(socket);});
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    });
+}
+
+bool LexiconServer::listen(const QHostAddress& address, quint16 port)
+{
+    if (!m_server.listen(address, port)) {
+        qWarning() << "[Lexicon Server]" << m_server.errorString();
+        return false;
+    }
+
+    qInfo() << "[Lexicon Server]"
+            << QString("listening on %1:%2, version %3").arg(address.toString(), QString::number(port), QString::number(m_version));
+    return true;
+}
+
+void LexiconServer::readRequest(QTcpSocket* socket)
+{
+    // Requests are small, wait until the headers and the whole body are in
+    auto buffer = socket->peek(socket->bytesAvailable());
+    auto headerEnd = buffer.indexOf("\r\n\r\n");
+
+    Response response;
+    QByteArray method, target;
+
+    if (headerEnd < 0 && buffer.size() <= maxRequestSize)
+        return;
+
+    if (headerEnd < 0) {
+        response = {413, {}};
+    }
+    else {
+        auto lines = buffer.left(headerEnd).split('\n');
+        auto requestLine = lines.takeFirst().trimmed().split(' ');
+
+        qint64 contentLength{0};
+        for (auto& a_line: qAsConst(lines)) {
+            auto separator = a_line.indexOf(':');
+            if (separator > 0 && a_line.left(separator).trimmed().toLower() == "content-length")
+                contentLength = a_line.mid(separator + 1).trimmed().toLongLong();
+        }
+
+        if (contentLength > maxRequestSize) {
+            response = {413, {}};
+        }
+        else if (buffer.size() < headerEnd + 4 + contentLength) {
+            return;
+        }
+        else if (requestLine.size() < 2) {
+            response = {400, {}};
+        }
+        else {
+            method = requestLine[0];
+            target = requestLine[1];
+            response = handle(method, QString::fromUtf8(target), buffer.mid(headerEnd + 4, contentLength));
+        }
+    }
+
+    socket->readAll();
+    qInfo() << "[Lexicon Server]" << QString("%1 %2 -> %3").arg(QString(method), QString(target), QString::number(response.status));
+
+    QByteArray reply = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n"
+                       "Content-Type: application/json\r\n"
+                       "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + response.body;
+
+    socket->write(reply);
+    socket->disconnectFromHost();
+}
+
+LexiconServer::Response LexiconServer::handle(const QByteArray& method, const QString& target, const QByteArray& body)
+{
+    QUrl url(target);
+    auto path = url.path().split('/', Qt::SkipEmptyParts);
+
+    if (path.size() != 2 || path[0] != "lexicon")
+        return {404, {}};
+
+    auto lang = path[1];
+    if (method == "GET")
+        return words(lang, QUrlQuery(url).queryItemValue("since").toLongLong());
+    if (method == "POST")
+        return addWords(lang, body);
+
+    return {400, {}};
+}
+
+LexiconServer::Response LexiconServer::words(const QString& lang, qint64 since) const
+{
+    QJsonArray words;
+    auto lexicon = m_lexicons.value(lang);
+    for (auto it = lexicon.constBegin(); it != lexicon.constEnd(); ++it)
+        if (it.value() > since)
+            words.append(it.key());
+
+    QJsonObject response{{"version", double(m_version)}, {"words", words}};
+    return {200, QJsonDocument(response).toJson(QJsonDocument::Compact)};
+}
+
+LexiconServer::Response LexiconServer::addWords(const QString& lang, const QByteArray& body)
+{
+    QJsonParseError error;
+    auto request = QJsonDocument::fromJson(body, &error);
+    if (error.error != QJsonParseError::NoError || !request.isObject())
+        return {400, {}};
+
+    auto& lexicon = m_lexicons[lang];
+    int added{0};
+    for (auto a_word: request.object()["words"].toArray()) {
+        auto word = a_word.toString().trimmed();
+        if (word.isEmpty() || lexicon.contains(word))
+            continue;
+
+        if (!added)
+            m_version++;
+        lexicon.insert(word, m_version);
+        added++;
+    }
+
+    if (added) {
+        if (!save())
+            qWarning() << "[Lexicon Server]" << QString("couldn't save %1").arg(m_storeFileName);
+        qInfo() << "[Lexicon Server]" << QString("language: %1, %2 words added, version %3").arg(lang, QString::number(added), QString::number(m_version));
+    }
+
+    QJsonObject response{{"version", double(m_version)}};
+    return {200, QJsonDocument(response).toJson(QJsonDocument::Compact)};
+}
+
+void LexiconServer::load()
+{
+    QFile store(m_storeFileName);
+    if (!store.open(QFile::ReadOnly))
+        return;
+
+    auto saved = QJsonDocument::fromJson(store.readAll()).object();
+    m_version = qint64(saved["version"].toDouble());
+
+    auto lexicons = saved["lexicons"].toObject();
+    for (auto it = lexicons.constBegin(); it != lexicons.constEnd(); ++it) {
+        auto& lexicon = m_lexicons[it.key()];
+        auto words = it.value().toObject();
+        for (auto word = words.constBegin(); word != words.constEnd(); ++word)
+            lexicon.insert(word.key(), qint64(word.value().toDouble()));
+    }
+}
+
+bool LexiconServer::save() const
+{
+    QJsonObject lexicons;
+    for (auto it = m_lexicons.constBegin(); it != m_lexicons.constEnd(); ++it) {
+        QJsonObject words;
+        for (auto word = it.value().constBegin(); word != it.value().constEnd(); ++word)
+            words.insert(word.key(), double(word.value()));
+        lexicons.insert(it.key(), words);
+    }
+
+    QJsonObject saved{{"version", double(m_version)}, {"lexicons", lexicons}};
+
+    QSaveFile store(m_storeFileName);
+    if (!store.open(QFile::WriteOnly))
+        return false;
+
+    store.write(QJsonDocument(saved).toJson());
+    return store.commit();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QMap>
+
+// Minimal stand-in for the team lexicon service, enough for a handful of
+// editors on one network. Every accepted word is stored with the version it
+// was added at, so clients can ask for the words newer than what they have.
+//
+//   GET  /lexicon/<lang>?since=<version>  -> {"version": n, "words": [...]}
+//   POST /lexicon/<lang>  {"words": [...]} -> {"version": n}
+class LexiconServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LexiconServer(const QString& storeFileName, QObject *parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+
+private:
+    struct Response
+    {
+        int status{500};
+        QByteArray body;
+    };
+
+    void readRequest(QTcpSocket* socket);
+    Response handle(const QByteArray& method, const QString& target, const QByteArray& body);
+    Response words(const QString& lang, qint64 since) const;
+    Response addWords(const QString& lang, const QByteArray& body);
+
+    void load();
+    bool save() const;
+
+    QTcpServer m_server;
+    QString m_storeFileName;
+    qint64 m_version{0};
+    QHash<QString, QMap<QString, qint64>> m_lexicons;
+};
@@ -0,0 +1,27 @@
+#include "lexiconserver.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("lexicon-server");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Shared lexicon of accepted words for the editor");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption("port", "Port to listen on.", "port", "8765");
+    QCommandLineOption storeOption("store", "File the lexicon is kept in.", "file", "lexicon-server.json");
+    QCommandLineOption anyAddressOption("any", "Listen on every interface instead of localhost only.");
+    parser.addOptions({portOption, storeOption, anyAddressOption});
+    parser.process(a);
+
+    LexiconServer server(parser.value(storeOption));
+    auto address = parser.isSet(anyAddressOption) ? QHostAddress::Any : QHostAddress::LocalHost;
+    if (!server.listen(QHostAddress(address), parser.value(portOption).toUShort()))
+        return 1;
+
+    return a.exec();
+}
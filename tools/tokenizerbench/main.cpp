@@ -0,0 +1,136 @@
+#include "editor/tokenizer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <algorithm>
+
+// Compares the shared tokenizer with the split(" ") and strip-one-character
+// normalisation it replaced, on a synthetic Hindi and Gujarati transcript
+// with the variants real ASR output and pasted text contain.
+
+namespace {
+    const QStringList hindiWords{
+        QString::fromUtf8("नमस्ते"), QString::fromUtf8("क़िला"), QString::fromUtf8("ज़िंदगी"),
+        QString::fromUtf8("पढ़ाई"), QString::fromUtf8("क्षेत्र"), QString::fromUtf8("श्री"),
+        QString::fromUtf8("भारत"), QString::fromUtf8("सरकार"), QString::fromUtf8("विद्यालय")
+    };
+    const QStringList gujaratiWords{
+        QString::fromUtf8("નમસ્તે"), QString::fromUtf8("ગુજરાત"), QString::fromUtf8("શાળા"),
+        QString::fromUtf8("ક્ષેત્ર"), QString::fromUtf8("વિદ્યાર્થી"), QString::fromUtf8("સરકાર")
+    };
+
+    const QChar zeroWidthJoiner(0x200D), danda(0x0964);
+
+    QString variant(const QString& word, QRandomGenerator& random)
+    {
+        switch (random.bounded(5)) {
+        case 0: return word.normalized(QString::NormalizationForm_D);
+        case 1: {
+            // Joiner after the first virama, as some keyboards insert it
+            auto withJoiner = word;
+            auto virama = withJoiner.indexOf(QChar(0x094D));
+            if (virama < 0)
+                virama = withJoiner.indexOf(QChar(0x0ACD));
+            if (virama >= 0)
+                withJoiner.insert(virama + 1, zeroWidthJoiner);
+            return withJoiner;
+        }
+        default: return word;
+        }
+    }
+
+    QStringList makeTranscript(int wordCount, QStringList& dictionary)
+    {
+        QRandomGenerator random(42);
+        auto vocabulary = hindiWords + gujaratiWords;
+
+        for (auto& a_word: qAsConst(vocabulary))
+            dictionary << Tokenizer::canonical(a_word);
+        std::sort(dictionary.begin(), dictionary.end());
+
+        QStringList lines;
+        QString line;
+        for (int i = 0; i < wordCount; i++) {
+            line += variant(vocabulary[random.bounded(vocabulary.size())], random);
+
+            if (random.bounded(12) == 0) {
+                line += " " + QString(danda);
+                lines << line;
+                line.clear();
+            }
+            else
+                line += random.bounded(20) ? " " : "  ";
+        }
+        if (!line.isEmpty())
+            lines << line;
+
+        return lines;
+    }
+
+    QString oldNormalized(const QString& text)
+    {
+        static const QString punctuation(",.!;:");
+        auto wordText = text.toLower();
+        if (wordText != "" && punctuation.contains(wordText.back()))
+            wordText = wordText.left(wordText.size() - 1);
+        return wordText;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Tokenizer benchmark on a synthetic Indic transcript");
+    parser.addHelpOption();
+    QCommandLineOption wordsOption("words", "Number of words in the transcript.", "count", "100000");
+    QCommandLineOption langOption("lang", "Language whose punctuation is used.", "lang", "hindi");
+    parser.addOptions({wordsOption, langOption});
+    parser.process(a);
+
+    QStringList dictionary;
+    auto lines = makeTranscript(parser.value(wordsOption).toInt(), dictionary);
+    auto contains = [&dictionary](const QString& word) {
+        return std::binary_search(dictionary.begin(), dictionary.end(), word);
+    };
+
+    QTextStream out(stdout);
+    out << lines.size() << " lines\n";
+
+    QElapsedTimer timer;
+    int tokens{0}, flagged{0};
+
+    timer.start();
+    for (auto& a_line: qAsConst(lines)) {
+        for (auto& a_word: a_line.split(" ")) {
+            tokens++;
+            if (!contains(oldNormalized(a_word)))
+                flagged++;
+        }
+    }
+    out << QString("split(\" \"):  %1 ms, %2 tokens, %3 flagged\n")
+           .arg(QString::number(timer.elapsed()), QString::number(tokens), QString::number(flagged));
+
+    Tokenizer tokenizer(parser.value(langOption));
+    tokens = flagged = 0;
+
+    timer.restart();
+    for (auto& a_line: qAsConst(lines)) {
+        for (auto& span: Tokenizer::spans(a_line)) {
+            auto wordText = tokenizer.normalized(a_line.mid(span.start, span.length));
+            if (wordText.isEmpty())
+                continue;
+            tokens++;
+            if (!contains(wordText))
+                flagged++;
+        }
+    }
+    out << QString("Tokenizer:   %1 ms, %2 tokens, %3 flagged\n")
+           .arg(QString::number(timer.elapsed()), QString::number(tokens), QString::number(flagged));
+
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include "editor/transcriptreader.h"
+#include "editor/transcriptwriter.h"
+#include "editor/gzipdevice.h"
+#include "editor/transcriptcache.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThread>
+#include <limits>
+
+// Load time of the sequential reader against the chunked parallel one, and
+// save throughput of QXmlStreamWriter against TranscriptWriter, for 1 to 16
+// threads on a synthetic transcript. Every parallel result is checked against
+// the sequential one, byte for byte when saving. Last, opening the file plain
+// and gzip compressed is timed on a disk limited to a few MB/s, and so is
+// reopening it from the transcript cache.
+
+namespace {
+    const QStringList vocabulary{
+        "the", "meeting", "will", "start", "at", "nine", "and", "we", "discuss", "budget",
+        QString::fromUtf8("नमस्ते"), QString::fromUtf8("भारत"), QString::fromUtf8("सरकार"),
+        "R&D", "<unk>", "\"quoted\""
+    };
+
+    QVector<block> makeBlocks(int lineCount)
+    {
+        QRandomGenerator random(42);
+        QTime time(0, 0);
+        QVector<block> blocks;
+        blocks.reserve(lineCount);
+
+        for (int i = 0; i < lineCount; i++) {
+            auto wordCount = 4 + random.bounded(12);
+            auto lineStart = time;
+            time = time.addMSecs(300 * wordCount);
+
+            block line = {time, "", QString("Speaker_%1").arg(random.bounded(4)), QStringList(), QVector<word>()};
+            if (!random.bounded(10))
+                line.tagList = QStringList{"music", "noise"};
+            if (random.bounded(2))
+                line.confidence = random.bounded(1000) / 1000.0;
+
+            QStringList text;
+            for (int j = 0; j < wordCount; j++) {
+                word a_word = {lineStart.addMSecs(300 * (j + 1)), vocabulary[random.bounded(vocabulary.size())], QStringList()};
+                if (!random.bounded(50))
+                    a_word.tagList = QStringList{"foreign"};
+                if (random.bounded(3))
+                    a_word.confidence = random.bounded(1000) / 1000.0;
+                text << a_word.text;
+                line.words.append(a_word);
+            }
+            line.text = text.join(" ");
+            blocks.append(line);
+        }
+        return blocks;
+    }
+
+    // Reads another device no faster than a slow network share would
+    class ThrottledDevice : public QIODevice
+    {
+    public:
+        ThrottledDevice(QIODevice* device, double bytesPerSecond)
+            : m_device(device), m_bytesPerSecond(bytesPerSecond)
+        {
+            open(QIODevice::ReadOnly);
+            m_clock.start();
+        }
+
+        bool isSequential() const override {return true;}
+        bool atEnd() const override {return QIODevice::atEnd() && m_device->atEnd();}
+
+    protected:
+        qint64 readData(char* data, qint64 maxSize) override
+        {
+            auto bytesRead = m_device->read(data, maxSize);
+            if (bytesRead > 0 && m_bytesPerSecond > 0) {
+                m_bytesRead += bytesRead;
+                auto due = qint64(m_bytesRead * 1000 / m_bytesPerSecond);
+                if (due > m_clock.elapsed())
+                    QThread::msleep(quint64(due - m_clock.elapsed()));
+            }
+            return bytesRead;
+        }
+
+        qint64 writeData(const char*, qint64) override {return -1;}
+
+    private:
+        QIODevice* m_device;
+        double m_bytesPerSecond;
+        qint64 m_bytesRead{0};
+        QElapsedTimer m_clock;
+    };
+
+    double megabytesPerSecond(qint64 bytes, qint64 nsecs)
+    {
+        return bytes / (1024.0 * 1024.0) / (qMax<qint64>(nsecs, 1) / 1e9);
+    }
+
+    // operator== leaves out tags and confidences
+    bool identical(const TranscriptData& a, const TranscriptData& b)
+    {
+        if (a.lang != b.lang || a.blocks.size() != b.blocks.size())
+            return false;
+
+        for (int i = 0; i < a.blocks.size(); i++) {
+            auto& x = a.blocks[i];
+            auto& y = b.blocks[i];
+            if (!(x == y) || x.tagList != y.tagList || x.confidence != y.confidence)
+                return false;
+            for (int j = 0; j < x.words.size(); j++)
+                if (x.words[j].tagList != y.words[j].tagList || x.words[j].confidence != y.words[j].confidence)
+                    return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Transcript load and save benchmark on a synthetic transcript");
+    parser.addHelpOption();
+    QCommandLineOption linesOption("lines", "Number of lines in the transcript.", "count", "300000");
+    QCommandLineOption runsOption("runs", "Runs per measurement, the fastest is reported.", "count", "3");
+    QCommandLineOption diskOption("disk-mbps", "Read rate of the simulated slow disk, 0 for no limit.", "MB/s", "20");
+    parser.addOptions({linesOption, runsOption, diskOption});
+    parser.process(a);
+
+    auto runs = qMax(parser.value(runsOption).toInt(), 1);
+    QTextStream out(stdout);
+
+    QTemporaryFile file;
+    if (!file.open()) {
+        out << file.errorString() << "\n";
+        return 1;
+    }
+    auto blocks = makeBlocks(parser.value(linesOption).toInt());
+    TranscriptWriter::writeReference(&file, "english", blocks);
+    file.flush();
+    out << QString("%1 lines, %2 MB\n")
+           .arg(parser.value(linesOption), QString::number(file.size() / (1024.0 * 1024.0), 'f', 1));
+
+    QElapsedTimer timer;
+    TranscriptData expected;
+    qint64 sequential{std::numeric_limits<qint64>::max()};
+    for (int run = 0; run < runs; run++) {
+        file.seek(0);
+        timer.start();
+        expected = TranscriptReader::readSequential(&file);
+        sequential = qMin(sequential, timer.elapsed());
+    }
+    out << QString("sequential:  %1 ms\n").arg(sequential);
+
+    for (int threads: {1, 2, 4, 8, 16}) {
+        qint64 best{std::numeric_limits<qint64>::max()};
+        bool ok{true};
+        for (int run = 0; run < runs && ok; run++) {
+            TranscriptData transcript;
+            timer.start();
+            ok = TranscriptReader::readParallel(file, threads, transcript);
+            best = qMin(best, timer.elapsed());
+            ok = ok && identical(transcript, expected);
+        }
+
+        if (!ok) {
+            out << QString("%1 threads: results differ from the sequential reader\n").arg(threads, 2);
+            return 1;
+        }
+        out << QString("%1 threads:  %2 ms, %3x\n")
+               .arg(threads, 2).arg(best).arg(double(sequential) / qMax<qint64>(best, 1), 0, 'f', 2);
+    }
+
+    file.seek(0);
+    auto reference = file.readAll();
+    qint64 referenceTime{std::numeric_limits<qint64>::max()};
+    for (int run = 0; run < runs; run++) {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        timer.start();
+        TranscriptWriter::writeReference(&buffer, "english", blocks);
+        referenceTime = qMin(referenceTime, timer.nsecsElapsed());
+    }
+    out << QString("QXmlStreamWriter:  %1 MB/s\n")
+           .arg(megabytesPerSecond(reference.size(), referenceTime), 0, 'f', 1);
+
+    for (int threads: {1, 2, 4, 8, 16}) {
+        qint64 best{std::numeric_limits<qint64>::max()};
+        bool ok{true};
+        for (int run = 0; run < runs && ok; run++) {
+            timer.start();
+            auto xml = TranscriptWriter::toXml("english", blocks, threads);
+            best = qMin(best, timer.nsecsElapsed());
+            ok = xml == reference;
+        }
+
+        if (!ok) {
+            out << QString("%1 threads: output differs from QXmlStreamWriter\n").arg(threads, 2);
+            return 1;
+        }
+        out << QString("%1 threads:  %2 MB/s\n")
+               .arg(threads, 2).arg(megabytesPerSecond(reference.size(), best), 0, 'f', 1);
+    }
+
+    QTemporaryFile compressedFile;
+    if (!compressedFile.open()) {
+        out << compressedFile.errorString() << "\n";
+        return 1;
+    }
+    {
+        GzipDevice gzip(&compressedFile);
+        gzip.open(QIODevice::WriteOnly);
+        gzip.write(reference);
+    }
+    compressedFile.flush();
+    out << QString("gzip:  %1 MB, %2% of the plain file\n")
+           .arg(compressedFile.size() / (1024.0 * 1024.0), 0, 'f', 1)
+           .arg(100.0 * compressedFile.size() / qMax(reference.size(), 1), 0, 'f', 1);
+
+    auto diskRate = parser.value(diskOption).toDouble();
+    for (bool compressed: {false, true}) {
+        auto& source = compressed ? compressedFile : file;
+        source.seek(0);
+        ThrottledDevice disk(&source, diskRate * 1024 * 1024);
+
+        timer.start();
+        auto transcript = compressed ? TranscriptReader::readCompressed(&disk) : TranscriptReader::readSequential(&disk);
+        auto elapsed = timer.elapsed();
+
+        if (!identical(transcript, expected)) {
+            out << QString("%1 open: results differ from the plain file\n").arg(QString(compressed ? "gzip" : "plain"));
+            return 1;
+        }
+        out << QString("%1 open at %2 MB/s:  %3 ms\n")
+               .arg(QString(compressed ? "gzip " : "plain"), parser.value(diskOption)).arg(elapsed);
+    }
+
+    TranscriptSnapshot snapshot;
+    snapshot.transcript = expected;
+    QFileInfo info(file.fileName());
+    if (!TranscriptCache::store(file.fileName(), info.size(), info.lastModified(), snapshot)) {
+        out << "couldn't write to " << TranscriptCache::directory() << "\n";
+        return 1;
+    }
+
+    qint64 cacheTime{std::numeric_limits<qint64>::max()};
+    for (int run = 0; run < runs; run++) {
+        TranscriptSnapshot loaded;
+        timer.start();
+        auto hit = TranscriptCache::load(file.fileName(), loaded);
+        cacheTime = qMin(cacheTime, timer.elapsed());
+
+        if (!hit || !identical(loaded.transcript, expected)) {
+            out << "cached open: results differ from the plain file\n";
+            return 1;
+        }
+    }
+    QFile::remove(TranscriptCache::cacheFileName(QFileInfo(file.fileName())));
+    out << QString("cached open:  %1 ms\n").arg(cacheTime);
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "editor/transcriptexporter.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// Exports transcripts to subtitles or alignments without the GUI, one file
+// per core at a time, with the same segmentation as the Editor menu.
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Export transcripts to SRT, WebVTT, CTM or Praat TextGrid");
+    parser.addHelpOption();
+    QCommandLineOption formatOption("format", "One of " + TranscriptExporter::formatNames().join(", ") + ".", "format", "srt");
+    QCommandLineOption outputOption("output", "Directory the exports are written to.", "directory", ".");
+    QCommandLineOption charactersOption("max-chars", "Characters per subtitle line.", "count", "42");
+    QCommandLineOption linesOption("max-lines", "Lines per subtitle.", "count", "2");
+    QCommandLineOption durationOption("max-duration", "Seconds per subtitle.", "seconds", "7");
+    parser.addOptions({formatOption, outputOption, charactersOption, linesOption, durationOption});
+    parser.addPositionalArgument("transcripts", "Transcript files, plain or gzip compressed.", "<transcript>...");
+    parser.process(a);
+
+    QTextStream out(stdout);
+    TranscriptExporter::Format format;
+    if (!TranscriptExporter::formatOf(parser.value(formatOption), format)) {
+        out << QString("Unknown format %1\n").arg(parser.value(formatOption));
+        return 1;
+    }
+    if (parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    SubtitleOptions options;
+    options.maxLineLength = qMax(parser.value(charactersOption).toInt(), 1);
+    options.maxLines = qMax(parser.value(linesOption).toInt(), 1);
+    options.maxDuration = qMax<qint64>(qRound64(parser.value(durationOption).toDouble() * 1000), 1);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto files = parser.positionalArguments();
+    auto errors = TranscriptExporter::exportFiles(files, format, parser.value(outputOption), options);
+
+    for (auto& error: qAsConst(errors))
+        out << error << "\n";
+    out << QString("%1 of %2 files exported in %3 ms\n")
+           .arg(files.size() - errors.size()).arg(files.size()).arg(timer.elapsed());
+    return errors.isEmpty() ? 0 : 1;
+}
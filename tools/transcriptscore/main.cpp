@@ -0,0 +1,71 @@
+#include "editor/transcriptscorer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+// Scores ASR output against edited transcripts without the GUI. Given two
+// directories, transcripts are paired by name and scored one pair per core,
+// given two files just that pair. Prints WER and CER per file and for the
+// whole set, per speaker as CSV on request.
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("WER and CER of ASR output against edited transcripts");
+    parser.addHelpOption();
+    QCommandLineOption csvOption("csv", "Also write the counts per file and speaker to a CSV file.", "file");
+    parser.addOption(csvOption);
+    parser.addPositionalArgument("reference", "Edited transcript, or a directory of them.");
+    parser.addPositionalArgument("hypothesis", "ASR output, or a directory of it.");
+    parser.process(a);
+
+    auto arguments = parser.positionalArguments();
+    if (arguments.size() != 2)
+        parser.showHelp(1);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto reports = QFileInfo(arguments[0]).isDir()
+            ? TranscriptScorer::scoreDirectories(arguments[0], arguments[1])
+            : QVector<ScoreReport>{TranscriptScorer::scoreFiles(arguments[0], arguments[1])};
+
+    QTextStream out(stdout);
+    ScoreReport total;
+    QString csv = TranscriptScorer::csvHeader();
+    int failed{0};
+    for (auto& report: qAsConst(reports)) {
+        if (!report.error.isEmpty()) {
+            out << report.error << "\n";
+            failed++;
+            continue;
+        }
+
+        out << QString("%1  WER %2%  CER %3%  %4 words\n")
+               .arg(QFileInfo(report.reference).fileName(), -40)
+               .arg(report.overall.wer() * 100, 6, 'f', 2)
+               .arg(report.overall.cer() * 100, 6, 'f', 2)
+               .arg(report.overall.words);
+        for (auto speaker = report.speakers.constBegin(); speaker != report.speakers.constEnd(); ++speaker)
+            total.speakers[speaker.key()] += speaker.value();
+        total.overall += report.overall;
+        csv += TranscriptScorer::csvRows(report);
+    }
+
+    out << "\n" << TranscriptScorer::table(total)
+        << QString("%1 of %2 pairs scored in %3 ms\n").arg(reports.size() - failed).arg(reports.size()).arg(timer.elapsed());
+
+    if (parser.isSet(csvOption)) {
+        QSaveFile file(parser.value(csvOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(csv.toUtf8()) < 0 || !file.commit()) {
+            out << file.errorString() << "\n";
+            return 1;
+        }
+    }
+    return failed ? 1 : 0;
+}